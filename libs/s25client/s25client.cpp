@@ -15,19 +15,24 @@
 // You should have received a copy of the GNU General Public License
 // along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
 
+#include "BenchmarkScenarios.h"
 #include "Debug.h"
 #include "GameManager.h"
+#include "Loader.h"
 #include "QuickStartGame.h"
 #include "RTTR_AssertError.h"
 #include "RTTR_Version.h"
 #include "RttrConfig.h"
 #include "Settings.h"
 #include "SignalHandler.h"
+#include "TraceRecorder.h"
 #include "WindowManager.h"
 #include "commands.h"
+#include "desktops/dskBenchmark.h"
 #include "drivers/AudioDriverWrapper.h"
 #include "drivers/VideoDriverWrapper.h"
 #include "files.h"
+#include "gameData/ApplicationLoader.h"
 #include "helpers/format.hpp"
 #include "mygettext/mygettext.h"
 #include "ogl/glAllocator.h"
@@ -41,11 +46,14 @@
 #include <boost/nowide/args.hpp>
 #include <boost/nowide/iostream.hpp>
 #include <boost/program_options.hpp>
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <cstdlib>
 #include <ctime>
 #include <iostream>
 #include <limits>
+#include <stdexcept>
 #include <vector>
 //#include <vld.h>
 
@@ -409,6 +417,34 @@ bool InitDirectories()
     return true;
 }
 
+/// Run the simulation benchmarks without starting the GUI
+int RunSimulationBenchmarks(const std::vector<std::string>& names, int numInstances, const bfs::path& resultPath)
+{
+    std::vector<benchmarks::Result> results;
+    for(const std::string& name : names)
+    {
+        results.push_back(benchmarks::runSimulation(name, numInstances));
+        bnw::cout << "Benchmark " << name << ": " << results.back().numIterations << " GFs in "
+                  << std::chrono::duration<double>(results.back().duration).count() << "s" << std::endl;
+    }
+    if(!benchmarks::writeResults(resultPath, results, numInstances))
+    {
+        bnw::cerr << "Could not write benchmark results to " << resultPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+/// Show the benchmark desktop which runs the benchmarks and quits
+bool StartBenchmarks(const std::vector<std::string>& names, int numInstances, const bfs::path& resultPath)
+{
+    ApplicationLoader loader(RTTRCONFIG, LOADER, LOG, SETTINGS.sound.playlist);
+    if(!loader.load())
+        return false;
+    WINDOWMANAGER.Switch(std::make_unique<dskBenchmark>(names, numInstances, resultPath));
+    return true;
+}
+
 bool InitGame(GameManager& gameManager)
 {
     libsiedler2::setAllocator(new GlAllocator());
@@ -461,6 +497,37 @@ int RunProgram(po::variables_map& options)
         }
     }
 
+    std::vector<std::string> benchmarkNames;
+    const int numBenchmarkInstances = options["instances"].as<int>();
+    if(numBenchmarkInstances < 0 || numBenchmarkInstances > benchmarks::MAX_INSTANCES)
+    {
+        bnw::cerr << "Error: The number of instances must be between 0 and " << benchmarks::MAX_INSTANCES << "\n";
+        return 1;
+    }
+    const bfs::path benchmarkResultPath = options["json"].as<std::string>();
+    if(options.count("benchmark"))
+    {
+        try
+        {
+            benchmarkNames = benchmarks::parseNames(options["benchmark"].as<std::string>());
+            // Without drawing benchmarks there is no need for a window, so this also works without a GPU
+            if(std::all_of(benchmarkNames.begin(), benchmarkNames.end(), benchmarks::isSimulation))
+                return RunSimulationBenchmarks(benchmarkNames, numBenchmarkInstances, benchmarkResultPath);
+        } catch(const std::exception& e)
+        {
+            bnw::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    const bfs::path tracePath = options.count("trace") ? options["trace"].as<std::string>() : "";
+    if(!tracePath.empty())
+    {
+        if(!TraceRecorder::IsCompiledIn())
+            LOG.write(_("Warning: Tracing is not compiled in (RTTR_ENABLE_TRACING), the trace stays empty\n"));
+        TRACERECORDER.Start();
+    }
+
     SetGlobalInstanceWrapper<GameManager> gameManager(setGlobalGameManager, LOG, SETTINGS, VIDEODRIVER, AUDIODRIVER,
                                                       WINDOWMANAGER);
     try
@@ -470,6 +537,8 @@ int RunProgram(po::variables_map& options)
 
         if(options.count("map") && !QuickStartGame(options["map"].as<std::string>()))
             return 1;
+        if(!benchmarkNames.empty() && !StartBenchmarks(benchmarkNames, numBenchmarkInstances, benchmarkResultPath))
+            return 1;
 
         // Hauptschleife
 
@@ -483,6 +552,15 @@ int RunProgram(po::variables_map& options)
         // Spiel beenden
         gameManager.Stop();
         libsiedler2::setAllocator(nullptr);
+
+        if(!tracePath.empty())
+        {
+            TRACERECORDER.Stop();
+            if(TRACERECORDER.Write(tracePath))
+                LOG.write(_("Trace written to %1%\n")) % tracePath;
+            else
+                LOG.write(_("Could not write the trace to %1%\n")) % tracePath;
+        }
     } catch(RTTR_AssertError& error)
     {
         // Write to log file, but don't throw any errors if this fails too
@@ -519,6 +597,11 @@ int main(int argc, char** argv)
         ("map,m", po::value<std::string>(),"Map to load")
         ("version", "Show version information and exit")
         ("convert-sounds", "Convert sounds and exit")
+        ("trace", po::value<std::string>(), "Record the phases of each frame into this file (Chrome trace format)")
+        ("benchmark", po::value<std::string>(),
+            "Run benchmarks and exit: all, draw, sim or a comma separated list of names (e.g. text,simFullGame)")
+        ("instances", po::value<int>()->default_value(1000), "Number of instances (0-1000) used by the benchmarks")
+        ("json", po::value<std::string>()->default_value("benchmark.json"), "File to write the benchmark results to")
         ;
     // clang-format on
     po::positional_options_description positionalOptions;
@@ -0,0 +1,215 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "AIGameRunner.h"
+#include "EventManager.h"
+#include "GFProfiler.h"
+#include "Game.h"
+#include "GamePlayer.h"
+#include "PlayerInfo.h"
+#include "ai/AIPlayer.h"
+#include "factories/AIFactory.h"
+#include "helpers/format.hpp"
+#include "random/Random.h"
+#include "world/GameWorld.h"
+#include "gameTypes/StatisticTypes.h"
+#include "gameData/GameConsts.h"
+#include "gameData/MaxPlayers.h"
+#include "s25util/Log.h"
+#include "s25util/colors.h"
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <numeric>
+#include <stdexcept>
+
+namespace bfs = boost::filesystem;
+
+AIGameRunner::AIGameRunner() : objectiveWinnerMask_(0) {}
+
+AIGameRunner::~AIGameRunner()
+{
+    game_.reset();
+}
+
+bool AIGameRunner::Load(const boost::filesystem::path& mapPath, const std::vector<AI::Info>& players,
+                        const unsigned seed, const GlobalGameSettings& ggs)
+{
+    RTTR_Assert(!game_);
+    if(players.empty() || players.size() > MAX_PLAYERS)
+    {
+        lastErrorMsg_ = helpers::format("Invalid number of players: %s", players.size());
+        return false;
+    }
+
+    try
+    {
+        // The AIs derive the seeds of their random generators from this too
+        RANDOM.Init(seed);
+
+        std::vector<PlayerInfo> playerInfos;
+        for(unsigned i = 0; i < players.size(); i++)
+        {
+            PlayerInfo p;
+            p.ps = PS_AI;
+            p.aiInfo = players[i];
+            p.name = helpers::format("AI %s", i + 1);
+            p.nation = Nation(i % NUM_NATIVE_NATIONS);
+            p.color = PLAYER_COLORS[i % PLAYER_COLORS.size()];
+            p.team = TM_NOTEAM;
+            playerInfos.push_back(p);
+        }
+
+        game_ = std::make_shared<Game>(ggs, 0u, playerInfos);
+        GameWorld& gameWorld = game_->world_;
+        gameWorld.SetGameInterface(this);
+        const bfs::path luaPath = bfs::path(mapPath).replace_extension("lua");
+        if(!gameWorld.LoadMap(game_, *this, mapPath, luaPath))
+            throw std::runtime_error("Error loading map " + mapPath.string());
+        gameWorld.InitAfterLoad();
+
+        std::vector<unsigned> playerIds(players.size());
+        std::iota(playerIds.begin(), playerIds.end(), 0u);
+        for(std::unique_ptr<AIPlayer>& ai : AIFactory::Create(playerIds, gameWorld))
+            game_->AddAIPlayer(std::move(ai));
+        pendingGCs_.resize(game_->aiPlayers_.size());
+        game_->Start(false);
+    } catch(const std::exception& e)
+    {
+        lastErrorMsg_ = e.what();
+        game_.reset();
+        return false;
+    }
+    return true;
+}
+
+unsigned AIGameRunner::Run(const unsigned targetGF, const unsigned statisticsInterval)
+{
+    RTTR_Assert(game_);
+    const unsigned startGF = GetCurrentGF();
+    while(GetCurrentGF() < targetGF && !IsFinished())
+    {
+        if(statisticsInterval && GetCurrentGF() % statisticsInterval == 0)
+            TakeSample();
+        ExecuteGF();
+    }
+    if(samples_.empty() || samples_.back().gf != GetCurrentGF())
+        TakeSample();
+    return GetCurrentGF() - startGF;
+}
+
+unsigned AIGameRunner::GetCurrentGF() const
+{
+    return game_->em_->GetCurrentGF();
+}
+
+bool AIGameRunner::IsFinished() const
+{
+    return game_->IsGameFinished();
+}
+
+unsigned AIGameRunner::GetWinnerMask() const
+{
+    if(objectiveWinnerMask_ || !game_)
+        return objectiveWinnerMask_;
+    const GameWorld& gameWorld = game_->world_;
+    unsigned bestCountry = 0, winnerMask = 0;
+    for(unsigned i = 0; i < gameWorld.GetNumPlayers(); i++)
+    {
+        const GamePlayer& player = gameWorld.GetPlayer(i);
+        if(player.IsDefeated())
+            continue;
+        const unsigned country = player.GetStatisticCurrentValue(STAT_COUNTRY);
+        if(country > bestCountry)
+        {
+            bestCountry = country;
+            winnerMask = 0;
+        }
+        if(country == bestCountry)
+            winnerMask |= 1u << i;
+    }
+    return winnerMask;
+}
+
+void AIGameRunner::ExecuteGF()
+{
+    const unsigned curGF = GetCurrentGF();
+    const bool isNWF = curGF % NWF_LENGTH == 0;
+    if(isNWF)
+    {
+        // Same as GameClient::ExecuteNWF: The commands sent at the last NWF are executed now
+        for(unsigned i = 0; i < game_->aiPlayers_.size(); i++)
+        {
+            AIPlayer& ai = game_->aiPlayers_[i];
+            for(const gc::GameCommandPtr& gc : pendingGCs_[i])
+                gc->Execute(game_->world_, ai.GetPlayerId());
+            pendingGCs_[i] = ai.FetchGameCommands();
+        }
+    }
+
+    // Same as GameClient::NextGF
+    GFPROFILER.StartGF(curGF);
+    for(AIPlayer& ai : game_->aiPlayers_)
+    {
+        GFProfiler::ScopedTimer timer(GFProfiler::GetAISlot(ai.GetPlayerId()));
+        ai.RunGF(curGF, isNWF);
+    }
+    game_->RunGF();
+    GFPROFILER.EndGF();
+}
+
+void AIGameRunner::TakeSample()
+{
+    const GameWorld& gameWorld = game_->world_;
+    for(unsigned i = 0; i < gameWorld.GetNumPlayers(); i++)
+    {
+        const GamePlayer& player = gameWorld.GetPlayer(i);
+        Sample sample;
+        sample.gf = GetCurrentGF();
+        sample.playerId = static_cast<unsigned char>(i);
+        sample.isDefeated = player.IsDefeated();
+        sample.country = player.GetStatisticCurrentValue(STAT_COUNTRY);
+        sample.military = player.GetStatisticCurrentValue(STAT_MILITARY);
+        sample.productivity = player.GetStatisticCurrentValue(STAT_PRODUCTIVITY);
+        sample.vanquished = player.GetStatisticCurrentValue(STAT_VANQUISHED);
+        samples_.push_back(sample);
+    }
+}
+
+std::string AIGameRunner::FormatGFTime(const unsigned numGFs) const
+{
+    using seconds = std::chrono::duration<uint32_t, std::chrono::seconds::period>;
+    const auto numSeconds = std::chrono::duration_cast<seconds>(
+      numGFs * std::chrono::milliseconds(SPEED_GF_LENGTHS[game_->ggs_.speed]));
+    const unsigned totalSeconds = numSeconds.count();
+    return helpers::format("%02u:%02u:%02u", totalSeconds / 3600, (totalSeconds / 60) % 60, totalSeconds % 60);
+}
+
+void AIGameRunner::SystemChat(const std::string& text)
+{
+    LOG.write("GF %1%: %2%\n", LogTarget::Stdout) % GetCurrentGF() % text;
+}
+
+void AIGameRunner::GI_Winner(const unsigned playerId)
+{
+    objectiveWinnerMask_ = 1u << playerId;
+}
+
+void AIGameRunner::GI_TeamWinner(const unsigned playerMask)
+{
+    objectiveWinnerMask_ = playerMask;
+}
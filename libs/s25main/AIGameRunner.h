@@ -0,0 +1,101 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "GameCommand.h"
+#include "GameInterface.h"
+#include "GlobalGameSettings.h"
+#include "ILocalGameState.h"
+#include "gameTypes/AIInfo.h"
+#include "gameTypes/MapCoordinates.h"
+#include <boost/filesystem/path.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Game;
+
+/// Plays a game of AI players only without any GUI, network or timing as fast as possible (e.g. for AI tournaments).
+/// Does the same as the GameClient for the AIs, using a fixed NWF length.
+/// Everything random is derived from the seed, so a game can be reproduced by using the same map, players and seed.
+/// Note: As game objects use global state (e.g. their world and RANDOM) only one game may exist at a time.
+/// Loading a game resets that state, so games can be run one after another in the same process.
+class AIGameRunner final : public ILocalGameState, public GameInterface
+{
+public:
+    /// Number of GFs between 2 NWFs at which the commands of the AIs are executed
+    static constexpr unsigned NWF_LENGTH = 5;
+
+    /// Statistic values of one player at one GF
+    struct Sample
+    {
+        unsigned gf;
+        unsigned char playerId;
+        bool isDefeated;
+        unsigned country, military, productivity, vanquished;
+    };
+
+    AIGameRunner();
+    ~AIGameRunner();
+
+    /// Create the game on the map with one AI per entry. Return false on error (see GetLastErrorMsg)
+    bool Load(const boost::filesystem::path& mapPath, const std::vector<AI::Info>& players, unsigned seed,
+              const GlobalGameSettings& ggs = GlobalGameSettings());
+    /// Execute GFs till the target GF is reached or the game is finished, taking a sample of the statistics every
+    /// statisticsInterval GFs (0 = never) and at the end. Returns the number of GFs executed
+    unsigned Run(unsigned targetGF, unsigned statisticsInterval);
+
+    /// Return the GF that will be executed next
+    unsigned GetCurrentGF() const;
+    /// True if the objective of the game was reached
+    bool IsFinished() const;
+    /// Mask of the players that won (by reaching the objective) or are the best by country size when the game is not
+    /// finished. Undefeated players with the same size share the win. 0 if no game was run
+    unsigned GetWinnerMask() const;
+    const std::vector<Sample>& GetSamples() const { return samples_; }
+    const std::string& GetLastErrorMsg() const { return lastErrorMsg_; }
+
+    unsigned GetPlayerId() const override { return 0; }
+    bool IsHost() const override { return true; }
+    std::string FormatGFTime(unsigned numGFs) const override;
+    void SystemChat(const std::string& text) override;
+
+    void GI_PlayerDefeated(unsigned) override {}
+    void GI_UpdateMinimap(MapPoint) override {}
+    void GI_FlagDestroyed(MapPoint) override {}
+    void GI_TreatyOfAllianceChanged(unsigned) override {}
+    void GI_Winner(unsigned playerId) override;
+    void GI_TeamWinner(unsigned playerMask) override;
+    void GI_WindowClosed(Window*) override {}
+    void GI_StartRoadBuilding(MapPoint, bool) override {}
+    void GI_CancelRoadBuilding() override {}
+    void GI_BuildRoad() override {}
+
+private:
+    void ExecuteGF();
+    void TakeSample();
+
+    std::shared_ptr<Game> game_;
+    /// Commands of each AI fetched at the last NWF which are executed at the next one
+    std::vector<std::vector<gc::GameCommandPtr>> pendingGCs_;
+    /// Players that reached the objective (0 if none did)
+    unsigned objectiveWinnerMask_;
+    std::vector<Sample> samples_;
+    std::string lastErrorMsg_;
+};
@@ -0,0 +1,225 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#include "BenchmarkScenarios.h"
+#include "Game.h"
+#include "GlobalGameSettings.h"
+#include "PlayerInfo.h"
+#include "RTTR_Version.h"
+#include "RttrForeachPt.h"
+#include "buildings/nobMilitary.h"
+#include "factories/BuildingFactory.h"
+#include "figures/nofPassiveSoldier.h"
+#include "figures/nofPassiveWorker.h"
+#include "helpers/containerUtils.h"
+#include "helpers/mathFuncs.h"
+#include "lua/GameDataLoader.h"
+#include "random/Random.h"
+#include "world/GameWorld.h"
+#include "world/MapLoader.h"
+#include "gameData/TerrainDesc.h"
+#include "s25util/colors.h"
+#include <boost/algorithm/string/split.hpp>
+#include <boost/nowide/fstream.hpp>
+#include <iomanip>
+#include <random>
+#include <stdexcept>
+
+namespace benchmarks {
+namespace {
+    void generateWorld(GameWorld& world)
+    {
+        loadGameData(world.GetDescriptionWriteable());
+        world.Init(MapExtent(128, 128));
+        const WorldDescription& desc = world.GetDescription();
+        DescIdx<TerrainDesc> lastTerrain(0);
+        int lastHeight = 10;
+        std::mt19937 rng(42);
+        using std::uniform_int_distribution;
+        uniform_int_distribution<int> percentage(0, 100);
+        uniform_int_distribution<int> randTerrain(0, desc.terrain.size() / 2);
+        RTTR_FOREACH_PT(MapPoint, world.GetSize())
+        {
+            MapNode& node = world.GetNodeWriteable(pt);
+            DescIdx<TerrainDesc> t;
+            // 90% chance of using the same terrain
+            if(percentage(rng) <= 90)
+                t = lastTerrain;
+            else
+                t.value = randTerrain(rng);
+            node.t1 = t;
+            lastTerrain = t;
+            if(percentage(rng) <= 90)
+                t = lastTerrain;
+            else
+                t.value = randTerrain(rng);
+            node.t2 = t;
+            lastTerrain = t;
+            if(percentage(rng) <= 70)
+                lastHeight = helpers::clamp(lastHeight + uniform_int_distribution<int>(-1, 1)(rng), 8, 13);
+            node.altitude = lastHeight;
+        }
+        MapLoader::InitShadows(world);
+        MapLoader::SetMapExplored(world);
+    }
+
+    void addBuildings(GameWorld& world, const std::vector<MapPoint>& hqs, int numInstances)
+    {
+        std::mt19937 rng(0x1337);
+        for(unsigned i = 0; i < hqs.size(); i++)
+        {
+            std::vector<MapPoint> pts = world.GetPointsInRadius(hqs[i], 15);
+            std::bernoulli_distribution dist(numInstances / static_cast<float>(MAX_INSTANCES));
+            std::bernoulli_distribution distEqual;
+            std::array<BuildingType, 5> blds = {{BLD_BARRACKS, BLD_MILL, BLD_IRONMINE, BLD_SLAUGHTERHOUSE, BLD_BAKERY}};
+            std::uniform_int_distribution<unsigned> getBld(0, blds.size() - 1);
+            std::uniform_int_distribution<unsigned> getJob(0, NUM_JOB_TYPES - 1);
+            std::uniform_int_distribution<int> getDir(0, Direction::COUNT - 1);
+            for(MapPoint pt : pts)
+            {
+                MapPoint flagPt = world.GetNeighbour(pt, Direction::SOUTHEAST);
+                if(world.GetNode(pt).obj || world.GetNode(flagPt).obj || !dist(rng))
+                    continue;
+                BuildingType bldType = blds[getBld(rng)];
+                noBuilding* bld =
+                  BuildingFactory::CreateBuilding(world, bldType, pt, i, distEqual(rng) ? NAT_AFRICANS : NAT_JAPANESE);
+                if(bldType == BLD_BARRACKS)
+                {
+                    auto* mil = static_cast<nobMilitary*>(bld);
+                    auto* sld = new nofPassiveSoldier(pt, i, mil, mil, 0);
+                    mil->AddPassiveSoldier(sld);
+                }
+                auto* figure = new nofPassiveWorker(Job(getJob(rng)), flagPt, i, nullptr);
+                world.AddFigure(flagPt, figure);
+                figure->StartWandering();
+                figure->StartWalking(Direction::fromInt(getDir(rng)));
+            }
+        }
+    }
+
+    GameScenario getScenario(const std::string& simulationName)
+    {
+        const std::vector<std::string>& names = getSimulationNames();
+        const auto idx = helpers::indexOf(names, simulationName);
+        if(idx < 0)
+            throw std::invalid_argument("Unknown benchmark: " + simulationName);
+        return GameScenario(idx);
+    }
+} // namespace
+
+const std::vector<std::string>& getDrawingNames()
+{
+    static const std::vector<std::string> names{"text", "primitives", "emptyGame", "basicGame", "fullGame"};
+    return names;
+}
+
+const std::vector<std::string>& getSimulationNames()
+{
+    // Same order as GameScenario
+    static const std::vector<std::string> names{"simEmptyGame", "simBasicGame", "simFullGame"};
+    return names;
+}
+
+bool isSimulation(const std::string& name)
+{
+    return helpers::contains(getSimulationNames(), name);
+}
+
+std::vector<std::string> parseNames(const std::string& names)
+{
+    std::vector<std::string> result;
+    if(names == "all" || names == "draw")
+        result = getDrawingNames();
+    if(names == "all" || names == "sim")
+        result.insert(result.end(), getSimulationNames().begin(), getSimulationNames().end());
+    if(!result.empty())
+        return result;
+    boost::split(result, names, [](char c) { return c == ','; });
+    for(const std::string& name : result)
+    {
+        if(!isSimulation(name) && !helpers::contains(getDrawingNames(), name))
+            throw std::invalid_argument("Unknown benchmark: " + name);
+    }
+    return result;
+}
+
+std::shared_ptr<Game> createGame(GameScenario scenario, int numInstances)
+{
+    if(numInstances < 0 || numInstances > MAX_INSTANCES)
+        throw std::invalid_argument("Number of instances must be between 0 and " + std::to_string(MAX_INSTANCES));
+    RANDOM.Init(42);
+    std::vector<PlayerInfo> players;
+    PlayerInfo p;
+    p.ps = PS_OCCUPIED;
+    p.nation = NAT_AFRICANS;
+    p.color = PLAYER_COLORS[0];
+    players.push_back(p);
+    p.nation = NAT_JAPANESE;
+    p.color = PLAYER_COLORS[1];
+    players.push_back(p);
+    auto game = std::make_shared<Game>(GlobalGameSettings(), 0u, players);
+    GameWorld& world = game->world_;
+    generateWorld(world);
+
+    if(scenario == GameScenario::Empty)
+    {
+        RTTR_FOREACH_PT(MapPoint, world.GetSize())
+        {
+            world.SetVisibility(pt, 0, VIS_VISIBLE);
+        }
+    } else
+    {
+        std::vector<MapPoint> hqs(2, MapPoint(0, 0));
+        hqs[1].x += 30;
+        if(!MapLoader::PlaceHQs(world, hqs, false))
+            throw std::runtime_error("Could not place the HQs");
+        if(scenario == GameScenario::Full)
+            addBuildings(world, hqs, numInstances);
+    }
+    return game;
+}
+
+Result runSimulation(const std::string& name, int numInstances, unsigned numGFs)
+{
+    const std::shared_ptr<Game> game = createGame(getScenario(name), numInstances);
+    game->Start(false);
+    const auto startTime = std::chrono::steady_clock::now();
+    for(unsigned gf = 0; gf < numGFs; gf++)
+        game->RunGF();
+    return Result{name, numGFs, std::chrono::steady_clock::now() - startTime};
+}
+
+bool writeResults(const boost::filesystem::path& filepath, const std::vector<Result>& results, int numInstances)
+{
+    boost::nowide::ofstream file(filepath);
+    if(!file)
+        return false;
+    file << std::fixed << std::setprecision(3);
+    file << "{\n\"version\": \"" << RTTR_Version::GetReadableVersion() << "\",\n\"instances\": " << numInstances
+         << ",\n\"results\": [";
+    for(auto it = results.begin(); it != results.end(); ++it)
+    {
+        const double totalMs = std::chrono::duration<double, std::milli>(it->duration).count();
+        file << (it == results.begin() ? "\n" : ",\n");
+        file << "{\"name\": \"" << it->name << "\", \"type\": \"" << (isSimulation(it->name) ? "simulation" : "draw")
+             << "\", \"iterations\": " << it->numIterations << ", \"totalMs\": " << totalMs
+             << ", \"msPerIteration\": " << (it->numIterations ? totalMs / it->numIterations : 0.) << "}";
+    }
+    file << "\n]\n}\n";
+    return static_cast<bool>(file);
+}
+} // namespace benchmarks
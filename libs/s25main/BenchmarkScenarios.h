@@ -0,0 +1,73 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <boost/filesystem/path.hpp>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Game;
+
+/// Scenarios of the benchmark (see dskBenchmark).
+/// The game scenarios can also be run as simulation only (executing GFs without drawing), which needs no GPU
+namespace benchmarks {
+enum class GameScenario
+{
+    /// World without any objects
+    Empty,
+    /// 2 HQs
+    Basic,
+    /// 2 HQs surrounded by buildings and wandering figures
+    Full
+};
+
+struct Result
+{
+    std::string name;
+    /// Number of frames drawn or GFs executed
+    unsigned numIterations;
+    std::chrono::nanoseconds duration;
+};
+
+/// Number of GFs executed by the simulation benchmarks
+constexpr unsigned NUM_SIMULATION_GFS = 2000;
+/// Maximum number of instances of the benchmarks (minimum is 0)
+constexpr int MAX_INSTANCES = 1000;
+
+/// Names of the benchmarks which draw (in the order of the tests in dskBenchmark)
+const std::vector<std::string>& getDrawingNames();
+/// Names of the benchmarks which only run the simulation
+const std::vector<std::string>& getSimulationNames();
+bool isSimulation(const std::string& name);
+/// Convert "all", "draw", "sim" or a comma separated list of names to the list of names.
+/// Throws std::invalid_argument on unknown names
+std::vector<std::string> parseNames(const std::string& names);
+
+/// Create a game with 2 players on a generated 128x128 world (always the same) for the scenario.
+/// The number of instances (0-MAX_INSTANCES) controls the density of buildings in the full scenario.
+/// Graphics are not loaded. Throws std::invalid_argument on an invalid number of instances and std::runtime_error on
+/// other failures
+std::shared_ptr<Game> createGame(GameScenario scenario, int numInstances);
+/// Run the given simulation benchmark
+Result runSimulation(const std::string& name, int numInstances, unsigned numGFs = NUM_SIMULATION_GFS);
+
+/// Write the results as JSON
+bool writeResults(const boost::filesystem::path& filepath, const std::vector<Result>& results, int numInstances);
+} // namespace benchmarks
@@ -0,0 +1,72 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#include "BinaryBuffer.h"
+#include "RTTR_Assert.h"
+#include "s25util/BinaryFile.h"
+#include "s25util/Serializer.h"
+#include <limits>
+
+void BinaryBuffer::WriteRawData(const void* data, unsigned length)
+{
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    data_.insert(data_.end(), bytes, bytes + length);
+}
+
+void BinaryBuffer::WriteUnsignedChar(uint8_t value)
+{
+    data_.push_back(value);
+}
+
+void BinaryBuffer::WriteUnsignedShort(uint16_t value)
+{
+    for(unsigned i = 0; i < 2; i++)
+        data_.push_back(static_cast<uint8_t>(value >> (i * 8)));
+}
+
+void BinaryBuffer::WriteUnsignedInt(uint32_t value)
+{
+    for(unsigned i = 0; i < 4; i++)
+        data_.push_back(static_cast<uint8_t>(value >> (i * 8)));
+}
+
+void BinaryBuffer::WriteShortString(const std::string& str)
+{
+    RTTR_Assert(str.length() < std::numeric_limits<uint8_t>::max());
+    const auto length = static_cast<uint8_t>(str.length() + 1);
+    WriteUnsignedChar(length);
+    WriteRawData(str.c_str(), length);
+}
+
+void BinaryBuffer::WriteLongString(const std::string& str)
+{
+    const auto length = static_cast<unsigned>(str.length() + 1);
+    WriteUnsignedInt(length);
+    WriteRawData(str.c_str(), length);
+}
+
+void BinaryBuffer::WriteSerializer(const Serializer& ser)
+{
+    WriteUnsignedInt(ser.GetLength());
+    WriteRawData(ser.GetData(), ser.GetLength());
+}
+
+void BinaryBuffer::WriteToFile(BinaryFile& file) const
+{
+    if(!data_.empty())
+        file.WriteRawData(data_.data(), static_cast<unsigned>(data_.size()));
+}
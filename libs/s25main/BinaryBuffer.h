@@ -0,0 +1,50 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class BinaryFile;
+class Serializer;
+
+/// Collects data in memory in the same (little endian) format as written by BinaryFile.
+/// Used to create data once which is written to a file and/or sent over the network
+class BinaryBuffer
+{
+public:
+    void WriteRawData(const void* data, unsigned length);
+    void WriteUnsignedChar(uint8_t value);
+    void WriteUnsignedShort(uint16_t value);
+    void WriteUnsignedInt(uint32_t value);
+    /// Write the string with its terminating NULL prefixed by its length (1 byte)
+    void WriteShortString(const std::string& str);
+    /// Write the string with its terminating NULL prefixed by its length (4 bytes)
+    void WriteLongString(const std::string& str);
+    /// Write the data of the serializer prefixed by its size as done by Serializer::WriteToFile
+    void WriteSerializer(const Serializer& ser);
+
+    /// Current size which is the position of the next write (like BinaryFile::Tell)
+    unsigned Tell() const { return static_cast<unsigned>(data_.size()); }
+    const std::vector<uint8_t>& GetData() const { return data_; }
+    void WriteToFile(BinaryFile& file) const;
+
+private:
+    std::vector<uint8_t> data_;
+};
@@ -16,6 +16,7 @@
 // along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
 
 #include "EventManager.h"
+#include "GFProfiler.h"
 #include "GameEvent.h"
 #include "GameObject.h"
 #include "SerializedGameData.h"
@@ -150,7 +151,12 @@ void EventManager::ExecuteEvents(const EventMap::iterator& itEvents)
         RTTR_Assert(ev->obj->GetObjId() <= GameObject::GetObjIDCounter());
 
         curActiveEvent = ev;
-        ev->obj->HandleEvent(ev->id);
+        {
+            GFProfiler::ScopedTimer timer;
+            if(GFPROFILER.IsRecording())
+                timer.Start(GFProfiler::GetSlot(ev->obj->GetGOT()));
+            ev->obj->HandleEvent(ev->id);
+        }
 
         delete ev;
         --numActiveEvents;
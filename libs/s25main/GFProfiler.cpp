@@ -0,0 +1,205 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#include "GFProfiler.h"
+#include "RTTR_Assert.h"
+#include "helpers/toString.h"
+#include <boost/nowide/fstream.hpp>
+#include <algorithm>
+#include <iomanip>
+
+namespace {
+const std::array<const char*, GFProfiler::NUM_SECTIONS> SECTION_NAMES = {"Events", "Lua", "Statistics", "Pathfinding"};
+const std::array<const char*, GFProfiler::NUM_OBJECT_TYPES> OBJECT_TYPE_NAMES = {
+  "Unknown", "Nothing", "HQ", "Military", "Storehouse", "UsualBuilding", "Shipyard", "Harbor", "BuildingSite",
+  "AggressiveDefender", "Attacker", "Defender", "PassiveSoldier", "WellGuy", "Carrier", "Woodcutter", "Fisher",
+  "Forester", "Carpenter", "Stonemason", "Hunter", "Farmer", "Miller", "Baker", "Butcher", "Miner", "Brewer",
+  "PigBreeder", "DonkeyBreeder", "IronFounder", "Minter", "Metalworker", "Armorer", "Builder", "Planer", "Geologist",
+  "Shipwright", "ScoutFree", "ScoutLookoutTower", "WarehouseWorker", "Catapultman", "PassiveWorker", "Charburner",
+  "Extension", "EnvObject", "Fire", "Flag", "Grainfield", "Granite", "Sign", "Skeleton", "StaticObject",
+  "DisappearingMapEnvObject", "Tree", "Animal", "Fighting", "RoadSegment", "Ware", "CatapultStone", "BurnedWarehouse",
+  "ShipBuildingSite", "Ship", "CharburnerPile", "TradeLeader", "TradeDonkey", "EconomyModeHandler"};
+
+double ToMicroseconds(GFProfiler::Duration duration)
+{
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+void WriteJSONSlots(std::ostream& os, const GFProfiler::GFTimes& times)
+{
+    os << "{\"gf\": " << times.gf << ", \"total\": " << ToMicroseconds(times.total) << ", \"slots\": {";
+    bool isFirst = true;
+    for(unsigned i = 0; i < GFProfiler::NUM_SLOTS; i++)
+    {
+        if(times.slots[i] == GFProfiler::Duration::zero())
+            continue;
+        if(!isFirst)
+            os << ", ";
+        isFirst = false;
+        os << "\"" << GFProfiler::GetSlotName(i) << "\": " << ToMicroseconds(times.slots[i]);
+    }
+    os << "}}";
+}
+} // namespace
+
+GFProfiler::GFTimes::GFTimes() : gf(0), total(Duration::zero())
+{
+    slots.fill(Duration::zero());
+}
+
+void GFProfiler::ScopedTimer::Start(GFProfiler& profiler, unsigned slot)
+{
+    RTTR_Assert(!profiler_);
+    RTTR_Assert(slot < NUM_SLOTS);
+    profiler_ = &profiler;
+    parent_ = profiler.curTimer_;
+    slot_ = slot;
+    childTime_ = Duration::zero();
+    profiler.curTimer_ = this;
+    startTime_ = Clock::now();
+}
+
+void GFProfiler::ScopedTimer::Stop()
+{
+    const Duration elapsed = Clock::now() - startTime_;
+    RTTR_Assert(profiler_->curTimer_ == this);
+    profiler_->curTimer_ = parent_;
+    // Disabled in between
+    if(!profiler_->IsRecording())
+        return;
+    profiler_->curGF_.slots[slot_] += elapsed - childTime_;
+    if(parent_)
+        parent_->childTime_ += elapsed;
+}
+
+GFProfiler::GFProfiler() : enabled_(false), isInGF_(false), curTimer_(nullptr), numMeasuredGFs_(0) {}
+
+std::string GFProfiler::GetSlotName(unsigned slot)
+{
+    RTTR_Assert(slot < NUM_SLOTS);
+    if(slot < NUM_SECTIONS)
+        return SECTION_NAMES[slot];
+    slot -= NUM_SECTIONS;
+    if(slot < NUM_OBJECT_TYPES)
+        return std::string("Events/") + OBJECT_TYPE_NAMES[slot];
+    return "AI/" + helpers::toString(slot - NUM_OBJECT_TYPES);
+}
+
+void GFProfiler::SetEnabled(bool enabled)
+{
+    if(enabled == enabled_)
+        return;
+    enabled_ = enabled;
+    isInGF_ = false;
+    if(enabled)
+        Clear();
+}
+
+void GFProfiler::Clear()
+{
+    recordedGFs_.clear();
+    totals_ = slowestGF_ = GFTimes();
+    numMeasuredGFs_ = 0;
+}
+
+void GFProfiler::StartGF(unsigned gf)
+{
+    if(!enabled_)
+        return;
+    RTTR_Assert(!curTimer_);
+    curGF_ = GFTimes();
+    curGF_.gf = gf;
+    isInGF_ = true;
+    gfStartTime_ = Clock::now();
+}
+
+void GFProfiler::EndGF()
+{
+    if(!isInGF_)
+        return;
+    curGF_.total = Clock::now() - gfStartTime_;
+    isInGF_ = false;
+
+    totals_.total += curGF_.total;
+    for(unsigned i = 0; i < NUM_SLOTS; i++)
+        totals_.slots[i] += curGF_.slots[i];
+    totals_.gf = curGF_.gf;
+    ++numMeasuredGFs_;
+    if(curGF_.total > slowestGF_.total)
+        slowestGF_ = curGF_;
+    if(recordedGFs_.size() >= MAX_RECORDED_GFS)
+        recordedGFs_.pop_front();
+    recordedGFs_.push_back(curGF_);
+}
+
+GFProfiler::GFTimes GFProfiler::GetAverage(unsigned numGFs) const
+{
+    GFTimes result;
+    numGFs = std::min<unsigned>(numGFs, recordedGFs_.size());
+    if(numGFs == 0)
+        return result;
+    for(auto it = recordedGFs_.end() - numGFs; it != recordedGFs_.end(); ++it)
+    {
+        result.total += it->total;
+        for(unsigned i = 0; i < NUM_SLOTS; i++)
+            result.slots[i] += it->slots[i];
+    }
+    result.gf = numGFs;
+    result.total /= numGFs;
+    for(Duration& slot : result.slots)
+        slot /= numGFs;
+    return result;
+}
+
+bool GFProfiler::WriteCSV(const boost::filesystem::path& filepath) const
+{
+    boost::nowide::ofstream file(filepath);
+    if(!file)
+        return false;
+    file << "gf,total";
+    for(unsigned i = 0; i < NUM_SLOTS; i++)
+        file << "," << GetSlotName(i);
+    file << "\n" << std::fixed << std::setprecision(1);
+    for(const GFTimes& times : recordedGFs_)
+    {
+        file << times.gf << "," << ToMicroseconds(times.total);
+        for(const Duration& slot : times.slots)
+            file << "," << ToMicroseconds(slot);
+        file << "\n";
+    }
+    return static_cast<bool>(file);
+}
+
+bool GFProfiler::WriteJSON(const boost::filesystem::path& filepath) const
+{
+    boost::nowide::ofstream file(filepath);
+    if(!file)
+        return false;
+    file << std::fixed << std::setprecision(1);
+    file << "{\n\"unit\": \"us\",\n\"numGFs\": " << numMeasuredGFs_ << ",\n\"totals\": ";
+    WriteJSONSlots(file, totals_);
+    file << ",\n\"slowestGF\": ";
+    WriteJSONSlots(file, slowestGF_);
+    file << ",\n\"gfs\": [";
+    for(auto it = recordedGFs_.begin(); it != recordedGFs_.end(); ++it)
+    {
+        file << (it == recordedGFs_.begin() ? "\n" : ",\n");
+        WriteJSONSlots(file, *it);
+    }
+    file << "\n]\n}\n";
+    return static_cast<bool>(file);
+}
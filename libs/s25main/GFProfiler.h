@@ -0,0 +1,139 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "gameTypes/GO_Type.h"
+#include "gameData/MaxPlayers.h"
+#include "s25util/Singleton.h"
+#include <boost/filesystem/path.hpp>
+#include <array>
+#include <chrono>
+#include <deque>
+#include <string>
+
+/// Measures how the time of each GF is spent.
+/// Always compiled in but does nothing (except checking a flag) unless enabled at runtime.
+/// The time is attributed to slots: Fixed sections, the events per type of the handling object and the AI per player.
+/// Timers can be nested, each slot gets only the time not spent in inner timers.
+/// Only to be used from the thread running the game.
+class GFProfiler : public Singleton<GFProfiler>
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Duration = std::chrono::nanoseconds;
+
+    enum class Section
+    {
+        /// Handling of events not spent in an object (e.g. destroying objects)
+        Events,
+        Lua,
+        Statistics,
+        Pathfinding
+    };
+    static constexpr unsigned NUM_SECTIONS = 4;
+    static constexpr unsigned NUM_OBJECT_TYPES = GOT_ECONOMYMODEHANDLER + 1;
+    static constexpr unsigned NUM_SLOTS = NUM_SECTIONS + NUM_OBJECT_TYPES + MAX_PLAYERS;
+    /// Number of GFs of which the times are kept
+    static constexpr unsigned MAX_RECORDED_GFS = 10000;
+
+    struct GFTimes
+    {
+        GFTimes();
+        unsigned gf;
+        /// Wall time of the whole GF
+        Duration total;
+        std::array<Duration, NUM_SLOTS> slots;
+    };
+
+    /// Adds the time from starting till destruction to a slot (if the profiler is recording)
+    class ScopedTimer
+    {
+    public:
+        /// Does nothing till started
+        ScopedTimer() : profiler_(nullptr) {}
+        explicit ScopedTimer(unsigned slot) : profiler_(nullptr) { Start(slot); }
+        ~ScopedTimer()
+        {
+            if(profiler_)
+                Stop();
+        }
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+        void Start(unsigned slot)
+        {
+            GFProfiler& profiler = GFProfiler::inst();
+            if(profiler.IsRecording())
+                Start(profiler, slot);
+        }
+
+    private:
+        void Start(GFProfiler& profiler, unsigned slot);
+        void Stop();
+
+        GFProfiler* profiler_;
+        ScopedTimer* parent_;
+        unsigned slot_;
+        Clock::time_point startTime_;
+        /// Time spent in nested timers
+        Duration childTime_;
+    };
+
+    GFProfiler();
+
+    static unsigned GetSlot(Section section) { return static_cast<unsigned>(section); }
+    static unsigned GetSlot(GO_Type objectType) { return NUM_SECTIONS + objectType; }
+    static unsigned GetAISlot(unsigned playerId) { return NUM_SECTIONS + NUM_OBJECT_TYPES + playerId; }
+    static std::string GetSlotName(unsigned slot);
+
+    /// Enabling starts a new recording, disabling keeps the recorded data
+    void SetEnabled(bool enabled);
+    bool IsEnabled() const { return enabled_; }
+    /// True while a GF is being measured
+    bool IsRecording() const { return isInGF_; }
+    void Clear();
+
+    void StartGF(unsigned gf);
+    void EndGF();
+
+    /// Times of the last GFs (at most MAX_RECORDED_GFS), oldest first
+    const std::deque<GFTimes>& GetRecordedGFs() const { return recordedGFs_; }
+    /// Average of the last numGFs recorded GFs. The gf member is the number of GFs used
+    GFTimes GetAverage(unsigned numGFs) const;
+    /// Sum of all GFs measured since the recording started
+    const GFTimes& GetTotals() const { return totals_; }
+    unsigned GetNumMeasuredGFs() const { return numMeasuredGFs_; }
+    const GFTimes& GetSlowestGF() const { return slowestGF_; }
+
+    /// Write one line per recorded GF with the times of all slots in microseconds
+    bool WriteCSV(const boost::filesystem::path& filepath) const;
+    /// Write the totals, the slowest GF and all recorded GFs (only slots with time spent) in microseconds
+    bool WriteJSON(const boost::filesystem::path& filepath) const;
+
+private:
+    bool enabled_, isInGF_;
+    Clock::time_point gfStartTime_;
+    GFTimes curGF_;
+    /// Innermost running timer
+    ScopedTimer* curTimer_;
+    std::deque<GFTimes> recordedGFs_;
+    GFTimes totals_, slowestGF_;
+    unsigned numMeasuredGFs_;
+};
+
+#define GFPROFILER GFProfiler::inst()
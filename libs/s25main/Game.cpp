@@ -18,12 +18,13 @@
 #include "Game.h"
 #include "EventManager.h"
 #include "GameInterface.h"
+#include "GFProfiler.h"
 #include "GamePlayer.h"
 #include "addons/AddonEconomyModeGameLength.h"
 #include "addons/const_addons.h"
 #include "ai/AIPlayer.h"
 #include "lua/LuaInterfaceGame.h"
-#include "network/GameClient.h"
+#include "gameData/GameConsts.h"
 #include <boost/optional.hpp>
 
 Game::Game(const GlobalGameSettings& settings, unsigned startGF, const std::vector<PlayerInfo>& players)
@@ -49,7 +50,8 @@ void Game::Start(bool startFromSave)
         {
             unsigned int selection = ggs_.getSelection(AddonId::ECONOMY_MODE_GAME_LENGTH);
             world_.econHandler = std::make_unique<EconomyModeHandler>(
-              std::chrono::minutes(AddonEconomyModeGameLengthList[selection]) / GAMECLIENT.GetGFLength());
+              std::chrono::minutes(AddonEconomyModeGameLengthList[selection])
+              / std::chrono::milliseconds(SPEED_GF_LENGTHS[ggs_.speed]));
         }
         StatisticStep();
     }
@@ -79,7 +81,10 @@ void Game::RunGF()
 {
     unsigned numPlayersAlive = getNumAlivePlayers(world_);
     //  EventManager Bescheid sagen
-    em_->ExecuteNextGF();
+    {
+        GFProfiler::ScopedTimer timer(GFProfiler::GetSlot(GFProfiler::Section::Events));
+        em_->ExecuteNextGF();
+    }
     // Notfallprogramm durchlaufen lassen
     for(unsigned i = 0; i < world_.GetNumPlayers(); ++i)
     {
@@ -93,10 +98,16 @@ void Game::RunGF()
     }
 
     if(world_.HasLua())
+    {
+        GFProfiler::ScopedTimer timer(GFProfiler::GetSlot(GFProfiler::Section::Lua));
         world_.GetLua().EventGameFrame(em_->GetCurrentGF());
+    }
     // Update statistic every 750 GFs (30 seconds on 'fast')
     if(em_->GetCurrentGF() % 750 == 0)
+    {
+        GFProfiler::ScopedTimer timer(GFProfiler::GetSlot(GFProfiler::Section::Statistics));
         StatisticStep();
+    }
     // If some players got defeated check objective
     if(getNumAlivePlayers(world_) < numPlayersAlive)
         CheckObjective();
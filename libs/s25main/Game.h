@@ -39,6 +39,8 @@ public:
 
     /// Does the remaining initializations for starting the game
     void Start(bool startFromSave);
+    /// Continue a game loaded from a snapshot of the running game (e.g. a replay keyframe) without any start events
+    void Resume() { started_ = true; }
     void RunGF();
     bool IsStarted() const { return started_; }
     bool IsGameFinished() const { return finished_; }
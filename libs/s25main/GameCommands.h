@@ -56,6 +56,11 @@ protected:
     Coords(const Type gst, Serializer& ser) : GameCommand(gst), pt_(PopMapPoint(ser)) {}
 
 public:
+    /// Number of bytes used by the type and the point at the start of the serialized command
+    static constexpr unsigned SERIALIZED_HEADER_SIZE = 5;
+
+    MapPoint GetPos() const { return pt_; }
+
     void Serialize(Serializer& ser) const override
     {
         GameCommand::Serialize(ser);
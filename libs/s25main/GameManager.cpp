@@ -22,6 +22,7 @@
 #include "RttrConfig.h"
 #include "Settings.h"
 #include "SoundManager.h"
+#include "TraceRecorder.h"
 #include "WindowManager.h"
 #include "desktops/dskLobby.h"
 #include "desktops/dskMainMenu.h"
@@ -107,16 +108,29 @@ void GameManager::Stop()
  */
 bool GameManager::Run()
 {
+    RTTR_TRACE_SCOPE("GameManager::Run");
     // Nachrichtenschleife
-    if(!videoDriver_.Run())
-        GLOBALVARS.notdone = false;
+    {
+        RTTR_TRACE_SCOPE("VideoDriver::Run");
+        if(!videoDriver_.Run())
+            GLOBALVARS.notdone = false;
+    }
 
-    LOBBYCLIENT.Run();
+    {
+        RTTR_TRACE_SCOPE("LobbyClient::Run");
+        LOBBYCLIENT.Run();
+    }
 
     // Get this before the run so we know if we are currently skipping
     const unsigned targetSkipGF = GAMECLIENT.skiptogf;
-    GAMECLIENT.Run();
-    GAMESERVER.Run();
+    {
+        RTTR_TRACE_SCOPE("GameClient::Run");
+        GAMECLIENT.Run();
+    }
+    {
+        RTTR_TRACE_SCOPE("GameServer::Run");
+        GAMESERVER.Run();
+    }
 
     if(targetSkipGF)
     {
@@ -125,20 +139,20 @@ bool GameManager::Run()
         const unsigned curGF = GAMECLIENT.GetGFNumber();
         if(targetSkipGF > curGF)
         {
-            if(curGF % 5000 == 0)
+            // Replays skip multiple GFs per run, so check the distance instead of exact multiples
+            if(!lastSkipReport)
             {
-                if(lastSkipReport)
-                {
-                    // Elapsed time in ms
-                    const auto timeDiff = static_cast<double>(current_time - lastSkipReport->time);
-                    const unsigned numGFPassed = curGF - lastSkipReport->gf;
-                    log_.write(_("jumping to gf %i, now at gf %i, time for last 5k gf: %.3f s, avg gf time %.3f ms \n"))
-                      % targetSkipGF % curGF % (timeDiff / 1000) % (timeDiff / numGFPassed);
-                } else
-                    log_.write(_("jumping to gf %i, now at gf %i \n")) % targetSkipGF % curGF;
+                log_.write(_("jumping to gf %i, now at gf %i \n")) % targetSkipGF % curGF;
                 lastSkipReport = SkipReport{current_time, curGF};
-            } else if(!lastSkipReport)
+            } else if(curGF - lastSkipReport->gf >= 5000)
+            {
+                // Elapsed time in ms
+                const auto timeDiff = static_cast<double>(current_time - lastSkipReport->time);
+                const unsigned numGFPassed = curGF - lastSkipReport->gf;
+                log_.write(_("jumping to gf %i, now at gf %i, time for last %i gf: %.3f s, avg gf time %.3f ms \n"))
+                  % targetSkipGF % curGF % numGFPassed % (timeDiff / 1000) % (timeDiff / numGFPassed);
                 lastSkipReport = SkipReport{current_time, curGF};
+            }
         } else
         {
             // Jump just completed
@@ -157,8 +171,12 @@ bool GameManager::Run()
         }
     } else
     {
-        videoDriver_.ClearScreen();
-        windowManager_.Draw();
+        {
+            RTTR_TRACE_SCOPE("WindowManager::Draw");
+            videoDriver_.ClearScreen();
+            windowManager_.Draw();
+        }
+        RTTR_TRACE_SCOPE("SwapBuffers");
         videoDriver_.SwapBuffers();
     }
     gfCounter_.update();
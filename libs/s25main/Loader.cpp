@@ -22,6 +22,7 @@
 #include "RttrConfig.h"
 #include "Settings.h"
 #include "Timer.h"
+#include "TraceRecorder.h"
 #include "addons/const_addons.h"
 #include "commonDefines.h"
 #include "convertSounds.h"
@@ -194,6 +195,7 @@ glArchivItem_Bitmap_Player* Loader::GetMapPlayerImage(unsigned nr)
  */
 bool Loader::LoadFilesAtStart()
 {
+    RTTR_TRACE_SCOPE("Loader::LoadFilesAtStart");
     namespace res = s25::resources;
     // Palettes
     if(!LoadFiles({res::pal5, res::pal6, res::pal7, res::paletti0, res::paletti1, res::paletti8})
@@ -365,6 +367,7 @@ void Loader::LoadDummyGUIFiles()
 bool Loader::LoadFilesAtGame(const std::string& mapGfxPath, bool isWinterGFX, const std::vector<Nation>& nations,
                              const std::vector<AddonId>& enabledAddons)
 {
+    RTTR_TRACE_SCOPE("Loader::LoadFilesAtGame");
     initResourceFolders(nations, enabledAddons);
 
     namespace res = s25::resources;
@@ -442,6 +445,7 @@ bool Loader::LoadResources(const std::vector<ResourceId>& resources)
 
 void Loader::fillCaches()
 {
+    RTTR_TRACE_SCOPE("Loader::fillCaches");
     stp = std::make_unique<glTexturePacker>();
 
     // Animals
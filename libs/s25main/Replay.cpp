@@ -16,11 +16,18 @@
 // along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
 
 #include "Replay.h"
+#include "BinaryBuffer.h"
+#include "ReplayWriter.h"
 #include "Savegame.h"
+#include "SerializedGameData.h"
 #include "network/PlayerGameCommands.h"
+#include "gameTypes/CompressedData.h"
 #include "gameTypes/MapInfo.h"
 #include <boost/filesystem.hpp>
+#include <algorithm>
+#include <iterator>
 #include <memory>
+#include <stdexcept>
 #include <mygettext/mygettext.h>
 
 std::string Replay::GetSignature() const
@@ -31,12 +38,15 @@ std::string Replay::GetSignature() const
 uint16_t Replay::GetVersion() const
 {
     /// Version des Replay-Formates
-    return 6;
+    return 8;
 }
 
 //////////////////////////////////////////////////////////////////////////
 
-Replay::Replay() : random_init(0), isRecording(false), lastGF_(0), last_gf_file_pos(0), mapType_(MAPTYPE_OLDMAP) {}
+Replay::Replay()
+    : random_init(0), isRecording(false), lastGF_(0), last_gf_file_pos(0), mapType_(MAPTYPE_OLDMAP), indexFilePos_(0),
+      commandsFilePos_(0)
+{}
 
 Replay::~Replay()
 {
@@ -45,14 +55,23 @@ Replay::~Replay()
 
 void Replay::Close()
 {
-    file.Close();
+    StopRecording();
     ClearPlayers();
 }
 
 void Replay::StopRecording()
 {
+    // Write remaining commands before closing the file
+    writer_.reset();
+    reader_.Close();
     file.Close();
     isRecording = false;
+    keyframes_.clear();
+}
+
+bool Replay::IsRecording() const
+{
+    return isRecording && file.IsValid() && writer_ && !writer_->HasFailed();
 }
 
 bool Replay::StartRecording(const boost::filesystem::path& filepath, const MapInfo& mapInfo)
@@ -60,53 +79,65 @@ bool Replay::StartRecording(const boost::filesystem::path& filepath, const MapIn
     // Deny overwrite, also avoids double-opening by different processes
     if(boost::filesystem::exists(filepath))
         return false;
+    BinaryBuffer header;
+    if(!WriteHeader(header, mapInfo))
+        return false;
     // Datei öffnen
     if(!file.Open(filepath, OFM_WRITE))
         return false;
 
     isRecording = true;
+    header.WriteToFile(file);
+    // Alles sofort reinschreiben
+    file.Flush();
+    // Everything else is written by the writer thread
+    writer_ = std::make_unique<ReplayWriter>(file, last_gf_file_pos, last_gf_file_pos + 4);
+
+    return true;
+}
+
+bool Replay::WriteHeader(BinaryBuffer& buffer, const MapInfo& mapInfo)
+{
+    if(mapInfo.type != MAPTYPE_OLDMAP && mapInfo.type != MAPTYPE_SAVEGAME)
+        return false;
     /// End-GF (erstmal nur 0, wird dann im Spiel immer geupdatet)
     lastGF_ = 0;
     mapType_ = mapInfo.type;
 
-    // Write header
-    WriteAllHeaderData(file, mapInfo.title);
+    WriteAllHeaderData(buffer, mapInfo.title);
 
-    file.WriteUnsignedShort(static_cast<unsigned short>(mapType_));
+    buffer.WriteUnsignedShort(static_cast<unsigned short>(mapType_));
     // For validation purposes
     if(mapType_ == MAPTYPE_SAVEGAME)
-        mapInfo.savegame->WriteFileHeader(file);
+        mapInfo.savegame->WriteFileHeader(buffer);
 
     // Position merken für End-GF
-    last_gf_file_pos = file.Tell();
-    file.WriteUnsignedInt(lastGF_);
+    last_gf_file_pos = buffer.Tell();
+    buffer.WriteUnsignedInt(lastGF_);
+    // Position of the keyframe index, written at the end
+    indexFilePos_ = 0;
+    buffer.WriteUnsignedInt(indexFilePos_);
+    keyframes_.clear();
 
-    WritePlayerData(file);
-    WriteGGS(file);
+    WritePlayerData(buffer);
+    WriteGGS(buffer);
 
     // Game data
-    file.WriteUnsignedInt(random_init);
-    file.WriteLongString(mapInfo.filepath.string());
+    buffer.WriteUnsignedInt(random_init);
+    buffer.WriteLongString(mapInfo.filepath.string());
 
-    switch(mapType_)
+    if(mapType_ == MAPTYPE_OLDMAP)
     {
-        default: return false;
-        case MAPTYPE_OLDMAP:
-            RTTR_Assert(!mapInfo.savegame);
-            // Map-Daten
-            file.WriteUnsignedInt(mapInfo.mapData.length);
-            file.WriteUnsignedInt(mapInfo.mapData.data.size());
-            file.WriteRawData(&mapInfo.mapData.data[0], mapInfo.mapData.data.size());
-            file.WriteUnsignedInt(mapInfo.luaData.length);
-            file.WriteUnsignedInt(mapInfo.luaData.data.size());
-            if(!mapInfo.luaData.data.empty())
-                file.WriteRawData(&mapInfo.luaData.data[0], mapInfo.luaData.data.size());
-            break;
-        case MAPTYPE_SAVEGAME: mapInfo.savegame->Save(file, GetMapName()); break;
-    }
-    // Alles sofort reinschreiben
-    file.Flush();
-
+        RTTR_Assert(!mapInfo.savegame);
+        // Map-Daten
+        buffer.WriteUnsignedInt(mapInfo.mapData.length);
+        buffer.WriteUnsignedInt(mapInfo.mapData.data.size());
+        buffer.WriteRawData(mapInfo.mapData.data.data(), mapInfo.mapData.data.size());
+        buffer.WriteUnsignedInt(mapInfo.luaData.length);
+        buffer.WriteUnsignedInt(mapInfo.luaData.data.size());
+        buffer.WriteRawData(mapInfo.luaData.data.data(), mapInfo.luaData.data.size());
+    } else
+        mapInfo.savegame->Save(buffer, GetMapName());
     return true;
 }
 
@@ -139,6 +170,8 @@ bool Replay::LoadHeader(const boost::filesystem::path& filepath, bool loadSettin
         }
 
         lastGF_ = file.ReadUnsignedInt();
+        indexFilePos_ = file.ReadUnsignedInt();
+        keyframes_.clear();
 
         if(loadSettings)
         {
@@ -187,6 +220,9 @@ bool Replay::LoadGameData(MapInfo& mapInfo)
                 }
                 break;
         }
+        commandsFilePos_ = file.Tell();
+        reader_.Open(file.getFilePath(), commandsFilePos_, lastGF_);
+        LoadKeyframeIndex();
     } catch(std::runtime_error& e)
     {
         lastErrorMsg = e.what();
@@ -195,91 +231,138 @@ bool Replay::LoadGameData(MapInfo& mapInfo)
     return true;
 }
 
+void Replay::LoadKeyframeIndex()
+{
+    keyframes_.clear();
+    if(indexFilePos_)
+    {
+        file.Seek(indexFilePos_, SEEK_SET);
+        keyframes_.resize(file.ReadUnsignedInt());
+        for(ReplayKeyframe& keyframe : keyframes_)
+        {
+            keyframe.gf = file.ReadUnsignedInt();
+            keyframe.filePos = file.ReadUnsignedInt();
+        }
+    } else
+    {
+        // No index (e.g. recording was aborted) -> Use the keyframes found in the commands
+        for(const ReplayCommandInfo& cmd : reader_.GetCommands())
+        {
+            if(cmd.type == ReplayCommand::Keyframe)
+                keyframes_.push_back(ReplayKeyframe{cmd.gf, cmd.filePos});
+        }
+    }
+}
+
 void Replay::AddChatCommand(unsigned gf, uint8_t player, uint8_t dest, const std::string& str)
 {
     RTTR_Assert(IsRecording());
-    if(!file.IsValid())
+    if(!writer_)
         return;
 
-    file.WriteUnsignedInt(gf);
-
-    file.WriteUnsignedChar(static_cast<uint8_t>(ReplayCommand::Chat));
-    file.WriteUnsignedChar(player);
-    file.WriteUnsignedChar(dest);
-    file.WriteLongString(str);
-
-    // Sofort rein damit
-    file.Flush();
+    writer_->AddChatCommand(gf, player, dest, str);
 }
 
 void Replay::AddGameCommand(unsigned gf, uint8_t player, const PlayerGameCommands& cmds)
 {
     RTTR_Assert(IsRecording());
-    if(!file.IsValid())
+    if(!writer_)
         return;
 
-    file.WriteUnsignedInt(gf);
+    writer_->AddGameCommand(gf, player, cmds);
+}
 
-    file.WriteUnsignedChar(static_cast<uint8_t>(ReplayCommand::Game));
-    Serializer ser;
-    ser.PushUnsignedChar(player);
-    cmds.Serialize(ser);
-    ser.WriteToFile(file);
+void Replay::AddKeyframe(unsigned gf, const UsedPRNG& rngState, const SerializedGameData& sgd)
+{
+    RTTR_Assert(IsRecording());
+    if(!writer_)
+        return;
 
-    // Sofort rein damit
-    file.Flush();
+    Serializer rngSer;
+    rngState.serialize(rngSer);
+    writer_->AddKeyframe(gf, std::move(rngSer), std::vector<uint8_t>(sgd.GetData(), sgd.GetData() + sgd.GetLength()));
 }
 
 bool Replay::ReadGF(unsigned* gf)
 {
     RTTR_Assert(IsReplaying());
-    try
-    {
-        *gf = file.ReadUnsignedInt();
-    } catch(std::runtime_error&)
-    {
-        *gf = 0xFFFFFFFF;
-        if(file.EndOfFile())
-            return false;
-        throw;
-    }
-    return true;
+    return reader_.ReadGF(gf);
 }
 
 ReplayCommand Replay::ReadRCType()
 {
     RTTR_Assert(IsReplaying());
-    // Type auslesen
-    return ReplayCommand(file.ReadUnsignedChar());
+    return reader_.ReadRCType();
 }
 
 void Replay::ReadChatCommand(uint8_t& player, uint8_t& dest, std::string& str)
 {
     RTTR_Assert(IsReplaying());
-    player = file.ReadUnsignedChar();
-    dest = file.ReadUnsignedChar();
-    str = file.ReadLongString();
+    reader_.ReadChatCommand(player, dest, str);
 }
 
 void Replay::ReadGameCommand(uint8_t& player, PlayerGameCommands& cmds)
 {
     RTTR_Assert(IsReplaying());
-    Serializer ser;
-    ser.ReadFromFile(file);
-    player = ser.PopUnsignedChar();
-    cmds.Deserialize(ser);
+    reader_.ReadGameCommand(player, cmds);
+}
+
+void Replay::SkipKeyframe()
+{
+    RTTR_Assert(IsReplaying());
+    RTTR_Assert(reader_.ReadRCType() == ReplayCommand::Keyframe);
+    reader_.SkipCommand();
+}
+
+const ReplayKeyframe* Replay::FindKeyframe(unsigned gf) const
+{
+    const auto it = std::upper_bound(keyframes_.begin(), keyframes_.end(), gf,
+                                     [](unsigned gf, const ReplayKeyframe& keyframe) { return gf < keyframe.gf; });
+    return (it == keyframes_.begin()) ? nullptr : &*std::prev(it);
+}
+
+bool Replay::ReadKeyframe(const ReplayKeyframe& keyframe, UsedPRNG& rngState, SerializedGameData& sgd)
+{
+    RTTR_Assert(IsReplaying());
+    const unsigned oldPos = reader_.Tell();
+    try
+    {
+        unsigned gf;
+        if(!reader_.Seek(keyframe.filePos) || !ReadGF(&gf) || gf != keyframe.gf
+           || ReadRCType() != ReplayCommand::Keyframe)
+            throw std::runtime_error(_("Invalid keyframe"));
+        Serializer rngSer;
+        CompressedData compressed;
+        reader_.ReadKeyframe(rngSer, compressed);
+        std::vector<char> snapshot;
+        if(!compressed.DecompressToBuffer(snapshot))
+            throw std::runtime_error(_("Invalid keyframe"));
+        rngState.deserialize(rngSer);
+        sgd.Clear();
+        sgd.PushRawData(snapshot.data(), snapshot.size());
+    } catch(std::runtime_error& e)
+    {
+        lastErrorMsg = e.what();
+        reader_.Seek(oldPos);
+        return false;
+    }
+    return true;
 }
 
 void Replay::UpdateLastGF(unsigned last_gf)
 {
     RTTR_Assert(IsRecording());
-    if(!file.IsValid())
+    if(!writer_)
         return;
 
-    // An die Stelle springen
-    file.Seek(last_gf_file_pos, SEEK_SET);
-    // Dorthin schreiben
-    file.WriteUnsignedInt(last_gf);
-    // Wieder ans Ende springen
-    file.Seek(0, SEEK_END);
+    lastGF_ = last_gf;
+    // Written to the file by the writer as soon as all commands up to this GF are on disk
+    writer_->CommitGF(last_gf);
+}
+
+void Replay::Flush(bool waitForCompletion)
+{
+    RTTR_Assert(IsRecording());
+    if(writer_)
+        writer_->Flush(waitForCompletion);
 }
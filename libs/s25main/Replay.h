@@ -17,12 +17,19 @@
 
 #pragma once
 
+#include "ReplayCommandReader.h"
 #include "SavedFile.h"
 #include "gameTypes/MapType.h"
+#include "random/Random.h"
 #include "s25util/BinaryFile.h"
+#include <memory>
 #include <string>
+#include <vector>
 
+class BinaryBuffer;
 class MapInfo;
+class ReplayWriter;
+class SerializedGameData;
 struct PlayerGameCommands;
 
 /// Replay-Command-Art
@@ -30,7 +37,16 @@ enum class ReplayCommand
 {
     End,
     Chat,
-    Game
+    Game,
+    Keyframe
+};
+
+/// Snapshot of the game stored in the replay from which playback can be started
+struct ReplayKeyframe
+{
+    unsigned gf;
+    /// Start of the keyframe in the file
+    unsigned filePos;
 };
 
 /// Holds a replay that is being recorded or was recorded and loaded
@@ -38,9 +54,16 @@ enum class ReplayCommand
 ///     File header (version etc.), record time, map name, player names, length (last GF), savegame header (if
 ///     applicable)
 /// All game relevant data is stored afterwards
+/// While recording commands are written by a background thread (see ReplayWriter)
+/// When replaying the commands are read from a memory mapping of the file (see ReplayCommandReader)
+/// Optionally keyframes (snapshots of the game) can be stored in between for seeking.
+/// An index of them is stored at the end of the file and referenced in the header
 class Replay : public SavedFile
 {
 public:
+    /// GF of the end marker after the last command
+    static constexpr unsigned END_GF = 0xFFFFFFFF;
+
     Replay();
     ~Replay() override;
 
@@ -53,10 +76,13 @@ public:
     bool StartRecording(const boost::filesystem::path& filepath, const MapInfo& mapInfo);
     /// Räumt auf, schließt datei
     void StopRecording();
+    /// Write the header (everything before the commands) as StartRecording does, but without creating a file.
+    /// The last GF and the keyframe index position are 0 as in a replay whose recording just started
+    bool WriteHeader(BinaryBuffer& buffer, const MapInfo& mapInfo);
 
     /// Replaydatei gültig?
     bool IsValid() const { return file.IsValid(); }
-    bool IsRecording() const { return isRecording && file.IsValid(); }
+    bool IsRecording() const;
     bool IsReplaying() const { return !isRecording && file.IsValid(); }
 
     /// Loads the header and optionally the mapInfo (former "extended header")
@@ -76,11 +102,29 @@ public:
     void ReadChatCommand(uint8_t& player, uint8_t& dest, std::string& str);
     void ReadGameCommand(uint8_t& player, PlayerGameCommands& cmds);
 
+    /// Add a snapshot of the game at the start of the given GF (writes)
+    void AddKeyframe(unsigned gf, const UsedPRNG& rngState, const SerializedGameData& sgd);
+    /// Skip a keyframe found while reading the commands
+    void SkipKeyframe();
+    /// Return all keyframes ordered by GF
+    const std::vector<ReplayKeyframe>& GetKeyframes() const { return keyframes_; }
+    /// Return the last keyframe at or before the given GF or nullptr if there is none
+    const ReplayKeyframe* FindKeyframe(unsigned gf) const;
+    /// Load the keyframe and continue reading the commands after it. On failure the read position is unchanged
+    bool ReadKeyframe(const ReplayKeyframe& keyframe, UsedPRNG& rngState, SerializedGameData& sgd);
+    /// Return the GF, type and position of all commands up to the last GF (only when replaying)
+    const std::vector<ReplayCommandInfo>& GetCommands() const { return reader_.GetCommands(); }
+
     /// Aktualisiert den End-GF, schreibt ihn in die Replaydatei (nur beim Spielen bzw. Schreiben verwenden!)
+    /// All commands added so far are considered complete and will be written with this GF
     void UpdateLastGF(unsigned last_gf);
+    /// Write all commands up to the last GF to disk (asynchronously unless waitForCompletion is set)
+    void Flush(bool waitForCompletion = false);
 
     BinaryFile& GetFile() { return file; }
     unsigned GetLastGF() const { return lastGF_; }
+    /// Position of the last GF in the file header (only set when recording or after WriteHeader)
+    unsigned GetLastGFFilePos() const { return last_gf_file_pos; }
 
     /// Zufallsgeneratorinitialisierung
     unsigned random_init;
@@ -93,4 +137,16 @@ protected:
     /// Position des End-GF in der Datei
     unsigned last_gf_file_pos;
     MapType mapType_;
+    std::unique_ptr<ReplayWriter> writer_;
+
+private:
+    /// Read the stored keyframe index or create it from the commands if there is none
+    void LoadKeyframeIndex();
+
+    /// Position of the keyframe index, 0 if none was written
+    unsigned indexFilePos_;
+    /// Position of the first command
+    unsigned commandsFilePos_;
+    std::vector<ReplayKeyframe> keyframes_;
+    ReplayCommandReader reader_;
 };
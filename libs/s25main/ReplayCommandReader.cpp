@@ -0,0 +1,199 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#include "ReplayCommandReader.h"
+#include "Replay.h"
+#include "network/PlayerGameCommands.h"
+#include "gameTypes/CompressedData.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+/// Read an unsigned int in the (little endian) format used by BinaryFile
+uint32_t GetUnsignedInt(const uint8_t* data)
+{
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8)
+           | (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+/// Size of the GF and type at the start of each command
+constexpr unsigned COMMAND_HEADER_SIZE = 5;
+} // namespace
+
+ReplayCommandReader::ReplayCommandReader() : data_(nullptr), curCommand_(0), endPos_(0) {}
+
+void ReplayCommandReader::Open(const boost::filesystem::path& filepath, unsigned commandsFilePos, unsigned lastGF)
+{
+    Close();
+    try
+    {
+        file_.open(filepath);
+    } catch(const std::exception& e)
+    {
+        throw std::runtime_error(std::string("Could not map replay file: ") + e.what());
+    }
+    data_ = reinterpret_cast<const uint8_t*>(file_.data());
+
+    const uint64_t fileSize = file_.size();
+    unsigned pos = commandsFilePos;
+    while(pos + COMMAND_HEADER_SIZE <= fileSize)
+    {
+        const unsigned gf = GetUnsignedInt(data_ + pos);
+        // Also stops at the end marker
+        if(gf > lastGF)
+            break;
+        const auto type = static_cast<ReplayCommand>(data_[pos + 4]);
+        const unsigned dataSize = GetCommandDataSize(type, pos + COMMAND_HEADER_SIZE);
+        // Invalid or incomplete command at the end (e.g. recording was aborted). Everything before is usable
+        if(!dataSize)
+            break;
+        commands_.push_back(ReplayCommandInfo{gf, type, pos});
+        pos += COMMAND_HEADER_SIZE + dataSize;
+    }
+    endPos_ = pos;
+}
+
+void ReplayCommandReader::Close()
+{
+    if(file_.is_open())
+        file_.close();
+    data_ = nullptr;
+    commands_.clear();
+    curCommand_ = 0;
+    endPos_ = 0;
+}
+
+unsigned ReplayCommandReader::GetCommandDataSize(ReplayCommand type, unsigned dataPos) const
+{
+    const uint64_t fileSize = file_.size();
+    uint64_t pos = dataPos;
+    // Skip a block of data prefixed by its size
+    const auto skipBlock = [this, fileSize, &pos]() {
+        if(pos + 4 > fileSize)
+            return false;
+        pos += 4 + GetUnsignedInt(data_ + pos);
+        return pos <= fileSize;
+    };
+    switch(type)
+    {
+        case ReplayCommand::Chat:
+            // Player, destination and the text
+            pos += 2;
+            if(!skipBlock())
+                return 0;
+            break;
+        case ReplayCommand::Game:
+            if(!skipBlock())
+                return 0;
+            break;
+        case ReplayCommand::Keyframe:
+            // RNG state, uncompressed size and the compressed snapshot
+            if(!skipBlock())
+                return 0;
+            pos += 4;
+            if(!skipBlock())
+                return 0;
+            break;
+        default: return 0;
+    }
+    return static_cast<unsigned>(pos - dataPos);
+}
+
+unsigned ReplayCommandReader::Tell() const
+{
+    return (curCommand_ < commands_.size()) ? commands_[curCommand_].filePos : endPos_;
+}
+
+bool ReplayCommandReader::Seek(unsigned filePos)
+{
+    if(filePos == endPos_)
+    {
+        curCommand_ = commands_.size();
+        return true;
+    }
+    const auto it = std::lower_bound(commands_.begin(), commands_.end(), filePos,
+                                     [](const ReplayCommandInfo& cmd, unsigned pos) { return cmd.filePos < pos; });
+    if(it == commands_.end() || it->filePos != filePos)
+        return false;
+    curCommand_ = static_cast<size_t>(it - commands_.begin());
+    return true;
+}
+
+bool ReplayCommandReader::ReadGF(unsigned* gf) const
+{
+    if(curCommand_ >= commands_.size())
+    {
+        *gf = Replay::END_GF;
+        return false;
+    }
+    *gf = commands_[curCommand_].gf;
+    return true;
+}
+
+ReplayCommand ReplayCommandReader::ReadRCType() const
+{
+    if(curCommand_ >= commands_.size())
+        return ReplayCommand::End;
+    return commands_[curCommand_].type;
+}
+
+const uint8_t* ReplayCommandReader::PopCommandData(ReplayCommand expectedType)
+{
+    if(curCommand_ >= commands_.size() || commands_[curCommand_].type != expectedType)
+        throw std::runtime_error("Invalid replay command");
+    return data_ + commands_[curCommand_++].filePos + COMMAND_HEADER_SIZE;
+}
+
+void ReplayCommandReader::ReadChatCommand(uint8_t& player, uint8_t& dest, std::string& str)
+{
+    const uint8_t* data = PopCommandData(ReplayCommand::Chat);
+    player = data[0];
+    dest = data[1];
+    const unsigned length = GetUnsignedInt(data + 2);
+    const auto* text = reinterpret_cast<const char*>(data + 6);
+    // The stored string may include the terminating NULL
+    str.assign(text, std::find(text, text + length, '\0'));
+}
+
+void ReplayCommandReader::ReadGameCommand(uint8_t& player, PlayerGameCommands& cmds)
+{
+    const uint8_t* data = PopCommandData(ReplayCommand::Game);
+    // Copy as the commands can only be deserialized from a Serializer
+    ser_.Clear();
+    ser_.PushRawData(data + 4, GetUnsignedInt(data));
+    player = ser_.PopUnsignedChar();
+    cmds.Deserialize(ser_);
+}
+
+void ReplayCommandReader::ReadKeyframe(Serializer& rngState, CompressedData& snapshot)
+{
+    const uint8_t* data = PopCommandData(ReplayCommand::Keyframe);
+    const unsigned rngSize = GetUnsignedInt(data);
+    data += 4;
+    rngState.Clear();
+    rngState.PushRawData(data, rngSize);
+    data += rngSize;
+    snapshot.length = GetUnsignedInt(data);
+    const unsigned compressedSize = GetUnsignedInt(data + 4);
+    data += 8;
+    snapshot.data.assign(data, data + compressedSize);
+}
+
+void ReplayCommandReader::SkipCommand()
+{
+    if(curCommand_ < commands_.size())
+        ++curCommand_;
+}
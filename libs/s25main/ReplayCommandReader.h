@@ -0,0 +1,88 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "s25util/Serializer.h"
+#include <boost/filesystem/path.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct CompressedData;
+enum class ReplayCommand;
+struct PlayerGameCommands;
+
+/// Position of a command in a replay file
+struct ReplayCommandInfo
+{
+    unsigned gf;
+    ReplayCommand type;
+    /// Start of the command (its GF) in the file
+    unsigned filePos;
+};
+
+/// Reads the commands of a replay from the memory mapped file.
+/// When opened an index of all complete commands up to the last GF is built, so reading them later requires no file
+/// access at all and the commands can be accessed in any order. Chat commands and keyframes are read directly from the
+/// mapping, game commands are copied into a reused Serializer to deserialize them.
+class ReplayCommandReader
+{
+public:
+    ReplayCommandReader();
+
+    /// Map the file and index the commands starting at commandsFilePos. Commands after lastGF are ignored.
+    /// Throws on error
+    void Open(const boost::filesystem::path& filepath, unsigned commandsFilePos, unsigned lastGF);
+    void Close();
+    bool IsOpen() const { return file_.is_open(); }
+
+    /// Return all commands in the order they are stored
+    const std::vector<ReplayCommandInfo>& GetCommands() const { return commands_; }
+    /// Return the position of the next command or the end of the commands
+    unsigned Tell() const;
+    /// Continue reading at the command at the given position (as returned by Tell). False if there is none
+    bool Seek(unsigned filePos);
+
+    /// Read the GF of the next command. Returns false at the end
+    bool ReadGF(unsigned* gf) const;
+    /// Return the type of the next command
+    ReplayCommand ReadRCType() const;
+    void ReadChatCommand(uint8_t& player, uint8_t& dest, std::string& str);
+    void ReadGameCommand(uint8_t& player, PlayerGameCommands& cmds);
+    void ReadKeyframe(Serializer& rngState, CompressedData& snapshot);
+    /// Skip the next command of any type
+    void SkipCommand();
+
+private:
+    /// Return the size of the command data after the type or 0 if the command is invalid or incomplete
+    unsigned GetCommandDataSize(ReplayCommand type, unsigned dataPos) const;
+    /// Return the data of the next command and advance to the one after it
+    const uint8_t* PopCommandData(ReplayCommand expectedType);
+
+    boost::iostreams::mapped_file_source file_;
+    const uint8_t* data_;
+    std::vector<ReplayCommandInfo> commands_;
+    /// Index of the next command
+    size_t curCommand_;
+    /// Position after the last indexed command
+    unsigned endPos_;
+    /// Reused for deserializing game commands. The Serializer cannot read from external memory, so the data of each
+    /// game command is copied into it (no allocation once the buffer has grown to the biggest command)
+    Serializer ser_;
+};
@@ -18,12 +18,14 @@
 #pragma once
 
 #include "Replay.h"
+#include "random/Random.h"
 #include <boost/filesystem/path.hpp>
+#include <boost/optional.hpp>
 #include <string>
 
 struct ReplayInfo
 {
-    ReplayInfo() : async(0), end(false), next_gf(0), all_visible(false) {}
+    ReplayInfo() : async(0), end(false), next_gf(0), all_visible(false), seekTargetGF(0) {}
 
     /// Replaydatei
     Replay replay;
@@ -35,4 +37,8 @@ struct ReplayInfo
     unsigned next_gf;
     /// Alles sichtbar (FoW deaktiviert)
     bool all_visible;
+    /// RNG state to restore when the game was started from a keyframe
+    boost::optional<UsedPRNG> keyframeRngState;
+    /// GF to skip to after the game was started from a keyframe (0 = none)
+    unsigned seekTargetGF;
 };
@@ -0,0 +1,177 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#include "ReplayRunner.h"
+#include "EventManager.h"
+#include "GFProfiler.h"
+#include "Game.h"
+#include "PlayerInfo.h"
+#include "Savegame.h"
+#include "SerializedGameData.h"
+#include "helpers/format.hpp"
+#include "network/PlayerGameCommands.h"
+#include "random/Random.h"
+#include "world/GameWorld.h"
+#include "gameTypes/MapInfo.h"
+#include "gameData/GameConsts.h"
+#include "s25util/Log.h"
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+namespace bfs = boost::filesystem;
+
+ReplayRunner::ReplayRunner() : nextGF_(0) {}
+
+ReplayRunner::~ReplayRunner()
+{
+    // Release the game before the files it might still reference
+    game_.reset();
+    boost::system::error_code ec;
+    if(!mapFilePath_.empty())
+        bfs::remove(mapFilePath_, ec);
+    if(!luaFilePath_.empty())
+        bfs::remove(luaFilePath_, ec);
+}
+
+bool ReplayRunner::Load(const boost::filesystem::path& replayPath)
+{
+    RTTR_Assert(!game_);
+    MapInfo mapInfo;
+    if(!replay_.LoadHeader(replayPath, true) || !replay_.LoadGameData(mapInfo))
+    {
+        lastErrorMsg_ = replay_.GetLastErrorMsg();
+        return false;
+    }
+
+    try
+    {
+        RANDOM.Init(replay_.random_init);
+
+        std::vector<PlayerInfo> players;
+        for(unsigned i = 0; i < replay_.GetNumPlayers(); ++i)
+            players.push_back(PlayerInfo(replay_.GetPlayer(i)));
+
+        const unsigned startGF = mapInfo.savegame ? mapInfo.savegame->start_gf : 0;
+        game_ = std::make_shared<Game>(replay_.ggs, startGF, players);
+        GameWorld& gameWorld = game_->world_;
+        if(mapInfo.savegame)
+            mapInfo.savegame->sgd.ReadSnapshot(game_, *this);
+        else
+        {
+            const bfs::path basePath = bfs::temp_directory_path() / bfs::unique_path("rttrReplay-%%%%-%%%%-%%%%");
+            mapFilePath_ = bfs::path(basePath).replace_extension(mapInfo.filepath.extension());
+            if(!mapInfo.mapData.DecompressToFile(mapFilePath_))
+                throw std::runtime_error("Error decompressing map file");
+            if(mapInfo.luaData.length)
+            {
+                luaFilePath_ = bfs::path(basePath).replace_extension("lua");
+                if(!mapInfo.luaData.DecompressToFile(luaFilePath_))
+                    throw std::runtime_error("Error decompressing lua file");
+            }
+            if(!gameWorld.LoadMap(game_, *this, mapFilePath_, luaFilePath_))
+                throw std::runtime_error("Error loading map");
+        }
+        gameWorld.InitAfterLoad();
+        game_->Start(!!mapInfo.savegame);
+
+        replay_.ReadGF(&nextGF_);
+    } catch(const std::exception& e)
+    {
+        lastErrorMsg_ = e.what();
+        game_.reset();
+        return false;
+    }
+    return true;
+}
+
+unsigned ReplayRunner::Run(const unsigned targetGF, const bool stopOnAsync)
+{
+    RTTR_Assert(game_);
+    const unsigned startGF = GetCurrentGF();
+    while(GetCurrentGF() < targetGF && !IsFinished())
+    {
+        ExecuteGF();
+        if(stopOnAsync && firstAsyncGF_)
+            break;
+    }
+    return GetCurrentGF() - startGF;
+}
+
+unsigned ReplayRunner::GetCurrentGF() const
+{
+    return game_->em_->GetCurrentGF();
+}
+
+void ReplayRunner::ExecuteGF()
+{
+    // Same as GameClient::ExecuteGameFrame_Replay
+    const AsyncChecksum checksum = AsyncChecksum::create(*game_);
+    const unsigned curGF = GetCurrentGF();
+
+    while(nextGF_ == curGF)
+    {
+        switch(replay_.ReadRCType())
+        {
+            case ReplayCommand::Chat:
+            {
+                uint8_t player, dest;
+                std::string message;
+                replay_.ReadChatCommand(player, dest, message);
+                break;
+            }
+            case ReplayCommand::Game:
+            {
+                PlayerGameCommands cmds;
+                uint8_t gcPlayer;
+                replay_.ReadGameCommand(gcPlayer, cmds);
+                for(const gc::GameCommandPtr& gc : cmds.gcs)
+                    gc->Execute(game_->world_, gcPlayer);
+                if(!firstAsyncGF_ && cmds.checksum.randChecksum != 0 && cmds.checksum != checksum)
+                {
+                    firstAsyncGF_ = curGF;
+                    expectedChecksum_ = cmds.checksum;
+                    actualChecksum_ = checksum;
+                    asyncLog_ = RANDOM.GetAsyncLog();
+                }
+                break;
+            }
+            case ReplayCommand::Keyframe: replay_.SkipKeyframe(); break;
+            default: throw std::runtime_error("Invalid replay command");
+        }
+        replay_.ReadGF(&nextGF_);
+    }
+
+    GFPROFILER.StartGF(curGF);
+    game_->RunGF();
+    GFPROFILER.EndGF();
+}
+
+std::string ReplayRunner::FormatGFTime(const unsigned numGFs) const
+{
+    using seconds = std::chrono::duration<uint32_t, std::chrono::seconds::period>;
+    const auto numSeconds = std::chrono::duration_cast<seconds>(
+      numGFs * std::chrono::milliseconds(SPEED_GF_LENGTHS[replay_.ggs.speed]));
+    const unsigned totalSeconds = numSeconds.count();
+    return helpers::format("%02u:%02u:%02u", totalSeconds / 3600, (totalSeconds / 60) % 60, totalSeconds % 60);
+}
+
+void ReplayRunner::SystemChat(const std::string& text)
+{
+    LOG.write("GF %1%: %2%\n", LogTarget::Stdout) % GetCurrentGF() % text;
+}
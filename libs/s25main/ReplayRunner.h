@@ -0,0 +1,80 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "AsyncChecksum.h"
+#include "ILocalGameState.h"
+#include "Replay.h"
+#include "random/Random.h"
+#include <boost/filesystem/path.hpp>
+#include <boost/optional.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Game;
+
+/// Plays a replay without any GUI, network or timing as fast as possible (e.g. for benchmarks or checking for asyncs).
+/// Does the same as the GameClient in replay mode.
+/// Note: As game objects use global state only one game can be run per process.
+class ReplayRunner final : public ILocalGameState
+{
+public:
+    ReplayRunner();
+    ~ReplayRunner();
+
+    /// Load the replay and create the game from it. Return false on error (see GetLastErrorMsg)
+    bool Load(const boost::filesystem::path& replayPath);
+    /// Execute GFs till the target GF or the end of the replay is reached. Returns the number of GFs executed.
+    /// If stopOnAsync is true, stop after the GF at which the first async was detected
+    unsigned Run(unsigned targetGF, bool stopOnAsync = false);
+
+    /// Return the GF that will be executed next
+    unsigned GetCurrentGF() const;
+    /// Return the last GF stored in the replay
+    unsigned GetLastGF() const { return replay_.GetLastGF(); }
+    /// True if all GFs of the replay were executed
+    bool IsFinished() const { return GetCurrentGF() > GetLastGF(); }
+    /// Return the GF at which the first async was detected (if any)
+    const boost::optional<unsigned>& GetFirstAsyncGF() const { return firstAsyncGF_; }
+    /// Checksums stored in the replay and calculated by us at the first async
+    const AsyncChecksum& GetExpectedChecksum() const { return expectedChecksum_; }
+    const AsyncChecksum& GetActualChecksum() const { return actualChecksum_; }
+    /// Log of the last random numbers generated when the first async was detected
+    const std::vector<RandomEntry>& GetAsyncLog() const { return asyncLog_; }
+    const std::string& GetLastErrorMsg() const { return lastErrorMsg_; }
+
+    unsigned GetPlayerId() const override { return 0; }
+    bool IsHost() const override { return false; }
+    std::string FormatGFTime(unsigned numGFs) const override;
+    void SystemChat(const std::string& text) override;
+
+private:
+    void ExecuteGF();
+
+    Replay replay_;
+    std::shared_ptr<Game> game_;
+    /// Temporary map and lua files
+    boost::filesystem::path mapFilePath_, luaFilePath_;
+    /// GF of the next command in the replay
+    unsigned nextGF_;
+    boost::optional<unsigned> firstAsyncGF_;
+    AsyncChecksum expectedChecksum_, actualChecksum_;
+    std::vector<RandomEntry> asyncLog_;
+    std::string lastErrorMsg_;
+};
@@ -0,0 +1,207 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#include "ReplayWriter.h"
+#include "Replay.h"
+#include "TraceRecorder.h"
+#include "gameTypes/CompressedData.h"
+#include "network/PlayerGameCommands.h"
+#include "s25util/BinaryFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <stdexcept>
+
+ReplayWriter::ReplayWriter(BinaryFile& file, unsigned lastGFFilePos, unsigned indexFilePos,
+                           std::chrono::milliseconds flushInterval)
+    : file_(file), lastGFFilePos_(lastGFFilePos), indexFilePos_(indexFilePos), flushInterval_(flushInterval), lastCommittedGF_(0),
+      pendingLastGF_(0), hasPendingData_(false), stopRequested_(false), isStopped_(false), flushRequestId_(0),
+      flushedId_(0), failed_(false)
+{
+    thread_ = std::thread(&ReplayWriter::Run, this);
+}
+
+ReplayWriter::~ReplayWriter()
+{
+    Stop();
+}
+
+void ReplayWriter::AddChatCommand(unsigned gf, uint8_t player, uint8_t dest, const std::string& str)
+{
+    if(failed_)
+        return;
+    curCommands_.push_back(Command{gf, ReplayCommand::Chat, Serializer(), {}});
+    Serializer& ser = curCommands_.back().data;
+    ser.PushUnsignedChar(player);
+    ser.PushUnsignedChar(dest);
+    ser.PushLongString(str);
+}
+
+void ReplayWriter::AddGameCommand(unsigned gf, uint8_t player, const PlayerGameCommands& cmds)
+{
+    if(failed_)
+        return;
+    curCommands_.push_back(Command{gf, ReplayCommand::Game, Serializer(), {}});
+    Serializer& ser = curCommands_.back().data;
+    ser.PushUnsignedChar(player);
+    cmds.Serialize(ser);
+}
+
+void ReplayWriter::AddKeyframe(unsigned gf, Serializer rngState, std::vector<uint8_t> snapshot)
+{
+    if(failed_)
+        return;
+    curCommands_.push_back(Command{gf, ReplayCommand::Keyframe, std::move(rngState), std::move(snapshot)});
+}
+
+void ReplayWriter::CommitGF(unsigned gf)
+{
+    lastCommittedGF_ = gf;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(pendingCommands_.empty())
+        pendingCommands_.swap(curCommands_);
+    else
+    {
+        std::move(curCommands_.begin(), curCommands_.end(), std::back_inserter(pendingCommands_));
+        curCommands_.clear();
+    }
+    pendingLastGF_ = gf;
+    hasPendingData_ = true;
+}
+
+void ReplayWriter::Flush(bool waitForCompletion)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if(isStopped_)
+        return;
+    const unsigned requestId = ++flushRequestId_;
+    wakeUpCond_.notify_one();
+    if(waitForCompletion)
+        flushedCond_.wait(lock, [this, requestId] { return flushedId_ >= requestId || isStopped_; });
+}
+
+void ReplayWriter::Stop()
+{
+    if(!thread_.joinable())
+        return;
+    // Commands of an unfinished GF are still written but the last GF stays at the last committed one
+    if(!curCommands_.empty())
+        CommitGF(lastCommittedGF_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopRequested_ = true;
+    }
+    wakeUpCond_.notify_one();
+    thread_.join();
+}
+
+void ReplayWriter::Run()
+{
+    RTTR_TRACE_THREAD_NAME("ReplayWriter");
+    std::vector<Command> commands;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while(true)
+    {
+        wakeUpCond_.wait_for(lock, flushInterval_,
+                             [this] { return flushRequestId_ != flushedId_ || stopRequested_; });
+        const unsigned requestId = flushRequestId_;
+        if(hasPendingData_)
+        {
+            commands.swap(pendingCommands_);
+            const unsigned lastGF = pendingLastGF_;
+            hasPendingData_ = false;
+            lock.unlock();
+            if(!failed_)
+                WriteCommands(commands, lastGF);
+            commands.clear();
+            lock.lock();
+        }
+        flushedId_ = requestId;
+        flushedCond_.notify_all();
+        if(stopRequested_ && !hasPendingData_)
+            break;
+    }
+    if(!failed_)
+        WriteIndex();
+    isStopped_ = true;
+    flushedCond_.notify_all();
+}
+
+void ReplayWriter::WriteCommands(std::vector<Command>& commands, unsigned lastGF)
+{
+    RTTR_TRACE_SCOPE("ReplayWriter::WriteCommands");
+    try
+    {
+        for(Command& cmd : commands)
+        {
+            if(cmd.type == ReplayCommand::Keyframe)
+                keyframes_.emplace_back(cmd.gf, static_cast<unsigned>(file_.Tell()));
+            file_.WriteUnsignedInt(cmd.gf);
+            file_.WriteUnsignedChar(static_cast<uint8_t>(cmd.type));
+            if(cmd.type == ReplayCommand::Chat)
+            {
+                file_.WriteUnsignedChar(cmd.data.PopUnsignedChar());
+                file_.WriteUnsignedChar(cmd.data.PopUnsignedChar());
+                file_.WriteLongString(cmd.data.PopLongString());
+            } else if(cmd.type == ReplayCommand::Keyframe)
+            {
+                cmd.data.WriteToFile(file_);
+                CompressedData compressed;
+                if(!compressed.CompressFromBuffer(reinterpret_cast<const char*>(cmd.snapshot.data()),
+                                                  static_cast<unsigned>(cmd.snapshot.size())))
+                    throw std::runtime_error("Compressing keyframe failed");
+                file_.WriteUnsignedInt(compressed.length);
+                file_.WriteUnsignedInt(static_cast<unsigned>(compressed.data.size()));
+                file_.WriteRawData(compressed.data.data(), static_cast<unsigned>(compressed.data.size()));
+            } else
+                cmd.data.WriteToFile(file_);
+        }
+        // Make sure all commands are on disk before the header references them
+        file_.Flush();
+        file_.Seek(lastGFFilePos_, SEEK_SET);
+        file_.WriteUnsignedInt(lastGF);
+        file_.Seek(0, SEEK_END);
+        file_.Flush();
+    } catch(const std::runtime_error&)
+    {
+        failed_ = true;
+    }
+}
+
+void ReplayWriter::WriteIndex()
+{
+    try
+    {
+        file_.WriteUnsignedInt(Replay::END_GF);
+        file_.WriteUnsignedChar(static_cast<uint8_t>(ReplayCommand::End));
+        const auto indexPos = static_cast<unsigned>(file_.Tell());
+        file_.WriteUnsignedInt(static_cast<unsigned>(keyframes_.size()));
+        for(const auto& keyframe : keyframes_)
+        {
+            file_.WriteUnsignedInt(keyframe.first);
+            file_.WriteUnsignedInt(keyframe.second);
+        }
+        file_.Flush();
+        file_.Seek(indexFilePos_, SEEK_SET);
+        file_.WriteUnsignedInt(indexPos);
+        file_.Seek(0, SEEK_END);
+        file_.Flush();
+    } catch(const std::runtime_error&)
+    {
+        failed_ = true;
+    }
+}
@@ -0,0 +1,98 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "s25util/Serializer.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class BinaryFile;
+enum class ReplayCommand;
+struct PlayerGameCommands;
+
+/// Writes the commands of a replay that is being recorded from a background thread.
+/// The game thread only appends commands to an in-memory buffer. Once a GF is committed, all commands up to it are
+/// handed to the writer thread which writes and flushes them periodically or when requested (e.g. at each NWF).
+/// The last GF in the file header is only updated after the commands were flushed,
+/// so the file on disk is always consistent up to the stored last GF, even if the program crashes.
+/// Keyframes are compressed by the writer thread too. On stop an index of them is appended and referenced in the header.
+class ReplayWriter
+{
+public:
+    /// Start writing to the already opened file.
+    /// lastGFFilePos and indexFilePos are the positions of the last GF and keyframe index entries in the header
+    ReplayWriter(BinaryFile& file, unsigned lastGFFilePos, unsigned indexFilePos,
+                 std::chrono::milliseconds flushInterval = std::chrono::seconds(1));
+    ~ReplayWriter();
+
+    void AddChatCommand(unsigned gf, uint8_t player, uint8_t dest, const std::string& str);
+    void AddGameCommand(unsigned gf, uint8_t player, const PlayerGameCommands& cmds);
+    /// Add a keyframe. rngState is stored as-is, the snapshot gets compressed
+    void AddKeyframe(unsigned gf, Serializer rngState, std::vector<uint8_t> snapshot);
+    /// Mark all commands added so far as complete up to (and including) the given GF
+    void CommitGF(unsigned gf);
+    /// Let the writer thread write all committed commands now. Optionally wait till this is done
+    void Flush(bool waitForCompletion = false);
+    /// Write all remaining commands and stop the writer thread. The file can be closed afterwards
+    void Stop();
+    /// Return true if writing to the file failed. All further commands are discarded
+    bool HasFailed() const { return failed_; }
+
+private:
+    struct Command
+    {
+        unsigned gf;
+        ReplayCommand type;
+        Serializer data;
+        /// Uncompressed game data of a keyframe
+        std::vector<uint8_t> snapshot;
+    };
+
+    void Run();
+    /// Write the commands followed by updating the last GF. Called from the writer thread only
+    void WriteCommands(std::vector<Command>& commands, unsigned lastGF);
+    /// Write the end marker and the keyframe index. Called from the writer thread only
+    void WriteIndex();
+
+    BinaryFile& file_;
+    const unsigned lastGFFilePos_, indexFilePos_;
+    const std::chrono::milliseconds flushInterval_;
+    /// Commands of the current, not yet committed GF. Only accessed by the game thread
+    std::vector<Command> curCommands_;
+    unsigned lastCommittedGF_;
+
+    std::mutex mutex_;
+    std::condition_variable wakeUpCond_, flushedCond_;
+    /// Committed commands not yet written. Buffers are swapped with the writer thread so their memory is reused
+    std::vector<Command> pendingCommands_;
+    unsigned pendingLastGF_;
+    bool hasPendingData_, stopRequested_, isStopped_;
+    /// Ids of the last flush requested and the last one finished
+    unsigned flushRequestId_, flushedId_;
+    std::atomic<bool> failed_;
+    /// GF and file position of all keyframes written. Only accessed by the writer thread
+    std::vector<std::pair<unsigned, unsigned>> keyframes_;
+    std::thread thread_;
+};
@@ -17,6 +17,7 @@
 
 #include "SavedFile.h"
 #include "BasePlayerInfo.h"
+#include "BinaryBuffer.h"
 #include "RTTR_Version.h"
 #include "libendian/ConvertEndianess.h"
 #include "s25util/BinaryFile.h"
@@ -34,7 +35,7 @@ SavedFile::SavedFile() : saveTime_(0)
 
 SavedFile::~SavedFile() = default;
 
-void SavedFile::WriteFileHeader(BinaryFile& file) const
+void SavedFile::WriteFileHeader(BinaryBuffer& file) const
 {
     // Signature
     const std::string signature = GetSignature();
@@ -43,7 +44,7 @@ void SavedFile::WriteFileHeader(BinaryFile& file) const
     file.WriteUnsignedShort(GetVersion());
 }
 
-void SavedFile::WriteExtHeader(BinaryFile& file, const std::string& mapName)
+void SavedFile::WriteExtHeader(BinaryBuffer& file, const std::string& mapName)
 {
     // Store data in struct
     saveTime_ = s25util::Time::CurrentTime();
@@ -110,7 +111,7 @@ bool SavedFile::ReadExtHeader(BinaryFile& file)
     return true;
 }
 
-void SavedFile::WriteAllHeaderData(BinaryFile& file, const std::string& mapName)
+void SavedFile::WriteAllHeaderData(BinaryBuffer& file, const std::string& mapName)
 {
     // Versionszeug schreiben
     WriteFileHeader(file);
@@ -126,14 +127,14 @@ bool SavedFile::ReadAllHeaderData(BinaryFile& file)
     return true;
 }
 
-void SavedFile::WritePlayerData(BinaryFile& file)
+void SavedFile::WritePlayerData(BinaryBuffer& file)
 {
     Serializer ser;
     ser.PushUnsignedChar(players.size());
     for(const auto& player : players)
         player.Serialize(ser, true);
 
-    ser.WriteToFile(file);
+    file.WriteSerializer(ser);
 }
 
 void SavedFile::ReadPlayerData(BinaryFile& file)
@@ -150,11 +151,11 @@ void SavedFile::ReadPlayerData(BinaryFile& file)
 /**
  *  schreibt die GlobalGameSettings in die Datei.
  */
-void SavedFile::WriteGGS(BinaryFile& file) const
+void SavedFile::WriteGGS(BinaryBuffer& file) const
 {
     Serializer ser;
     ggs.Serialize(ser);
-    ser.WriteToFile(file);
+    file.WriteSerializer(ser);
 }
 
 /**
@@ -23,6 +23,7 @@
 #include <string>
 #include <vector>
 
+class BinaryBuffer;
 class BinaryFile;
 struct BasePlayerInfo;
 
@@ -39,24 +40,24 @@ public:
     virtual uint16_t GetVersion() const = 0;
 
     /// Schreibt Signatur und Version der Datei
-    void WriteFileHeader(BinaryFile& file) const;
+    void WriteFileHeader(BinaryBuffer& file) const;
     /// Reads and validates the file header. On error false is returned and lastErrorMsg is set
     bool ReadFileHeader(BinaryFile& file);
 
     /// Write common information (program version, map name, time and player names)
-    virtual void WriteExtHeader(BinaryFile& file, const std::string& mapName);
+    virtual void WriteExtHeader(BinaryBuffer& file, const std::string& mapName);
     virtual bool ReadExtHeader(BinaryFile& file);
 
-    void WriteAllHeaderData(BinaryFile& file, const std::string& mapName);
+    void WriteAllHeaderData(BinaryBuffer& file, const std::string& mapName);
     bool ReadAllHeaderData(BinaryFile& file);
 
     /// Schreibt Spielerdaten
-    void WritePlayerData(BinaryFile& file);
+    void WritePlayerData(BinaryBuffer& file);
     /// Liest Spielerdaten aus
     void ReadPlayerData(BinaryFile& file);
 
     /// schreibt die GlobalGameSettings in die Datei.
-    void WriteGGS(BinaryFile& file) const;
+    void WriteGGS(BinaryBuffer& file) const;
     /// liest die GlobalGameSettings aus der Datei.
     void ReadGGS(BinaryFile& file);
 
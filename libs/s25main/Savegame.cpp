@@ -16,6 +16,7 @@
 // along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
 
 #include "Savegame.h"
+#include "BinaryBuffer.h"
 #include "s25util/BinaryFile.h"
 
 std::string Savegame::GetSignature() const
@@ -38,18 +39,27 @@ Savegame::~Savegame() = default;
 bool Savegame::Save(const boost::filesystem::path& filepath, const std::string& mapName)
 {
     BinaryFile file;
+    if(!file.Open(filepath, OFM_WRITE))
+        return false;
+    BinaryBuffer header;
+    WriteHeader(header, mapName);
+    header.WriteToFile(file);
+    // Avoid copying the (big) game data into the buffer
+    sgd.WriteToFile(file);
+    return true;
+}
 
-    return file.Open(filepath, OFM_WRITE) && Save(file, mapName);
+void Savegame::Save(BinaryBuffer& file, const std::string& mapName)
+{
+    WriteHeader(file, mapName);
+    WriteGameData(file);
 }
 
-bool Savegame::Save(BinaryFile& file, const std::string& mapName)
+void Savegame::WriteHeader(BinaryBuffer& file, const std::string& mapName)
 {
     WriteAllHeaderData(file, mapName);
     WritePlayerData(file);
     WriteGGS(file);
-    WriteGameData(file);
-
-    return true;
 }
 
 bool Savegame::Load(const boost::filesystem::path& filePath, const SaveGameDataToLoad what)
@@ -87,7 +97,7 @@ bool Savegame::Load(BinaryFile& file, const SaveGameDataToLoad what)
     return true;
 }
 
-void Savegame::WriteExtHeader(BinaryFile& file, const std::string& mapName)
+void Savegame::WriteExtHeader(BinaryBuffer& file, const std::string& mapName)
 {
     SavedFile::WriteExtHeader(file, mapName);
     file.WriteUnsignedInt(start_gf);
@@ -101,9 +111,9 @@ bool Savegame::ReadExtHeader(BinaryFile& file)
     return true;
 }
 
-void Savegame::WriteGameData(BinaryFile& file)
+void Savegame::WriteGameData(BinaryBuffer& file)
 {
-    sgd.WriteToFile(file);
+    file.WriteSerializer(sgd);
 }
 
 bool Savegame::ReadGameData(BinaryFile& file)
@@ -21,6 +21,7 @@
 #include "SerializedGameData.h"
 #include <boost/filesystem/path.hpp>
 
+class BinaryBuffer;
 class BinaryFile;
 
 enum class SaveGameDataToLoad
@@ -41,13 +42,13 @@ public:
 
     /// Schreibst Savegame oder Teile davon
     bool Save(const boost::filesystem::path& filepath, const std::string& mapName);
-    bool Save(BinaryFile& file, const std::string& mapName);
+    void Save(BinaryBuffer& file, const std::string& mapName);
 
     /// Lädt Savegame oder Teile davon
     bool Load(const boost::filesystem::path& filePath, SaveGameDataToLoad what);
     bool Load(BinaryFile& file, SaveGameDataToLoad what);
 
-    void WriteExtHeader(BinaryFile& file, const std::string& mapName) override;
+    void WriteExtHeader(BinaryBuffer& file, const std::string& mapName) override;
     bool ReadExtHeader(BinaryFile& file) override;
 
     /// Start-GF
@@ -56,6 +57,8 @@ public:
     SerializedGameData sgd;
 
 protected:
-    void WriteGameData(BinaryFile& file);
+    /// Write everything but the game data
+    void WriteHeader(BinaryBuffer& file, const std::string& mapName);
+    void WriteGameData(BinaryBuffer& file);
     bool ReadGameData(BinaryFile& file);
 };
@@ -122,6 +122,7 @@ void Settings::LoadDefaults()
     server.last_ip.clear();
     server.localPort = 3665;
     server.ipv6 = false;
+    server.adaptive_nwf = false;
     // }
 
     proxy = ProxySettings();
@@ -131,6 +132,7 @@ void Settings::LoadDefaults()
     // {
     interface.autosave_interval = 0;
     interface.revert_mouse = false;
+    interface.replay_keyframe_interval = 10000;
     // }
 
     // ingame
@@ -253,6 +255,7 @@ void Settings::Load()
         boost::optional<uint16_t> port = validate::checkPort(iniServer->getValue("local_port"));
         server.localPort = port.value_or(3665);
         server.ipv6 = (iniServer->getValueI("ipv6") != 0);
+        server.adaptive_nwf = (iniServer->getValueI("adaptive_nwf") != 0);
         // }
 
         // proxy
@@ -278,6 +281,9 @@ void Settings::Load()
         // {
         interface.autosave_interval = iniInterface->getValueI("autosave_interval");
         interface.revert_mouse = (iniInterface->getValueI("revert_mouse") != 0);
+        interface.replay_keyframe_interval = iniInterface->getValue("replay_keyframe_interval").empty() ?
+                                               10000 :
+                                               iniInterface->getValueI("replay_keyframe_interval");
         // }
 
         // ingame
@@ -385,6 +391,7 @@ void Settings::Save()
     iniServer->setValue("last_ip", server.last_ip);
     iniServer->setValue("local_port", server.localPort);
     iniServer->setValue("ipv6", (server.ipv6 ? 1 : 0));
+    iniServer->setValue("adaptive_nwf", (server.adaptive_nwf ? 1 : 0));
     // }
 
     // proxy
@@ -398,6 +405,7 @@ void Settings::Save()
     // {
     iniInterface->setValue("autosave_interval", interface.autosave_interval);
     iniInterface->setValue("revert_mouse", (interface.revert_mouse ? 1 : 0));
+    iniInterface->setValue("replay_keyframe_interval", interface.replay_keyframe_interval);
     // }
 
     // ingame
@@ -96,6 +96,7 @@ public:
         std::string last_ip; /// last entered ip or hostname
         uint16_t localPort;
         bool ipv6; /// listen/connect on ipv6 as default or not
+        bool adaptive_nwf; /// adapt the networkframe length to the pings during the game
     } server;
 
     ProxySettings proxy;
@@ -104,6 +105,8 @@ public:
     {
         unsigned autosave_interval;
         bool revert_mouse;
+        /// Interval (in GF) of the keyframes stored in replays for seeking. 0 = disabled
+        unsigned replay_keyframe_interval;
     } interface;
 
     struct
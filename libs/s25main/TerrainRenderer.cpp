@@ -19,6 +19,7 @@
 #include "Loader.h"
 #include "RttrForeachPt.h"
 #include "Settings.h"
+#include "TraceRecorder.h"
 #include "drivers/VideoDriverWrapper.h"
 #include "helpers/EnumArray.h"
 #include "helpers/containerUtils.h"
@@ -684,6 +685,7 @@ void TerrainRenderer::UpdateBorderTriangleTerrain(const MapPoint pt, bool update
 void TerrainRenderer::Draw(const Position& firstPt, const Position& lastPt, const GameWorldViewer& gwv,
                            unsigned* water) const
 {
+    RTTR_TRACE_SCOPE("TerrainRenderer::Draw");
     RTTR_Assert(!gl_vertices.empty());
     RTTR_Assert(!borders.empty());
 
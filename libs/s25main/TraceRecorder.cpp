@@ -0,0 +1,134 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#include "TraceRecorder.h"
+#include <boost/nowide/fstream.hpp>
+#include <algorithm>
+#include <iomanip>
+
+namespace {
+/// Write the string quoted and escaped for JSON
+void WriteJSONString(std::ostream& os, const std::string& str)
+{
+    os << '"';
+    for(const char c : str)
+    {
+        if(c == '"' || c == '\\')
+            os << '\\' << c;
+        else if(static_cast<unsigned char>(c) < 0x20)
+            os << ' ';
+        else
+            os << c;
+    }
+    os << '"';
+}
+} // namespace
+
+TraceRecorder::TraceRecorder() : isRecording_(false), nextThreadIdx_(0), numDroppedEvents_(0) {}
+
+void TraceRecorder::Start()
+{
+    Stop();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        events_.clear();
+        threadNames_.clear();
+        numDroppedEvents_ = 0;
+        startTime_ = Clock::now();
+    }
+    SetThreadName("Main");
+    isRecording_ = true;
+}
+
+void TraceRecorder::Stop()
+{
+    isRecording_ = false;
+}
+
+void TraceRecorder::SetThreadName(const std::string& name)
+{
+    const unsigned tid = GetThreadIdx();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(threadNames_.begin(), threadNames_.end(),
+                           [tid](const std::pair<unsigned, std::string>& entry) { return entry.first == tid; });
+    if(it != threadNames_.end())
+        it->second = name;
+    else
+        threadNames_.emplace_back(tid, name);
+}
+
+void TraceRecorder::AddEvent(const char* name, Clock::time_point startTime, Clock::time_point endTime)
+{
+    const unsigned tid = GetThreadIdx();
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Might have been stopped and restarted in between
+    if(!isRecording_ || startTime < startTime_)
+        return;
+    if(events_.size() >= MAX_EVENTS)
+        ++numDroppedEvents_;
+    else
+        events_.push_back(Event{name, tid, startTime, endTime});
+}
+
+size_t TraceRecorder::GetNumEvents() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return events_.size();
+}
+
+bool TraceRecorder::Write(const boost::filesystem::path& filepath) const
+{
+    boost::nowide::ofstream file(filepath);
+    if(!file)
+        return false;
+    const auto toMicroseconds = [this](Clock::time_point time) {
+        return std::chrono::duration<double, std::micro>(time - startTime_).count();
+    };
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool isFirst = true;
+    for(const auto& threadName : threadNames_)
+    {
+        file << (isFirst ? "\n" : ",\n");
+        isFirst = false;
+        file << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << threadName.first
+             << ", \"args\": {\"name\": ";
+        WriteJSONString(file, threadName.second);
+        file << "}}";
+    }
+    for(const Event& event : events_)
+    {
+        file << (isFirst ? "\n" : ",\n");
+        isFirst = false;
+        file << "{\"name\": ";
+        WriteJSONString(file, event.name);
+        file << ", \"cat\": \"rttr\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << event.tid
+             << ", \"ts\": " << toMicroseconds(event.startTime)
+             << ", \"dur\": " << std::chrono::duration<double, std::micro>(event.endTime - event.startTime).count()
+             << "}";
+    }
+    file << "\n]}\n";
+    return static_cast<bool>(file);
+}
+
+unsigned TraceRecorder::GetThreadIdx()
+{
+    static thread_local const unsigned threadIdx = nextThreadIdx_++;
+    return threadIdx;
+}
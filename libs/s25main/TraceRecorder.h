@@ -0,0 +1,126 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "s25util/Singleton.h"
+#include <boost/filesystem/path.hpp>
+#include <boost/preprocessor/cat.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// Records when marked scopes are entered and left (per thread) and writes them in the Chrome trace event format
+/// which can be viewed e.g. with chrome://tracing or Perfetto.
+/// Use the RTTR_TRACE_* macros for the markers, they compile to nothing unless RTTR_ENABLE_TRACING is set.
+class TraceRecorder : public Singleton<TraceRecorder>
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// Maximum number of events kept, later ones are dropped
+    static constexpr size_t MAX_EVENTS = 1u << 22;
+
+    /// Records the time from construction till destruction if the recorder is running.
+    /// The name must outlive the recording (usually a string literal)
+    class Scope
+    {
+    public:
+        explicit Scope(const char* name) : name_(nullptr)
+        {
+            TraceRecorder& recorder = TraceRecorder::inst();
+            if(recorder.IsRecording())
+            {
+                name_ = name;
+                startTime_ = Clock::now();
+            }
+        }
+        ~Scope()
+        {
+            if(name_)
+                TraceRecorder::inst().AddEvent(name_, startTime_, Clock::now());
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* name_;
+        Clock::time_point startTime_;
+    };
+
+    TraceRecorder();
+
+    /// True if the markers are compiled in
+    static constexpr bool IsCompiledIn()
+    {
+#if RTTR_ENABLE_TRACING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /// Drop all recorded events and start recording. The calling thread is named "Main"
+    void Start();
+    void Stop();
+    bool IsRecording() const { return isRecording_; }
+
+    /// Name the calling thread in the trace
+    void SetThreadName(const std::string& name);
+    void AddEvent(const char* name, Clock::time_point startTime, Clock::time_point endTime);
+
+    size_t GetNumEvents() const;
+    size_t GetNumDroppedEvents() const { return numDroppedEvents_; }
+    /// Write all recorded events as JSON
+    bool Write(const boost::filesystem::path& filepath) const;
+
+private:
+    struct Event
+    {
+        const char* name;
+        /// Thread index
+        unsigned tid;
+        Clock::time_point startTime, endTime;
+    };
+
+    /// Small number identifying the calling thread
+    unsigned GetThreadIdx();
+
+    std::atomic<bool> isRecording_;
+    std::atomic<unsigned> nextThreadIdx_;
+    Clock::time_point startTime_;
+    mutable std::mutex mutex_;
+    std::vector<Event> events_;
+    std::vector<std::pair<unsigned, std::string>> threadNames_;
+    std::atomic<size_t> numDroppedEvents_;
+};
+
+#define TRACERECORDER TraceRecorder::inst()
+
+#if RTTR_ENABLE_TRACING
+/// Record the time till the end of the current scope under the given name (string literal)
+#    define RTTR_TRACE_SCOPE(name) const TraceRecorder::Scope BOOST_PP_CAT(rttrTraceScope, __LINE__)(name)
+/// Name the current thread in the trace
+#    define RTTR_TRACE_THREAD_NAME(name) TRACERECORDER.SetThreadName(name)
+#else
+#    define RTTR_TRACE_SCOPE(name) static_cast<void>(0)
+#    define RTTR_TRACE_THREAD_NAME(name) static_cast<void>(0)
+#endif
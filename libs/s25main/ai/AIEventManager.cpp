@@ -16,16 +16,46 @@
 // along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
 
 #include "AIEventManager.h"
-#include "AIEvents.h"
 
-AIEventManager::AIEventManager() = default;
+AIEventManager::AIEventManager() : numCoalescedEvents(0) {}
 AIEventManager::~AIEventManager() = default;
 
+bool AIEventManager::IsRegionEvent(const AIEvent::EventType type)
+{
+    // Both only remove unused roads around the position, which covers a larger area than the region
+    return type == AIEvent::LostLand || type == AIEvent::BuildingLost;
+}
+
+uint64_t AIEventManager::GetRegionKey(const AIEvent::EventType type, const MapPoint pt)
+{
+    return (static_cast<uint64_t>(type) << 32) | (static_cast<uint64_t>(pt.y / REGION_SIZE) << 16)
+           | (pt.x / REGION_SIZE);
+}
+
+bool AIEventManager::IsCoalesced(const AIEvent::EventType type, const MapPoint pt)
+{
+    if(!IsRegionEvent(type))
+        return false;
+    if(queuedRegions.insert(GetRegionKey(type, pt)).second)
+        return false;
+    numCoalescedEvents++;
+    return true;
+}
+
 void AIEventManager::AddAIEvent(std::unique_ptr<AIEvent::Base> ev)
 {
+    if(IsRegionEvent(ev->GetType())
+       && IsCoalesced(ev->GetType(), checkedCast<const AIEvent::Location*>(ev.get())->GetPos()))
+        return;
     events.push(std::move(ev));
 }
 
+void AIEventManager::AddBuildingEvent(const AIEvent::EventType type, const MapPoint pt, const BuildingType bld)
+{
+    if(!IsCoalesced(type, pt))
+        events.push(std::make_unique<AIEvent::Building>(type, pt, bld));
+}
+
 std::unique_ptr<AIEvent::Base> AIEventManager::GetEvent()
 {
     if(events.empty())
@@ -33,5 +63,8 @@ std::unique_ptr<AIEvent::Base> AIEventManager::GetEvent()
 
     std::unique_ptr<AIEvent::Base> ev = std::move(events.front());
     events.pop();
+    // New events for the region have to be handled again
+    if(IsRegionEvent(ev->GetType()))
+        queuedRegions.erase(GetRegionKey(ev->GetType(), checkedCast<const AIEvent::Location*>(ev.get())->GetPos()));
     return ev;
 }
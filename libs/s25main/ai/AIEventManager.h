@@ -17,23 +17,43 @@
 
 #pragma once
 
+#include "ai/AIEvents.h"
+#include <cstdint>
 #include <memory>
 #include <queue>
+#include <unordered_set>
 
-namespace AIEvent {
-class Base;
-}
-
+/// Queue of the events for an AI.
+/// Events which only affect the area around their position (see IsRegionEvent) are coalesced:
+/// While such an event is queued, further events of the same type in the same region are dropped.
+/// So a storm of notifications (e.g. during a battle) results in only a few updates per region.
 class AIEventManager
 {
 public:
+    /// Side length of the square regions in which events get coalesced
+    static constexpr unsigned REGION_SIZE = 4;
+
     AIEventManager();
     ~AIEventManager();
     void AddAIEvent(std::unique_ptr<AIEvent::Base> ev);
+    /// Add a building event. Nothing is created if it gets coalesced
+    void AddBuildingEvent(AIEvent::EventType type, MapPoint pt, BuildingType bld);
     std::unique_ptr<AIEvent::Base> GetEvent();
     bool EventAvailable() const { return !events.empty(); }
     unsigned GetEventNum() const { return events.size(); }
+    /// Number of events dropped as an event for the same region was already queued
+    unsigned GetNumCoalescedEvents() const { return numCoalescedEvents; }
+
+    /// True for events whose handling only updates the area around the position
+    static bool IsRegionEvent(AIEvent::EventType type);
 
 protected:
+    static uint64_t GetRegionKey(AIEvent::EventType type, MapPoint pt);
+    /// Return true if an event of the type is already queued for the region of the point
+    bool IsCoalesced(AIEvent::EventType type, MapPoint pt);
+
     std::queue<std::unique_ptr<AIEvent::Base>> events;
+    /// Regions (with type) of the queued region events
+    std::unordered_set<uint64_t> queuedRegions;
+    unsigned numCoalescedEvents;
 };
@@ -21,7 +21,7 @@
 #include "buildings/nobHarborBuilding.h"
 #include "buildings/nobMilitary.h"
 #include "buildings/nobShipYard.h"
-#include "pathfinding/FreePathFinder.h"
+#include "pathfinding/FreePathFinderImpl.h"
 #include "pathfinding/PathConditionRoad.h"
 #include "pathfinding/RoadPathFinder.h"
 #include "nodeObjs/noFlag.h"
@@ -33,6 +33,9 @@
 class noRoadNode;
 
 namespace {
+/// Maximum length of the roads searched by the AI
+constexpr unsigned MAX_ROAD_LENGTH = 100;
+
 /// Param for road-build pathfinding
 struct Param_RoadPath
 {
@@ -197,9 +200,15 @@ bool AIInterface::FindFreePathForNewRoad(MapPoint start, MapPoint target, std::v
                                          unsigned* length /*= nullptr*/) const
 {
     bool boat = false;
-    return gwb.GetFreePathFinder().FindPathAlternatingConditions(start, target, false, 100, route, length, nullptr,
-                                                                 IsPointOK_RoadPath, IsPointOK_RoadPathEvenStep,
-                                                                 nullptr, (void*)&boat);
+    return gwb.GetFreePathFinder().FindPathAlternatingConditions(start, target, false, MAX_ROAD_LENGTH, route, length,
+                                                                 nullptr, IsPointOK_RoadPath,
+                                                                 IsPointOK_RoadPathEvenStep, nullptr, (void*)&boat);
+}
+
+std::vector<unsigned> AIInterface::GetMinNewRoadLengths(const MapPoint start, const std::vector<MapPoint>& targets) const
+{
+    // Only the condition of IsPointOK_RoadPath, which all points of the paths found by FindFreePathForNewRoad fulfill
+    return gwb.GetFreePathFinder().FindPathLengths(start, targets, MAX_ROAD_LENGTH, makePathConditionRoad(gwb, false));
 }
 
 bool AIInterface::CalcBQSumDifference(const MapPoint pt1, const MapPoint pt2) const
@@ -91,6 +91,9 @@ public:
     /// Tries to find a free path for a road and return length and the route
     bool FindFreePathForNewRoad(MapPoint start, MapPoint target, std::vector<Direction>* route = nullptr,
                                 unsigned* length = nullptr) const;
+    /// Lower bound for the length of the path found by FindFreePathForNewRoad to each target, all found in one search.
+    /// std::numeric_limits<unsigned>::max() if there is no path to the target
+    std::vector<unsigned> GetMinNewRoadLengths(MapPoint start, const std::vector<MapPoint>& targets) const;
     /// Tries to find a route from start to target, returning length of that route if it exists
     bool FindPathOnRoads(const noRoadNode& start, const noRoadNode& target, unsigned* length = nullptr) const;
     /// Checks if it is allowed to build catapults
@@ -19,6 +19,10 @@
 
 #include "AIInterface.h"
 #include "GameCommand.h"
+#include "random/XorShift.h"
+#include <cstdint>
+#include <iterator>
+#include <utility>
 
 class GameWorldBase;
 class GamePlayer;
@@ -28,13 +32,17 @@ class GlobalGameSettings;
 class AIPlayer
 {
 public:
-    AIPlayer(unsigned char playerId, const GameWorldBase& gwb, const AI::Level level)
+    /// The seed initializes the own random generator of the AI, so its decisions can be reproduced
+    AIPlayer(unsigned char playerId, const GameWorldBase& gwb, const AI::Level level, uint64_t randomSeed)
         : playerId(playerId), player(gwb.GetPlayer(playerId)), gwb(gwb), ggs(gwb.GetGGS()), level(level),
-          aii(gwb, gcs, playerId)
+          aii(gwb, gcs, playerId), rng_(randomSeed)
     {}
 
     virtual ~AIPlayer() = default;
 
+    /// Expensive initialization which only reads the world. Called once before the first GF.
+    /// May run in parallel to the initialization of other AIs
+    virtual void Init() {}
     /// Called for every GF
     virtual void RunGF(unsigned gf, bool gfisnwf) = 0;
 
@@ -53,6 +61,33 @@ public:
     const AIInterface& getAIInterface() const { return aii; }
     AIInterface& getAIInterface() { return aii; }
 
+    /// Return a random value in [0, max) (0 for max == 0) for decisions of the AI.
+    /// Uses the own generator of the AI, so the game RNG is not touched
+    unsigned Rand(unsigned max)
+    {
+        if(max == 0)
+            return 0;
+        return static_cast<unsigned>(rng_() % max);
+    }
+    /// Shuffle the range with the random generator of the AI.
+    /// std::shuffle is not used as its results depend on the standard library
+    template<class T_It>
+    void Shuffle(T_It first, T_It last)
+    {
+        if(first == last)
+            return;
+        for(auto i = std::distance(first, last) - 1; i > 0; --i)
+        {
+            using std::swap;
+            swap(first[i], first[Rand(static_cast<unsigned>(i + 1))]);
+        }
+    }
+    template<class T>
+    void Shuffle(T& container)
+    {
+        Shuffle(container.begin(), container.end());
+    }
+
     /// Eigene PlayerId, die der KI-Spieler wissen sollte, z.B. wenn er die Karte untersucht
     const unsigned char playerId;
     /// Verweis auf den eigenen GameClientPlayer, d.h. die Wirtschaft, um daraus entsprechend Informationen zu gewinnen
@@ -70,4 +105,7 @@ protected:
     const AI::Level level;
     /// Abstrahiertes Interfaces, leitet Befehle weiter an
     AIInterface aii;
+
+private:
+    XorShift rng_;
 };
@@ -25,7 +25,9 @@ class GlobalGameSettings;
 class DummyAI : public AIPlayer
 {
 public:
-    DummyAI(unsigned char playerId, const GameWorldBase& gwb, const AI::Level level) : AIPlayer(playerId, gwb, level) {}
+    DummyAI(unsigned char playerId, const GameWorldBase& gwb, const AI::Level level, uint64_t randomSeed)
+        : AIPlayer(playerId, gwb, level, randomSeed)
+    {}
 
     void RunGF(unsigned /*gf*/, bool /*gfisnwf*/) override {}
 };
@@ -17,6 +17,7 @@
 
 #include "AIConstruction.h"
 #include "BuildingPlanner.h"
+#include "EventManager.h"
 #include "GlobalGameSettings.h"
 #include "Jobs.h"
 #include "Point.h"
@@ -48,7 +49,8 @@
 namespace AIJH {
 
 AIConstruction::AIConstruction(AIPlayerJH& aijh)
-    : aijh(aijh), aii(aijh.GetInterface()), bldPlanner(aijh.GetBldPlanner()), constructionorders(NUM_BUILDING_TYPES)
+    : aijh(aijh), aii(aijh.GetInterface()), bldPlanner(aijh.GetBldPlanner()), constructionorders(NUM_BUILDING_TYPES),
+      roadDistancesGF(0)
 {}
 
 AIConstruction::~AIConstruction() = default;
@@ -289,19 +291,42 @@ bool AIConstruction::ConnectFlagToRoadSytem(const noFlag* flag, std::vector<Dire
     std::cout << "FindFlagsNum: " << flags.size() << std::endl;
 #endif
 
+    // A single search for all flags gives a lower bound for the length of the new road, so flags which cannot be
+    // reached or cannot be better than the best one so far are skipped without searching the exact route
+    std::vector<MapPoint> flagPositions;
+    flagPositions.reserve(flags.size());
+    for(const noFlag* curFlag : flags)
+        flagPositions.push_back(curFlag->GetPos());
+    const std::vector<unsigned> minLengths = aii.GetMinNewRoadLengths(flag->GetPos(), flagPositions);
+
     const noFlag* shortest = nullptr;
     unsigned shortestLength = 99999;
     std::vector<Direction> tmpRoute;
 
     // Jede Flagge testen...
-    for(const noFlag* curFlag : flags)
+    for(unsigned i = 0; i < flags.size(); i++)
     {
-        tmpRoute.clear();
-        unsigned length;
+        const noFlag* curFlag = flags[i];
+        if(minLengths[i] == std::numeric_limits<unsigned>::max())
+            continue;
         // the flag should not be at a military building!
         if(aii.gwb.IsMilitaryBuildingOnNode(aii.gwb.GetNeighbour(curFlag->GetPos(), Direction::NORTHWEST), true))
             continue;
+
+        // Find path from current flag to target. If the current flag IS the target then we have already a path with
+        // distance=0
+        unsigned distance = 0;
+        bool pathFound = curFlag == targetFlag || GetRoadDistance(*curFlag, *targetFlag, distance);
+
+        // Gewählte Fahne hat leider auch kein Anschluß an ein Lager, zu schade!
+        if(!pathFound)
+            continue;
+        if(2 * minLengths[i] + distance >= shortestLength)
+            continue;
+
         // Gibts überhaupt einen Pfad zu dieser Flagge
+        tmpRoute.clear();
+        unsigned length;
         if(!aii.FindFreePathForNewRoad(flag->GetPos(), curFlag->GetPos(), &tmpRoute, &length))
             continue;
 
@@ -327,17 +352,9 @@ bool AIConstruction::ConnectFlagToRoadSytem(const noFlag* flag, std::vector<Dire
         if(maxNonFlagPts > 2)
             continue;
 
-        // Find path from current flag to target. If the current flag IS the target then we have already a path with
-        // distance=0
-        unsigned distance = 0;
-        bool pathFound = curFlag == targetFlag || aii.FindPathOnRoads(*curFlag, *targetFlag, &distance);
-
-        // Gewählte Fahne hat leider auch kein Anschluß an ein Lager, zu schade!
-        if(!pathFound)
-            continue;
-
         // Sind wir mit der Fahne schon verbunden? Einmal reicht!
-        if(aii.FindPathOnRoads(*curFlag, *flag))
+        unsigned connectedDistance;
+        if(GetRoadDistance(*curFlag, *flag, connectedDistance))
             continue;
 
         // Kürzer als der letzte? Nehmen! Existierende Strecke höher gewichten (2), damit möglichst kurze Baustrecken
@@ -437,11 +454,34 @@ bool AIConstruction::IsConnectedToRoadSystem(const noFlag* flag) const
 {
     noFlag* targetFlag = FindTargetStoreHouseFlag(flag->GetPos());
     if(targetFlag)
-        return (targetFlag == flag) || aii.FindPathOnRoads(*flag, *targetFlag);
-    else
+    {
+        unsigned distance;
+        return (targetFlag == flag) || GetRoadDistance(*flag, *targetFlag, distance);
+    } else
         return false;
 }
 
+bool AIConstruction::GetRoadDistance(const noFlag& start, const noFlag& target, unsigned& distance) const
+{
+    const unsigned curGF = aii.gwb.GetEvMgr().GetCurrentGF();
+    if(curGF != roadDistancesGF)
+    {
+        roadDistances.clear();
+        roadDistancesGF = curGF;
+    }
+    const uint64_t key = (static_cast<uint64_t>(aii.gwb.GetIdx(start.GetPos())) << 32) | aii.gwb.GetIdx(target.GetPos());
+    auto it = roadDistances.find(key);
+    if(it == roadDistances.end())
+    {
+        unsigned length;
+        if(!aii.FindPathOnRoads(start, target, &length))
+            length = std::numeric_limits<unsigned>::max();
+        it = roadDistances.emplace(key, length).first;
+    }
+    distance = it->second;
+    return distance != std::numeric_limits<unsigned>::max();
+}
+
 helpers::OptionalEnum<BuildingType> AIConstruction::GetSmallestAllowedMilBuilding() const
 {
     for(BuildingType bld : BuildingProperties::militaryBldTypes)
@@ -479,10 +519,10 @@ helpers::OptionalEnum<BuildingType> AIConstruction::ChooseMilitaryBuilding(const
     const BuildingType biggestBld = GetBiggestAllowedMilBuilding().value();
 
     const Inventory& inventory = aii.GetInventory();
-    if(((rand() % 3) == 0 || inventory.people[JOB_PRIVATE] < 15)
+    if((aijh.Rand(3) == 0 || inventory.people[JOB_PRIVATE] < 15)
        && (inventory.goods[GD_STONES] > 6 || bldPlanner.GetNumBuildings(BLD_QUARRY) > 0))
         bld = BLD_GUARDHOUSE;
-    if(aijh.HarborPosClose(pt, 20) && rand() % 10 != 0 && aijh.ggs.getSelection(AddonId::SEA_ATTACK) != 2)
+    if(aijh.HarborPosClose(pt, 20) && aijh.Rand(10) != 0 && aijh.ggs.getSelection(AddonId::SEA_ATTACK) != 2)
     {
         if(aii.CanBuildBuildingtype(BLD_WATCHTOWER))
             return BLD_WATCHTOWER;
@@ -491,7 +531,7 @@ helpers::OptionalEnum<BuildingType> AIConstruction::ChooseMilitaryBuilding(const
     if(biggestBld == BLD_WATCHTOWER || biggestBld == BLD_FORTRESS)
     {
         if(aijh.UpdateUpgradeBuilding() < 0 && bldPlanner.GetNumBuildingSites(biggestBld) < 1
-           && (inventory.goods[GD_STONES] > 20 || bldPlanner.GetNumBuildings(BLD_QUARRY) > 0) && rand() % 10 != 0)
+           && (inventory.goods[GD_STONES] > 20 || bldPlanner.GetNumBuildings(BLD_QUARRY) > 0) && aijh.Rand(10) != 0)
         {
             return biggestBld;
         }
@@ -506,7 +546,8 @@ helpers::OptionalEnum<BuildingType> AIConstruction::ChooseMilitaryBuilding(const
         // Prüfen ob Feind in der Nähe
         if(milBld->GetPlayer() != playerId && distance < 35)
         {
-            int randmil = rand();
+            // 40 is a multiple of all the values checked below
+            const unsigned randmil = aijh.Rand(40);
             bool buildCatapult = randmil % 8 == 0 && aii.CanBuildCatapult()
                                  && bldPlanner.GetNumAdditionalBuildingsWanted(BLD_CATAPULT) > 0;
             // another catapult within "min" radius? ->dont build here!
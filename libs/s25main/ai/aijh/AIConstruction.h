@@ -21,8 +21,10 @@
 #include "gameTypes/BuildingType.h"
 #include "gameTypes/Direction.h"
 #include "gameTypes/MapCoordinates.h"
+#include <cstdint>
 #include <deque>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 class AIInterface;
@@ -71,6 +73,11 @@ public:
     bool MinorRoadImprovements(const noRoadNode* start, const noRoadNode* target, std::vector<Direction>& route);
     /// Checks whether a flag is connected to the road system or not (connected = has path to HQ)
     bool IsConnectedToRoadSystem(const noFlag* flag) const;
+    /// Get the length of the path on roads between the flags. Return false if there is none.
+    /// Results are cached till the roads change
+    bool GetRoadDistance(const noFlag& start, const noFlag& target, unsigned& distance) const;
+    /// To be called when roads were built or removed
+    void InvalidateRoadDistances() { roadDistances.clear(); }
 
     helpers::OptionalEnum<BuildingType> GetSmallestAllowedMilBuilding() const;
     helpers::OptionalEnum<BuildingType> GetBiggestAllowedMilBuilding() const;
@@ -110,6 +117,10 @@ private:
     std::deque<MapPoint> constructionlocations;
     // contains the type and amount of buildings ordered since the last nwf
     std::vector<uint8_t> constructionorders;
+    /// Road distances by index of start and target flag (std::numeric_limits<unsigned>::max() if not connected).
+    /// Roads can only change between GFs, so this is also cleared on a new GF
+    mutable std::unordered_map<uint64_t, unsigned> roadDistances;
+    mutable unsigned roadDistancesGF;
 };
 
 } // namespace AIJH
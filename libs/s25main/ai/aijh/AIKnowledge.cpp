@@ -0,0 +1,117 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "AIKnowledge.h"
+#include "RTTR_Assert.h"
+#include "RttrForeachPt.h"
+#include "ai/AIInterface.h"
+#include "ai/aijh/AIMap.h"
+#include "gameData/TerrainDesc.h"
+#include <future>
+#include <vector>
+
+namespace AIJH {
+
+namespace {
+    AIResource CalcResource(const AIInterface& aii, const MapPoint pt)
+    {
+        AIResource subRes = aii.GetSubsurfaceResource(pt);
+        AIResource surfRes = aii.GetSurfaceResource(pt);
+
+        // no resources underground
+        if(subRes == AIResource::NOTHING)
+        {
+            // also no resource on the ground: plant space or unusable?
+            if(surfRes == AIResource::NOTHING)
+            {
+                // already road, really no resources here
+                if(aii.gwb.IsOnRoad(pt))
+                    return AIResource::NOTHING;
+                // check for vital plant space
+                if(!aii.gwb.IsOfTerrain(pt, [](const TerrainDesc& desc) { return desc.IsVital(); }))
+                    return AIResource::NOTHING;
+                return AIResource::PLANTSPACE;
+            }
+
+            return surfRes;
+        } else // resources in underground
+        {
+            if(surfRes == AIResource::STONES || surfRes == AIResource::WOOD)
+                return AIResource::MULTIPLE;
+
+            if(subRes == AIResource::BLOCKED)
+                return AIResource::NOTHING; // nicht so ganz logisch... aber Blocked als res is doof TODO
+
+            return subRes;
+        }
+    }
+} // namespace
+
+AIKnowledge::AIKnowledge()
+{
+    for(unsigned res = 0; res < NUM_AIRESOURCES; ++res)
+    {
+        if(AIResourceMap::IsPlayerIndependent(static_cast<AIResource>(res)))
+            resourceValues[res] = std::make_shared<AIResourceMap::Values>();
+    }
+}
+
+AIKnowledge::~AIKnowledge() = default;
+
+void AIKnowledge::Init(const AIInterface& aii)
+{
+    std::call_once(initFlag, [this, &aii]() {
+        resources.Resize(aii.gwb.GetSize());
+        RTTR_FOREACH_PT(MapPoint, resources.GetSize())
+            resources[pt] = CalcResource(aii, pt);
+
+        // The maps only read the world and the resources, so they can be built in parallel.
+        // The AI map is only used for searches
+        const AIMap aiMap;
+        std::vector<AIResourceMap> resMaps;
+        for(unsigned res = 0; res < NUM_AIRESOURCES; ++res)
+        {
+            if(resourceValues[res])
+            {
+                resMaps.push_back(
+                  AIResourceMap(static_cast<AIResource>(res), aii, aiMap, resources, resourceValues[res]));
+            }
+        }
+        std::vector<std::future<void>> initResults;
+        for(AIResourceMap& resMap : resMaps)
+            initResults.push_back(std::async(std::launch::async, [&resMap]() { resMap.Init(); }));
+        for(std::future<void>& result : initResults)
+            result.get();
+    });
+}
+
+bool AIKnowledge::RemovePlantSpace(const MapPoint pt)
+{
+    if(resources[pt] != AIResource::PLANTSPACE)
+        return false;
+    resources[pt] = AIResource::NOTHING;
+    return true;
+}
+
+const std::shared_ptr<AIResourceMap::Values>& AIKnowledge::GetResourceValues(AIResource res) const
+{
+    RTTR_Assert(AIResourceMap::IsPlayerIndependent(res));
+    return resourceValues[static_cast<unsigned>(res)];
+}
+
+} // namespace AIJH
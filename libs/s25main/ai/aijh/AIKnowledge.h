@@ -0,0 +1,62 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "ai/AIResource.h"
+#include "ai/aijh/AIResourceMap.h"
+#include "world/NodeMapBase.h"
+#include "gameTypes/MapCoordinates.h"
+#include <array>
+#include <memory>
+#include <mutex>
+
+class AIInterface;
+
+namespace AIJH {
+
+/// Knowledge about the world which is the same for all AIJH players of a game: The resource of every node and the
+/// values of the resource maps not depending on the player.
+/// Shared by the AIs, so memory and updates do not multiply by the number of AIs. Each AI keeps only what depends on
+/// the player (e.g. territory, reachable and farmed nodes) and updates the shared data when it notices changes.
+class AIKnowledge
+{
+public:
+    AIKnowledge();
+    ~AIKnowledge();
+    AIKnowledge(const AIKnowledge&) = delete;
+    AIKnowledge& operator=(const AIKnowledge&) = delete;
+
+    /// Calculate everything from the world. Only done by the first call, further calls wait till it is done.
+    /// Only the player independent functions of the interface are used
+    void Init(const AIInterface& aii);
+
+    const NodeMapBase<AIResource>& GetResources() const { return resources; }
+    AIResource GetResource(const MapPoint pt) const { return resources[pt]; }
+    /// Mark the node as unusable for plants (e.g. something is built there). Return true if it was plant space
+    bool RemovePlantSpace(MapPoint pt);
+    /// Values of the resource map for a resource not depending on the player
+    const std::shared_ptr<AIResourceMap::Values>& GetResourceValues(AIResource res) const;
+
+private:
+    std::once_flag initFlag;
+    NodeMapBase<AIResource> resources;
+    std::array<std::shared_ptr<AIResourceMap::Values>, NUM_AIRESOURCES> resourceValues;
+};
+
+} // namespace AIJH
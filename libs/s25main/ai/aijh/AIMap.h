@@ -17,7 +17,6 @@
 
 #pragma once
 
-#include "ai/AIResource.h"
 #include "world/NodeMapBase.h"
 #include "gameTypes/BuildingQuality.h"
 
@@ -25,7 +24,6 @@ namespace AIJH {
 struct Node
 {
     BuildingQuality bq;
-    AIResource res;
     bool owned;
     bool reachable;
     char failed_penalty; // when a node was marked reachable, but building failed, this field is >0
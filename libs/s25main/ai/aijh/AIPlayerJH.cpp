@@ -17,6 +17,7 @@
 
 #include "AIPlayerJH.h"
 #include "AIConstruction.h"
+#include "AIKnowledge.h"
 #include "BuildingPlanner.h"
 #include "FindWhConditions.h"
 #include "GamePlayer.h"
@@ -50,39 +51,49 @@
 #include <algorithm>
 #include <array>
 #include <memory>
-#include <random>
 #include <stdexcept>
+#include <vector>
 
 namespace {
+/// Number of operations (e.g. buildings or flags checked) the periodic passes of the AI may do per GF
+constexpr unsigned OPS_PER_GF = 40;
+/// Operations counted for updating the nodes around a picked building and everything done together with it
+constexpr unsigned PLAN_AROUND_BLD_OPS = 10;
+
+/// Buildings to plan around the warehouses. The first NUM_RES_GATHER_BLDS gather resources and are planned around the
+/// military buildings too
+constexpr std::array<BuildingType, 24> BLDS_TO_PLAN = {
+  {BLD_HARBORBUILDING, BLD_SHIPYARD,   BLD_SAWMILL,     BLD_FORESTER,       BLD_FARM,     BLD_FISHERY,
+   BLD_WOODCUTTER,     BLD_QUARRY,     BLD_GOLDMINE,    BLD_IRONMINE,       BLD_COALMINE, BLD_GRANITEMINE,
+   BLD_HUNTER,         BLD_CHARBURNER, BLD_IRONSMELTER, BLD_MINT,           BLD_ARMORY,   BLD_METALWORKS,
+   BLD_BREWERY,        BLD_MILL,       BLD_PIGFARM,     BLD_SLAUGHTERHOUSE, BLD_BAKERY,   BLD_DONKEYBREEDER}};
+constexpr unsigned NUM_RES_GATHER_BLDS = 14;
+
+/// Take the operations of a step of a resumable task from the budget. Return false if the step has to wait for the next
+/// GF as it costs more than what is left. Steps costing more than a whole GF run when the budget is still full
+bool UseBudget(unsigned& budget, unsigned numOps)
+{
+    if(budget == 0u || budget < std::min(numOps, OPS_PER_GF))
+        return false;
+    budget -= std::min(budget, numOps);
+    return true;
+}
+
 void HandleBuildingNote(AIEventManager& eventMgr, const BuildingNote& note)
 {
-    std::unique_ptr<AIEvent::Base> ev;
+    AIEvent::EventType type;
     switch(note.type)
     {
-        case BuildingNote::Constructed:
-            ev = std::make_unique<AIEvent::Building>(AIEvent::BuildingFinished, note.pos, note.bld);
-            break;
-        case BuildingNote::Destroyed:
-            ev = std::make_unique<AIEvent::Building>(AIEvent::BuildingDestroyed, note.pos, note.bld);
-            break;
-        case BuildingNote::Captured:
-            ev = std::make_unique<AIEvent::Building>(AIEvent::BuildingConquered, note.pos, note.bld);
-            break;
-        case BuildingNote::Lost:
-            ev = std::make_unique<AIEvent::Building>(AIEvent::BuildingLost, note.pos, note.bld);
-            break;
-        case BuildingNote::LostLand:
-            ev = std::make_unique<AIEvent::Building>(AIEvent::LostLand, note.pos, note.bld);
-            break;
-        case BuildingNote::NoRessources:
-            ev = std::make_unique<AIEvent::Building>(AIEvent::NoMoreResourcesReachable, note.pos, note.bld);
-            break;
-        case BuildingNote::LuaOrder:
-            ev = std::make_unique<AIEvent::Building>(AIEvent::LuaConstructionOrder, note.pos, note.bld);
-            break;
+        case BuildingNote::Constructed: type = AIEvent::BuildingFinished; break;
+        case BuildingNote::Destroyed: type = AIEvent::BuildingDestroyed; break;
+        case BuildingNote::Captured: type = AIEvent::BuildingConquered; break;
+        case BuildingNote::Lost: type = AIEvent::BuildingLost; break;
+        case BuildingNote::LostLand: type = AIEvent::LostLand; break;
+        case BuildingNote::NoRessources: type = AIEvent::NoMoreResourcesReachable; break;
+        case BuildingNote::LuaOrder: type = AIEvent::LuaConstructionOrder; break;
         default: RTTR_Assert(false); return;
     }
-    eventMgr.AddAIEvent(std::move(ev));
+    eventMgr.AddBuildingEvent(type, note.pos, note.bld);
 }
 void HandleExpeditionNote(AIEventManager& eventMgr, const ExpeditionNote& note)
 {
@@ -143,17 +154,14 @@ Subscription recordBQsToUpdate(const GameWorldBase& gw, std::vector<MapPoint>& b
     });
 }
 
-AIPlayerJH::AIPlayerJH(const unsigned char playerId, const GameWorldBase& gwb, const AI::Level level)
-    : AIPlayer(playerId, gwb, level), UpgradeBldPos(MapPoint::Invalid()), isInitGfCompleted(false),
+AIPlayerJH::AIPlayerJH(const unsigned char playerId, const GameWorldBase& gwb, const AI::Level level,
+                       uint64_t randomSeed, std::shared_ptr<AIKnowledge> knowledge)
+    : AIPlayer(playerId, gwb, level, randomSeed), UpgradeBldPos(MapPoint::Invalid()),
+      reachability(gwb, playerId, aiMap),
+      knowledge(knowledge ? std::move(knowledge) : std::make_shared<AIKnowledge>()), isInitGfCompleted(false),
       defeated(player.IsDefeated()), bldPlanner(std::make_unique<BuildingPlanner>(*this)),
-      construction(std::make_unique<AIConstruction>(*this))
+      construction(std::make_unique<AIConstruction>(*this)), scheduler(OPS_PER_GF)
 {
-    InitNodes();
-    InitResourceMaps();
-#ifdef DEBUG_AI
-    SaveResourceMapsToFile();
-#endif
-
     switch(level)
     {
         case AI::EASY:
@@ -185,8 +193,24 @@ AIPlayerJH::AIPlayerJH(const unsigned char playerId, const GameWorldBase& gwb, c
             HandleResourceNote(eventManager, note);
     });
     subRoad = notifications.subscribe<RoadNote>([this, playerId](const RoadNote& note) {
+        if(note.type == RoadNote::Constructed)
+        {
+            // Roads of all players block other roads and plants
+            MapPoint curPt = note.pos;
+            nodesWithOutdatedBQ.push_back(curPt);
+            for(const Direction dir : note.route)
+            {
+                curPt = this->gwb.GetNeighbour(curPt, dir);
+                nodesWithOutdatedBQ.push_back(curPt);
+                RemovePlantSpace(curPt);
+            }
+        }
         if(note.player == playerId)
+        {
+            if(note.type == RoadNote::Constructed)
+                construction->InvalidateRoadDistances();
             HandleRoadNote(eventManager, note);
+        }
     });
     subShip = notifications.subscribe<ShipNote>([this, playerId](const ShipNote& note) {
         if(note.player == playerId)
@@ -197,6 +221,16 @@ AIPlayerJH::AIPlayerJH(const unsigned char playerId, const GameWorldBase& gwb, c
 
 AIPlayerJH::~AIPlayerJH() = default;
 
+void AIPlayerJH::Init()
+{
+    knowledge->Init(aii);
+    InitNodes();
+    InitResourceMaps();
+#ifdef DEBUG_AI
+    SaveResourceMapsToFile();
+#endif
+}
+
 /// Wird jeden GF aufgerufen und die KI kann hier entsprechende Handlungen vollziehen
 void AIPlayerJH::RunGF(const unsigned gf, bool gfisnwf)
 {
@@ -230,6 +264,8 @@ void AIPlayerJH::RunGF(const unsigned gf, bool gfisnwf)
         helpers::makeUnique(nodesWithOutdatedBQ, MapPointLess());
         for(const MapPoint pt : nodesWithOutdatedBQ)
             aiMap[pt].bq = aii.GetBuildingQuality(pt);
+        // Whatever changed the BQ might also have changed where roads can be built
+        reachability.Update(nodesWithOutdatedBQ);
         nodesWithOutdatedBQ.clear();
     }
 
@@ -243,127 +279,162 @@ void AIPlayerJH::RunGF(const unsigned gf, bool gfisnwf)
         bldPlanner->UpdateBuildingsWanted(*this);
     ExecuteAIJob();
 
+    // The periodic passes are only queued here and done within the operation budget of each GF
     if((gf + playerId * 17) % attack_interval == 0)
     {
         // CheckExistingMilitaryBuildings();
-        TryToAttack();
+        scheduler.AddUnique("Attack", [this, state = AttackState()](unsigned& budget) mutable {
+            return TryToAttack(state, budget);
+        });
     }
     if(((gf + playerId * 17) % 73 == 0) && (level != AI::EASY))
-    {
-        MilUpgradeOptim();
-    }
+        scheduler.AddUnique("MilUpgradeOptim", scheduler.MakeSingleStepTask(10, [this]() { MilUpgradeOptim(); }));
 
     if((gf + 41 + playerId * 17) % attack_interval == 0)
     {
         if(ggs.getSelection(AddonId::SEA_ATTACK) < 2) // not deactivated by addon? -> go ahead
-            TrySeaAttack();
+            scheduler.AddUnique("SeaAttack", scheduler.MakeSingleStepTask(20, [this]() { TrySeaAttack(); }));
     }
 
     if((gf + playerId * 13) % 1500 == 0)
     {
-        CheckExpeditions();
-        CheckForester();
-        CheckGranitMine();
+        scheduler.AddUnique("Expeditions", scheduler.MakeSingleStepTask(5, [this]() { CheckExpeditions(); }));
+        scheduler.AddUnique("Forester", scheduler.MakeSingleStepTask(1, [this]() { CheckForester(); }));
+        scheduler.AddUnique("GranitMine", scheduler.MakeSingleStepTask(2, [this]() { CheckGranitMine(); }));
     }
 
     if((gf + playerId * 11) % 150 == 0)
     {
-        AdjustSettings();
-        // check for useless sawmills
-        const std::list<nobUsual*>& sawMills = aii.GetBuildings(BLD_SAWMILL);
-        if(sawMills.size() > 3)
-        {
-            int burns = 0;
-            for(const nobUsual* sawmill : sawMills)
-            {
-                if(sawmill->GetProductivity() < 1 && sawmill->HasWorker() && sawmill->GetNumWares(0) < 1
-                   && (sawMills.size() - burns) > 3 && !sawmill->AreThereAnyOrderedWares())
-                {
-                    aii.DestroyBuilding(sawmill);
-                    RemoveUnusedRoad(*sawmill->GetFlag(), Direction::NORTHWEST, true);
-                    burns++;
-                }
-            }
-        }
+        scheduler.AddUnique("Settings", scheduler.MakeSingleStepTask(5, [this]() {
+                                AdjustSettings();
+                                CheckSawmills();
+                            }));
     }
 
     if((gf + playerId * 7) % build_interval == 0) // plan new buildings
     {
-        CheckForUnconnectedBuildingSites();
-        PlanNewBuildings(gf);
+        scheduler.AddUnique("ConnectBuildingSites",
+                            [this, state = ConnectBuildingSitesState()](unsigned& budget) mutable {
+                                return CheckForUnconnectedBuildingSites(state, budget);
+                            });
+        scheduler.AddUnique("PlanNewBuildings", [this, gf, state = PlanBuildingsState()](unsigned& budget) mutable {
+            return PlanNewBuildings(gf, state, budget);
+        });
     }
+
+    scheduler.RunGF();
 }
 
-void AIPlayerJH::PlanNewBuildings(const unsigned gf)
+void AIPlayerJH::CheckSawmills()
 {
-    bldPlanner->UpdateBuildingsWanted(*this);
+    // check for useless sawmills
+    const std::list<nobUsual*>& sawMills = aii.GetBuildings(BLD_SAWMILL);
+    if(sawMills.size() > 3)
+    {
+        int burns = 0;
+        for(const nobUsual* sawmill : sawMills)
+        {
+            if(sawmill->GetProductivity() < 1 && sawmill->HasWorker() && sawmill->GetNumWares(0) < 1
+               && (sawMills.size() - burns) > 3 && !sawmill->AreThereAnyOrderedWares())
+            {
+                aii.DestroyBuilding(sawmill);
+                RemoveUnusedRoad(*sawmill->GetFlag(), Direction::NORTHWEST, true);
+                burns++;
+            }
+        }
+    }
+}
 
-    // pick a random storehouse and try to build one of these buildings around it (checks if we actually want more of
-    // the building type)
-    std::array<BuildingType, 24> bldToTest = {
-      {BLD_HARBORBUILDING, BLD_SHIPYARD,   BLD_SAWMILL,     BLD_FORESTER,       BLD_FARM,     BLD_FISHERY,
-       BLD_WOODCUTTER,     BLD_QUARRY,     BLD_GOLDMINE,    BLD_IRONMINE,       BLD_COALMINE, BLD_GRANITEMINE,
-       BLD_HUNTER,         BLD_CHARBURNER, BLD_IRONSMELTER, BLD_MINT,           BLD_ARMORY,   BLD_METALWORKS,
-       BLD_BREWERY,        BLD_MILL,       BLD_PIGFARM,     BLD_SLAUGHTERHOUSE, BLD_BAKERY,   BLD_DONKEYBREEDER}};
-    const unsigned numResGatherBlds = 14; /* The first n buildings in the above list, that gather resources */
+bool AIPlayerJH::PlanNewBuildings(const unsigned gf, PlanBuildingsState& state, unsigned& budget)
+{
+    if(!state.isStarted)
+    {
+        if(!UseBudget(budget, PLAN_AROUND_BLD_OPS))
+            return false;
+        state.isStarted = true;
+        bldPlanner->UpdateBuildingsWanted(*this);
 
-    // LOG.write(("new buildorders %i whs and %i mil for player %i
-    // \n",aii.GetStorehouses().size(),aii.GetMilitaryBuildings().size(),playerId);
+        // pick a random storehouse and try to build one of these buildings around it (checks if we actually want more
+        // of the building type)
+        const std::list<nobBaseWarehouse*>& storehouses = aii.GetStorehouses();
+        if(!storehouses.empty())
+        {
+            // collect swords,shields,helpers,privates and beer in first storehouse or whatever is closest to the
+            // upgradebuilding if we have one!
+            nobBaseWarehouse* wh = GetUpgradeBuildingWarehouse();
+            SetGatheringForUpgradeWarehouse(wh);
 
-    const std::list<nobBaseWarehouse*>& storehouses = aii.GetStorehouses();
-    if(!storehouses.empty())
-    {
-        // collect swords,shields,helpers,privates and beer in first storehouse or whatever is closest to the
-        // upgradebuilding if we have one!
-        nobBaseWarehouse* wh = GetUpgradeBuildingWarehouse();
-        SetGatheringForUpgradeWarehouse(wh);
-
-        if(ggs.GetMaxMilitaryRank() > 0) // there is more than 1 rank available -> distribute
-            DistributeMaxRankSoldiersByBlocking(5, wh);
-        // 30 boards amd 50 stones for each warehouse - block after that - should speed up expansion and limit losses in
-        // case a warehouse is destroyed unlimited when every warehouse has at least that amount
-        DistributeGoodsByBlocking(GD_BOARDS, 30);
-        DistributeGoodsByBlocking(GD_STONES, 50);
-        // go to the picked random warehouse and try to build around it
-        int randomStore = rand() % (storehouses.size());
-        auto it = storehouses.begin();
-        std::advance(it, randomStore);
-        const MapPoint whPos = (*it)->GetPos();
-        UpdateNodesAround(whPos, 15); // update the area we want to build in first
-        for(auto& i : bldToTest)
-        {
-            if(construction->Wanted(i))
-            {
-                AddBuildJobAroundEveryWarehouse(i); // add a buildorder for the picked buildingtype at every warehouse
-            }
+            if(ggs.GetMaxMilitaryRank() > 0) // there is more than 1 rank available -> distribute
+                DistributeMaxRankSoldiersByBlocking(5, wh);
+            // 30 boards amd 50 stones for each warehouse - block after that - should speed up expansion and limit
+            // losses in case a warehouse is destroyed unlimited when every warehouse has at least that amount
+            DistributeGoodsByBlocking(GD_BOARDS, 30);
+            DistributeGoodsByBlocking(GD_STONES, 50);
+            // go to the picked random warehouse and try to build around it
+            unsigned randomStore = Rand(static_cast<unsigned>(storehouses.size()));
+            auto it = storehouses.begin();
+            std::advance(it, randomStore);
+            state.whPos = (*it)->GetPos();
+            UpdateNodesAround(state.whPos, 15); // update the area we want to build in first
+        }
+    }
+
+    if(state.whPos.isValid())
+    {
+        while(state.nextWhBldType < BLDS_TO_PLAN.size())
+        {
+            if(!UseBudget(budget, 1))
+                return false;
+            const BuildingType bld = BLDS_TO_PLAN[state.nextWhBldType++];
+            if(construction->Wanted(bld))
+                AddBuildJobAroundEveryWarehouse(bld); // add a buildorder for the picked buildingtype at every warehouse
+        }
+        if(!state.isWhMilitaryJobAdded)
+        {
+            if(!UseBudget(budget, 1))
+                return false;
+            state.isWhMilitaryJobAdded = true;
+            if(gf > 1500 || aii.GetInventory().goods[GD_BOARDS] > 11)
+                AddMilitaryBuildJob(state.whPos);
         }
-        if(gf > 1500 || aii.GetInventory().goods[GD_BOARDS] > 11)
-            AddMilitaryBuildJob(whPos);
     }
     // end of construction around & orders for warehouses
 
     // now pick a random military building and try to build around that as well
-    const std::list<nobMilitary*>& militaryBuildings = aii.GetMilitaryBuildings();
-    if(militaryBuildings.empty())
-        return;
-    int randomMiliBld = rand() % militaryBuildings.size();
-    auto it2 = militaryBuildings.begin();
-    std::advance(it2, randomMiliBld);
-    MapPoint bldPos = (*it2)->GetPos();
-    UpdateNodesAround(bldPos, 15);
+    if(!state.isMilBldPicked)
+    {
+        if(!UseBudget(budget, PLAN_AROUND_BLD_OPS))
+            return false;
+        state.isMilBldPicked = true;
+        const std::list<nobMilitary*>& militaryBuildings = aii.GetMilitaryBuildings();
+        if(militaryBuildings.empty())
+            return true;
+        auto it = militaryBuildings.begin();
+        std::advance(it, Rand(static_cast<unsigned>(militaryBuildings.size())));
+        state.milBldPos = (*it)->GetPos();
+        UpdateNodesAround(state.milBldPos, 15);
+    }
     // resource gathering buildings only around military; processing only close to warehouses
-    for(unsigned i = 0; i < numResGatherBlds; i++)
+    while(state.nextMilBldType < NUM_RES_GATHER_BLDS)
     {
-        if(construction->Wanted(bldToTest[i]))
-        {
-            AddBuildJobAroundEveryMilBld(bldToTest[i]);
-        }
+        if(!UseBudget(budget, 1))
+            return false;
+        const BuildingType bld = BLDS_TO_PLAN[state.nextMilBldType++];
+        if(construction->Wanted(bld))
+            AddBuildJobAroundEveryMilBld(bld);
     }
-    AddMilitaryBuildJob(bldPos);
-    if((*it2)->IsUseless() && (*it2)->IsDemolitionAllowed() && randomMiliBld != UpdateUpgradeBuilding())
+    if(!UseBudget(budget, 1))
+        return false;
+    AddMilitaryBuildJob(state.milBldPos);
+    // Might be gone since the last GF
+    const auto* milBld = gwb.GetSpecObj<nobMilitary>(state.milBldPos);
+    if(milBld && milBld->GetPlayer() == playerId && milBld->IsUseless() && milBld->IsDemolitionAllowed())
     {
-        aii.DestroyBuilding(bldPos);
+        UpdateUpgradeBuilding();
+        if(state.milBldPos != UpgradeBldPos)
+            aii.DestroyBuilding(state.milBldPos);
     }
+    return true;
 }
 
 bool AIPlayerJH::TestDefeat()
@@ -490,126 +561,17 @@ void AIPlayerJH::SetGatheringForUpgradeWarehouse(nobBaseWarehouse* upgradewareho
     }
 }
 
-AIResource AIPlayerJH::CalcResource(const MapPoint pt)
-{
-    AIResource subRes = aii.GetSubsurfaceResource(pt);
-    AIResource surfRes = aii.GetSurfaceResource(pt);
-
-    // no resources underground
-    if(subRes == AIResource::NOTHING)
-    {
-        // also no resource on the ground: plant space or unusable?
-        if(surfRes == AIResource::NOTHING)
-        {
-            // already road, really no resources here
-            if(gwb.IsOnRoad(pt))
-                return AIResource::NOTHING;
-            // check for vital plant space
-            if(!gwb.IsOfTerrain(pt, [](const TerrainDesc& desc) { return desc.IsVital(); }))
-                return AIResource::NOTHING;
-            return AIResource::PLANTSPACE;
-        }
-
-        return surfRes;
-    } else // resources in underground
-    {
-        if(surfRes == AIResource::STONES || surfRes == AIResource::WOOD)
-            return AIResource::MULTIPLE;
-
-        if(subRes == AIResource::BLOCKED)
-            return AIResource::NOTHING; // nicht so ganz logisch... aber Blocked als res is doof TODO
-
-        return subRes;
-    }
-}
-
-void AIPlayerJH::InitReachableNodes()
-{
-    std::queue<MapPoint> toCheck;
-
-    // Alle auf not reachable setzen
-    RTTR_FOREACH_PT(MapPoint, aiMap.GetSize())
-    {
-        Node& node = aiMap[pt];
-        node.reachable = false;
-        node.failed_penalty = 0;
-        const auto* myFlag = gwb.GetSpecObj<noFlag>(pt);
-        if(myFlag && myFlag->GetPlayer() == playerId)
-        {
-            node.reachable = true;
-            toCheck.push(pt);
-        }
-    }
-
-    IterativeReachableNodeChecker(toCheck);
-}
-
-void AIPlayerJH::IterativeReachableNodeChecker(std::queue<MapPoint> toCheck)
-{
-    // TODO auch mal bootswege bauen können
-
-    PathConditionRoad<GameWorldBase> roadPathChecker(gwb, false);
-    while(!toCheck.empty())
-    {
-        // Reachable coordinate
-        MapPoint curPt = toCheck.front();
-
-        // Coordinates to test around this reachable coordinate
-        for(const auto dir : helpers::EnumRange<Direction>{})
-        {
-            MapPoint curNeighbour = aiMap.GetNeighbour(curPt, dir);
-            Node& node = aiMap[curNeighbour];
-
-            // already reached, don't test again
-            if(node.reachable)
-                continue;
-
-            // Test whether point is reachable; yes->add to check list
-            if(roadPathChecker.IsNodeOk(curNeighbour))
-            {
-                if(node.failed_penalty == 0)
-                {
-                    node.reachable = true;
-                    toCheck.push(curNeighbour);
-                } else
-                {
-                    node.failed_penalty--;
-                }
-            }
-        }
-        toCheck.pop();
-    }
-}
-
-void AIPlayerJH::UpdateReachableNodes(const std::vector<MapPoint>& pts)
-{
-    std::queue<MapPoint> toCheck;
-
-    for(const MapPoint& curPt : pts)
-    {
-        const auto* flag = gwb.GetSpecObj<noFlag>(curPt);
-        if(flag && flag->GetPlayer() == playerId)
-        {
-            aiMap[curPt].reachable = true;
-            toCheck.push(curPt);
-        } else
-            aiMap[curPt].reachable = false;
-    }
-    IterativeReachableNodeChecker(toCheck);
-}
-
 void AIPlayerJH::InitNodes()
 {
     aiMap.Resize(gwb.GetSize());
 
-    InitReachableNodes();
+    reachability.Init();
 
     RTTR_FOREACH_PT(MapPoint, aiMap.GetSize())
     {
         Node& node = aiMap[pt];
 
         node.bq = aii.GetBuildingQuality(pt);
-        node.res = CalcResource(pt);
         node.owned = aii.IsOwnTerritory(pt);
         node.border = aii.IsBorder(pt);
         node.farmed = false;
@@ -619,7 +581,7 @@ void AIPlayerJH::InitNodes()
 void AIPlayerJH::UpdateNodesAround(const MapPoint pt, unsigned radius)
 {
     std::vector<MapPoint> pts = gwb.GetPointsInRadius(pt, radius);
-    UpdateReachableNodes(pts);
+    reachability.Update(pts);
     for(const MapPoint& pt : pts)
     {
         Node& node = aiMap[pt];
@@ -633,10 +595,19 @@ void AIPlayerJH::UpdateNodesAround(const MapPoint pt, unsigned radius)
 void AIPlayerJH::InitResourceMaps()
 {
     resourceMaps.clear();
-    for(unsigned res = 0; res < NUM_AIRESOURCES; ++res)
+    for(unsigned i = 0; i < NUM_AIRESOURCES; ++i)
     {
-        resourceMaps.push_back(AIResourceMap(static_cast<AIResource>(res), aii, aiMap));
-        resourceMaps.back().Init();
+        const auto res = static_cast<AIResource>(i);
+        if(AIResourceMap::IsPlayerIndependent(res))
+        {
+            // Initialized by the knowledge
+            resourceMaps.push_back(
+              AIResourceMap(res, aii, aiMap, knowledge->GetResources(), knowledge->GetResourceValues(res)));
+        } else
+        {
+            resourceMaps.push_back(AIResourceMap(res, aii, aiMap, knowledge->GetResources()));
+            resourceMaps.back().Init();
+        }
     }
 }
 
@@ -1192,7 +1163,7 @@ unsigned AIPlayerJH::GetDensity(MapPoint pt, AIResource res, int radius)
     unsigned good = 0;
     for(const MapPoint& curPt : pts)
     {
-        if(aiMap[curPt].res == res)
+        if(knowledge->GetResource(curPt) == res)
             good++;
     }
 
@@ -1372,7 +1343,7 @@ void AIPlayerJH::HandleExpedition(const noShip* ship)
         aii.FoundColony(ship);
     else
     {
-        unsigned char start = rand() % ShipDirection::COUNT;
+        unsigned char start = Rand(ShipDirection::COUNT);
         for(unsigned char i = start; i < start + ShipDirection::COUNT; ++i)
         {
             if(aii.IsExplorationDirectionPossible(ship->GetPos(), ship->GetCurrentHarbor(), ShipDirection(i)))
@@ -1414,13 +1385,9 @@ void AIPlayerJH::HandleTreeChopped(const MapPoint pt)
 {
     // std::cout << "Tree chopped." << std::endl;
 
-    aiMap[pt].reachable = true;
-
     UpdateNodesAround(pt, 3);
 
-    int random = rand();
-
-    if(random % 2 == 0)
+    if(Rand(2) == 0)
         AddMilitaryBuildJob(pt);
     else // if (random % 12 == 0)
         AddBuildJob(BLD_WOODCUTTER, pt);
@@ -1676,60 +1643,78 @@ void AIPlayerJH::CheckGranitMine()
     }
 }
 
-void AIPlayerJH::TryToAttack()
+bool AIPlayerJH::TryToAttack(AttackState& state, unsigned& budget)
 {
-    unsigned hq_or_harbor_without_soldiers = 0;
-    std::vector<const nobBaseMilitary*> potentialTargets;
+    if(!state.isStarted)
+    {
+        // use own military buildings (except inland buildings) to search for enemy military buildings
+        for(const nobMilitary* milBld : aii.GetMilitaryBuildings())
+            state.milBldPositions.push_back(milBld->GetPos());
+        state.isStarted = true;
+    }
 
-    // use own military buildings (except inland buildings) to search for enemy military buildings
-    const std::list<nobMilitary*>& militaryBuildings = aii.GetMilitaryBuildings();
-    const unsigned numMilBlds = militaryBuildings.size();
+    const auto numMilBlds = static_cast<unsigned>(state.milBldPositions.size());
     // when the ai has many buildings the ai will not check the complete list every time
     constexpr unsigned limit = 40;
-    for(const nobMilitary* milBld : militaryBuildings)
+    while(state.nextMilBld < numMilBlds)
     {
+        if(budget == 0)
+            return false;
+        const MapPoint src = state.milBldPositions[state.nextMilBld++];
         // We skip the current building with a probability of limit/numMilBlds
         // -> For twice the number of blds as the limit we will most likely skip every 2nd building
         // This way we check roughly (at most) limit buildings but avoid any preference for one building over an other
-        if(rand() % numMilBlds > limit)
+        if(Rand(numMilBlds) > limit)
             continue;
 
+        // Might be gone since the last GF
+        const auto* milBld = gwb.GetSpecObj<nobMilitary>(src);
+        if(!milBld || milBld->GetPlayer() != playerId)
+            continue;
         if(milBld->GetFrontierDistance() == 0) // inland building? -> skip it
             continue;
+        budget--;
 
         // get nearby enemy buildings and store in set of potential attacking targets
-        MapPoint src = milBld->GetPos();
-
         sortedMilitaryBlds buildings = gwb.LookForMilitaryBuildings(src, 2);
         for(const nobBaseMilitary* target : buildings)
         {
-            if(helpers::contains(potentialTargets, target))
+            const MapPoint dest = target->GetPos();
+            if(helpers::contains(state.targets, dest))
                 continue;
             if(target->GetGOT() == GOT_NOB_MILITARY && static_cast<const nobMilitary*>(target)->IsNewBuilt())
                 continue;
-            MapPoint dest = target->GetPos();
             if(gwb.CalcDistance(src, dest) < BASE_ATTACKING_DISTANCE && aii.IsPlayerAttackable(target->GetPlayer())
                && aii.IsVisible(dest))
             {
                 if(target->GetGOT() != GOT_NOB_MILITARY && !target->DefendersAvailable())
                 {
                     // headquarter or harbor without any troops :)
-                    hq_or_harbor_without_soldiers++;
-                    potentialTargets.insert(potentialTargets.begin(), target);
+                    state.numUndefendedTargets++;
+                    state.targets.insert(state.targets.begin(), dest);
                 } else
-                    potentialTargets.push_back(target);
+                    state.targets.push_back(dest);
             }
         }
     }
 
-    // shuffle everything but headquarters and harbors without any troops in them
-    std::shuffle(potentialTargets.begin() + hq_or_harbor_without_soldiers, potentialTargets.end(),
-                 std::mt19937(std::random_device()()));
+    if(!state.areTargetsShuffled)
+    {
+        // shuffle everything but headquarters and harbors without any troops in them
+        Shuffle(state.targets.begin() + state.numUndefendedTargets, state.targets.end());
+        state.areTargetsShuffled = true;
+    }
 
     // check for each potential attacking target the number of available attacking soldiers
-    for(const nobBaseMilitary* target : potentialTargets)
+    while(state.nextTarget < state.targets.size())
     {
-        const MapPoint dest = target->GetPos();
+        if(budget == 0)
+            return false;
+        budget--;
+        const MapPoint dest = state.targets[state.nextTarget++];
+        const auto* target = gwb.GetSpecObj<nobBaseMilitary>(dest);
+        if(!target || !aii.IsPlayerAttackable(target->GetPlayer()))
+            continue;
 
         unsigned attackersCount = 0;
         unsigned attackersStrength = 0;
@@ -1761,8 +1746,9 @@ void AIPlayerJH::TryToAttack()
         }
 
         aii.Attack(dest, attackersCount, true);
-        return;
+        return true;
     }
+    return true;
 }
 
 void AIPlayerJH::TrySeaAttack()
@@ -1837,11 +1823,10 @@ void AIPlayerJH::TrySeaAttack()
             // \n",gwb.GetHarborPoint(i).x,gwb.GetHarborPoint(i).y);
         }
     }
-    auto prng = std::mt19937(std::random_device()());
     // any undefendedTargets? -> pick one by random
     if(!undefendedTargets.empty())
     {
-        std::shuffle(undefendedTargets.begin(), undefendedTargets.end(), prng);
+        Shuffle(undefendedTargets);
         for(const nobBaseMilitary* targetMilBld : undefendedTargets)
         {
             std::vector<GameWorldBase::PotentialSeaAttacker> attackers =
@@ -1857,7 +1842,7 @@ void AIPlayerJH::TrySeaAttack()
     unsigned limit = 15;
     unsigned skip = 0;
     if(searcharoundharborspots.size() > 15)
-        skip = std::max<int>(rand() % (searcharoundharborspots.size() / 15 + 1) * 15, 1) - 1;
+        skip = std::max<int>(Rand(static_cast<unsigned>(searcharoundharborspots.size() / 15 + 1)) * 15, 1) - 1;
     for(unsigned i = skip; i < searcharoundharborspots.size() && limit > 0; i++)
     {
         limit--;
@@ -1894,7 +1879,7 @@ void AIPlayerJH::TrySeaAttack()
     // random
     if(!undefendedTargets.empty())
     {
-        std::shuffle(undefendedTargets.begin(), undefendedTargets.end(), prng);
+        Shuffle(undefendedTargets);
         for(const nobBaseMilitary* targetMilBld : undefendedTargets)
         {
             std::vector<GameWorldBase::PotentialSeaAttacker> attackers =
@@ -1906,7 +1891,7 @@ void AIPlayerJH::TrySeaAttack()
             }
         }
     }
-    std::shuffle(potentialTargets.begin(), potentialTargets.end(), prng);
+    Shuffle(potentialTargets);
     for(const nobBaseMilitary* ship : potentialTargets)
     {
         // TODO: decide if it is worth attacking the target and not just "possible"
@@ -1932,20 +1917,12 @@ void AIPlayerJH::RecalcGround(const MapPoint buildingPos, std::vector<Direction>
 
     // building itself
     RecalcBQAround(pt);
-    if(aiMap[pt].res == AIResource::PLANTSPACE)
-    {
-        resourceMaps[static_cast<unsigned>(AIResource::PLANTSPACE)].Change(pt, -1);
-        aiMap[pt].res = AIResource::NOTHING;
-    }
+    RemovePlantSpace(pt);
 
     // flag of building
     pt = gwb.GetNeighbour(pt, Direction::SOUTHEAST);
     RecalcBQAround(pt);
-    if(aiMap[pt].res == AIResource::PLANTSPACE)
-    {
-        resourceMaps[static_cast<unsigned>(AIResource::PLANTSPACE)].Change(pt, -1);
-        aiMap[pt].res = AIResource::NOTHING;
-    }
+    RemovePlantSpace(pt);
 
     // along the road
     for(auto i : route_road)
@@ -1953,14 +1930,17 @@ void AIPlayerJH::RecalcGround(const MapPoint buildingPos, std::vector<Direction>
         pt = gwb.GetNeighbour(pt, i);
         RecalcBQAround(pt);
         // Auch Plantspace entsprechend anpassen:
-        if(aiMap[pt].res == AIResource::PLANTSPACE)
-        {
-            resourceMaps[static_cast<unsigned>(AIResource::PLANTSPACE)].Change(pt, -1);
-            aiMap[pt].res = AIResource::NOTHING;
-        }
+        RemovePlantSpace(pt);
     }
 }
 
+void AIPlayerJH::RemovePlantSpace(const MapPoint pt)
+{
+    // Other AIs sharing the map might have removed it already
+    if(knowledge->RemovePlantSpace(pt))
+        resourceMaps[static_cast<unsigned>(AIResource::PLANTSPACE)].Change(pt, -1);
+}
+
 void AIPlayerJH::SaveResourceMapsToFile()
 {
     for(unsigned res = 0; res < NUM_AIRESOURCES; ++res)
@@ -1982,6 +1962,11 @@ int AIPlayerJH::GetResMapValue(const MapPoint pt, AIResource res) const
     return GetResMap(res)[pt];
 }
 
+const AIKnowledge& AIPlayerJH::GetKnowledge() const
+{
+    return *knowledge;
+}
+
 const AIResourceMap& AIPlayerJH::GetResMap(AIResource res) const
 {
     return resourceMaps[static_cast<unsigned>(res)];
@@ -2028,25 +2013,59 @@ bool AIPlayerJH::IsFlagPartofCircle(const noFlag& startFlag, unsigned maxlen, co
 
 void AIPlayerJH::RemoveAllUnusedRoads(const MapPoint pt)
 {
-    std::vector<const noFlag*> flags = construction->FindFlags(pt, 25);
+    scheduler.Add("RemoveAllUnusedRoads", [this, pt, state = RemoveUnusedRoadsState()](unsigned& budget) mutable {
+        return RemoveAllUnusedRoads(pt, state, budget);
+    });
+}
+
+bool AIPlayerJH::RemoveAllUnusedRoads(const MapPoint pt, RemoveUnusedRoadsState& state, unsigned& budget)
+{
+    if(!state.isStarted)
+    {
+        for(const noFlag* flag : construction->FindFlags(pt, 25))
+            state.flagPositions.push_back(flag->GetPos());
+        state.isStarted = true;
+    }
     // Jede Flagge testen...
-    std::vector<const noFlag*> reconnectflags;
-    for(auto& flag : flags)
+    while(state.nextFlag < state.flagPositions.size())
     {
-        if(RemoveUnusedRoad(*flag, boost::none, true, false))
-            reconnectflags.push_back(flag);
+        if(budget == 0)
+            return false;
+        budget--;
+        const MapPoint flagPos = state.flagPositions[state.nextFlag++];
+        // Might be gone since the last GF
+        const auto* flag = gwb.GetSpecObj<noFlag>(flagPos);
+        if(flag && flag->GetPlayer() == playerId && RemoveUnusedRoad(*flag, boost::none, true, false))
+            state.reconnectFlagPositions.push_back(flagPos);
     }
     UpdateNodesAround(pt, 25);
-    for(const noFlag* flag : reconnectflags)
-        construction->AddConnectFlagJob(flag);
+    for(const MapPoint flagPos : state.reconnectFlagPositions)
+    {
+        const auto* flag = gwb.GetSpecObj<noFlag>(flagPos);
+        if(flag && flag->GetPlayer() == playerId)
+            construction->AddConnectFlagJob(flag);
+    }
+    return true;
 }
 
-void AIPlayerJH::CheckForUnconnectedBuildingSites()
+bool AIPlayerJH::CheckForUnconnectedBuildingSites(ConnectBuildingSitesState& state, unsigned& budget)
 {
-    if(construction->GetConnectJobNum() > 0 || construction->GetBuildJobNum() > 0)
-        return;
-    for(noBuildingSite* bldSite : player.GetBuildingRegister().GetBuildingSites()) //-V807
+    if(!state.isStarted)
     {
+        state.isStarted = true;
+        if(construction->GetConnectJobNum() > 0 || construction->GetBuildJobNum() > 0)
+            return true;
+        for(const noBuildingSite* bldSite : player.GetBuildingRegister().GetBuildingSites()) //-V807
+            state.bldSitePositions.push_back(bldSite->GetPos());
+    }
+    while(state.nextBldSite < state.bldSitePositions.size())
+    {
+        if(!UseBudget(budget, 1))
+            return false;
+        // Might be gone since the last GF
+        const auto* bldSite = gwb.GetSpecObj<noBuildingSite>(state.bldSitePositions[state.nextBldSite++]);
+        if(!bldSite || bldSite->GetPlayer() != playerId)
+            continue;
         noFlag* flag = bldSite->GetFlag();
         bool foundRoute = false;
         for(const auto dir : helpers::EnumRange<Direction>{})
@@ -2062,6 +2081,7 @@ void AIPlayerJH::CheckForUnconnectedBuildingSites()
         if(!foundRoute)
             construction->AddConnectFlagJob(flag);
     }
+    return true;
 }
 
 bool AIPlayerJH::RemoveUnusedRoad(const noFlag& startFlag, helpers::OptionalEnum<Direction> excludeDir,
@@ -20,13 +20,14 @@
 #include "ai/AIEventManager.h"
 #include "ai/AIPlayer.h"
 #include "ai/aijh/AIMap.h"
+#include "ai/aijh/AIReachability.h"
 #include "ai/aijh/AIResourceMap.h"
+#include "ai/aijh/TaskScheduler.h"
 #include "helpers/OptionalEnum.h"
 #include "gameTypes/MapCoordinates.h"
 #include <boost/container/static_vector.hpp>
 #include <list>
 #include <memory>
-#include <queue>
 
 class noFlag;
 class noShip;
@@ -38,19 +39,69 @@ class Base;
 namespace AIJH {
 class BuildingPlanner;
 class AIConstruction;
+class AIKnowledge;
 class Job;
 
 /// Create a subscription which records all nodes for which the BQ (may) have changed
 /// Requires arguments to have the same lifetime as the subscription
 Subscription recordBQsToUpdate(const GameWorldBase& gw, std::vector<MapPoint>& bqsToUpdate);
 
+/// State of TryToAttack between GFs
+struct AttackState
+{
+    bool isStarted = false;
+    /// Positions of our military buildings at the start
+    std::vector<MapPoint> milBldPositions;
+    unsigned nextMilBld = 0;
+    /// Positions of the buildings to attack, undefended ones first
+    std::vector<MapPoint> targets;
+    unsigned numUndefendedTargets = 0;
+    bool areTargetsShuffled = false;
+    unsigned nextTarget = 0;
+};
+
+/// State of RemoveAllUnusedRoads between GFs
+struct RemoveUnusedRoadsState
+{
+    bool isStarted = false;
+    std::vector<MapPoint> flagPositions;
+    unsigned nextFlag = 0;
+    std::vector<MapPoint> reconnectFlagPositions;
+};
+
+/// State of CheckForUnconnectedBuildingSites between GFs
+struct ConnectBuildingSitesState
+{
+    bool isStarted = false;
+    std::vector<MapPoint> bldSitePositions;
+    unsigned nextBldSite = 0;
+};
+
+/// State of PlanNewBuildings between GFs
+struct PlanBuildingsState
+{
+    bool isStarted = false;
+    /// Position of the randomly picked warehouse to build around, invalid if there is none
+    MapPoint whPos = MapPoint::Invalid();
+    unsigned nextWhBldType = 0;
+    bool isWhMilitaryJobAdded = false;
+    bool isMilBldPicked = false;
+    /// Position of the randomly picked military building to build around
+    MapPoint milBldPos = MapPoint::Invalid();
+    unsigned nextMilBldType = 0;
+};
+
 /// Klasse für die besser JH-KI
 class AIPlayerJH : public AIPlayer
 {
 public:
-    AIPlayerJH(unsigned char playerId, const GameWorldBase& gwb, AI::Level level);
+    /// Create the AI using the knowledge shared with the other AIs of the game or its own knowledge if none is given
+    AIPlayerJH(unsigned char playerId, const GameWorldBase& gwb, AI::Level level, uint64_t randomSeed,
+               std::shared_ptr<AIKnowledge> knowledge = nullptr);
     ~AIPlayerJH() override;
 
+    void Init() override;
+
     AIInterface& GetInterface() { return aii; }
     const AIInterface& GetInterface() const { return aii; }
     const GameWorldBase& GetWorld() const { return gwb; }
@@ -79,6 +130,7 @@ public:
     const AIResourceMap& GetResMap(AIResource res) const;
 
     const Node& GetAINode(const MapPoint pt) const { return aiMap[pt]; }
+    const AIKnowledge& GetKnowledge() const;
     unsigned GetNumPlannedConnectedInlandMilitaryBlds()
     {
         return std::max<unsigned>(6u, aii.GetMilitaryBuildings().size() / 5u);
@@ -93,11 +145,14 @@ public:
     unsigned AmountInStorage(GoodType good) const;
     unsigned AmountInStorage(::Job job) const;
 
-    void PlanNewBuildings(unsigned gf);
+    /// Order new buildings around a random warehouse and military building. Resumable task for the scheduler
+    bool PlanNewBuildings(unsigned gf, PlanBuildingsState& state, unsigned& budget);
 
     void SendAIEvent(std::unique_ptr<AIEvent::Base> ev);
 
     Node& GetAINode(const MapPoint pt) { return aiMap[pt]; }
+    /// Mark the node as unreachable for the given number of checks
+    void SetNodeFailed(const MapPoint pt, char penalty) { reachability.SetFailed(pt, penalty); }
     /// Executes a job form the job queue
     void ExecuteAIJob();
     /// Tries to build a bld of the given type at that point.
@@ -130,8 +185,6 @@ public:
     void InitNodes();
     /// Updates the nodes around a position
     void UpdateNodesAround(MapPoint pt, unsigned radius);
-    /// Returns the resource on a specific point
-    AIResource CalcResource(MapPoint pt);
     /// Initialize the resource maps
     void InitResourceMaps();
     /// Initialize the Store and Military building lists (only required when loading games but the AI doesnt know
@@ -202,8 +255,10 @@ public:
     void CheckForester();
     /// stop/resume granitemine production
     void CheckGranitMine();
-    /// Tries to attack the enemy
-    void TryToAttack();
+    /// destroy sawmills which have nothing to do
+    void CheckSawmills();
+    /// Tries to attack the enemy. Resumable task for the scheduler
+    bool TryToAttack(AttackState& state, unsigned& budget);
     /// sea attack
     void TrySeaAttack();
     /// checks if there is at least 1 sea id connected to the harbor spot with at least 2 harbor spots! when
@@ -214,13 +269,11 @@ public:
     bool BuildingNearby(MapPoint pt, BuildingType bldType, unsigned min);
     /// Update BQ and farming ground around new building site + road
     void RecalcGround(MapPoint buildingPos, std::vector<Direction>& route_road);
+    /// Remove the plant space at the node from the shared knowledge and the resource map
+    void RemovePlantSpace(MapPoint pt);
 
     void SaveResourceMapsToFile();
 
-    void InitReachableNodes();
-    void IterativeReachableNodeChecker(std::queue<MapPoint> toCheck);
-    void UpdateReachableNodes(const std::vector<MapPoint>& pts);
-
     /// disconnects 'inland' military buildings from road system(and sends out soldiers), sets stop gold, uses the
     /// upgrade building (order new private, kick out general)
     void MilUpgradeOptim();
@@ -230,9 +283,11 @@ public:
     // new connection
     bool RemoveUnusedRoad(const noFlag& startFlag, helpers::OptionalEnum<Direction> excludeDir, bool firstflag = true,
                           bool allowcircle = true, bool keepstartflag = false);
-    // finds all unused flags and roads, removes flags or reconnects them as neccessary
+    // finds all unused flags and roads, removes flags or reconnects them as neccessary (spread over multiple GFs)
     void RemoveAllUnusedRoads(MapPoint pt);
-    void CheckForUnconnectedBuildingSites();
+    bool RemoveAllUnusedRoads(MapPoint pt, RemoveUnusedRoadsState& state, unsigned& budget);
+    /// Order a road for every building site without one. Resumable task for the scheduler
+    bool CheckForUnconnectedBuildingSites(ConnectBuildingSitesState& state, unsigned& budget);
     // check if there are free soldiers (in hq/storehouses)
     unsigned SoldierAvailable(int rank = -1);
 
@@ -264,7 +319,12 @@ private:
     std::list<MapPoint> milBuildingSites;
     /// Nodes containing some information about every map node
     AIMap aiMap;
-    /// Resource maps, containing a rating for every map point concerning a resource
+    /// Keeps the reachable nodes of the AI map up to date
+    AIReachability reachability;
+    /// Knowledge about the world shared with the other AIs
+    std::shared_ptr<AIKnowledge> knowledge;
+    /// Resource maps, containing a rating for every map point concerning a resource.
+    /// The values of player independent resources are shared with the other AIs
     boost::container::static_vector<AIResourceMap, NUM_AIRESOURCES> resourceMaps;
 
     unsigned attack_interval;
@@ -275,6 +335,8 @@ private:
     AIEventManager eventManager;
     std::unique_ptr<BuildingPlanner> bldPlanner;
     std::unique_ptr<AIConstruction> construction;
+    /// Runs the periodic passes within a fixed amount of work per GF
+    TaskScheduler scheduler;
 
     Subscription subBuilding, subExpedition, subResource, subRoad, subShip, subBQ;
     std::vector<MapPoint> nodesWithOutdatedBQ;
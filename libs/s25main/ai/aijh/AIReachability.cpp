@@ -0,0 +1,179 @@
+// Copyright (c) 2016 - 2017 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "AIReachability.h"
+#include "RttrForeachPt.h"
+#include "helpers/EnumRange.h"
+#include "helpers/containerUtils.h"
+#include "pathfinding/PathConditionRoad.h"
+#include "world/GameWorldBase.h"
+#include "nodeObjs/noFlag.h"
+
+namespace AIJH {
+
+AIReachability::AIReachability(const GameWorldBase& gwb, unsigned char playerId, AIMap& aiMap)
+    : gwb(gwb), playerId(playerId), aiMap(aiMap)
+{}
+
+void AIReachability::Init()
+{
+    pathLens.Resize(aiMap.GetSize(), UNREACHABLE);
+    nodesWithoutPenalty.clear();
+
+    std::queue<MapPoint> toCheck;
+    RTTR_FOREACH_PT(MapPoint, aiMap.GetSize())
+    {
+        Node& node = aiMap[pt];
+        node.reachable = false;
+        node.failed_penalty = 0;
+        if(IsOwnFlag(pt))
+        {
+            SetPathLen(pt, 0);
+            toCheck.push(pt);
+        }
+    }
+    Expand(toCheck);
+}
+
+void AIReachability::Update(const std::vector<MapPoint>& pts)
+{
+    std::vector<MapPoint> changedPts(pts);
+    changedPts.insert(changedPts.end(), nodesWithoutPenalty.begin(), nodesWithoutPenalty.end());
+    nodesWithoutPenalty.clear();
+
+    // Remove all nodes which lost their path and all nodes whose path went over them
+    std::queue<MapPoint> toCheck;
+    for(const MapPoint pt : changedPts)
+        toCheck.push(pt);
+    std::vector<MapPoint> removedPts;
+    while(!toCheck.empty())
+    {
+        const MapPoint curPt = toCheck.front();
+        toCheck.pop();
+        const unsigned curPathLen = pathLens[curPt];
+        if(curPathLen == UNREACHABLE || IsConnected(curPt))
+            continue;
+        SetPathLen(curPt, UNREACHABLE);
+        removedPts.push_back(curPt);
+        for(const auto dir : helpers::EnumRange<Direction>{})
+        {
+            const MapPoint neighbourPt = aiMap.GetNeighbour(curPt, dir);
+            const unsigned neighbourPathLen = pathLens[neighbourPt];
+            if(neighbourPathLen != UNREACHABLE && neighbourPathLen > curPathLen)
+                toCheck.push(neighbourPt);
+        }
+    }
+
+    // Fill the changed area again from all reachable nodes around it and from new flags
+    for(const MapPoint pt : changedPts)
+    {
+        if(pathLens[pt] != 0 && IsOwnFlag(pt))
+            SetPathLen(pt, 0);
+    }
+    changedPts.insert(changedPts.end(), removedPts.begin(), removedPts.end());
+    for(const MapPoint pt : changedPts)
+    {
+        if(pathLens[pt] != UNREACHABLE)
+            toCheck.push(pt);
+        for(const auto dir : helpers::EnumRange<Direction>{})
+        {
+            const MapPoint neighbourPt = aiMap.GetNeighbour(pt, dir);
+            if(pathLens[neighbourPt] != UNREACHABLE)
+                toCheck.push(neighbourPt);
+        }
+    }
+    Expand(toCheck);
+}
+
+void AIReachability::SetFailed(const MapPoint pt, char penalty)
+{
+    aiMap[pt].failed_penalty = penalty;
+    Update(std::vector<MapPoint>(1, pt));
+}
+
+bool AIReachability::IsOwnFlag(const MapPoint pt) const
+{
+    const auto* flag = gwb.GetSpecObj<noFlag>(pt);
+    return flag && flag->GetPlayer() == playerId;
+}
+
+bool AIReachability::IsConnected(const MapPoint pt) const
+{
+    if(IsOwnFlag(pt))
+        return true;
+    if(aiMap[pt].failed_penalty > 0 || !PathConditionRoad<GameWorldBase>(gwb, false).IsNodeOk(pt))
+        return false;
+    const unsigned pathLen = pathLens[pt];
+    for(const auto dir : helpers::EnumRange<Direction>{})
+    {
+        if(pathLens[aiMap.GetNeighbour(pt, dir)] < pathLen)
+            return true;
+    }
+    return false;
+}
+
+void AIReachability::SetPathLen(const MapPoint pt, unsigned len)
+{
+    pathLens[pt] = len;
+    aiMap[pt].reachable = len != UNREACHABLE;
+}
+
+void AIReachability::Expand(std::queue<MapPoint>& toCheck)
+{
+    // TODO auch mal bootswege bauen können
+    PathConditionRoad<GameWorldBase> roadPathChecker(gwb, false);
+    // Nodes are pushed multiple times, but the penalty counts down only once per check (few nodes have one)
+    std::vector<MapPoint> penalizedPts;
+    while(!toCheck.empty())
+    {
+        // Reachable coordinate
+        const MapPoint curPt = toCheck.front();
+        toCheck.pop();
+        const unsigned newPathLen = pathLens[curPt] + 1;
+
+        // Coordinates to test around this reachable coordinate
+        for(const auto dir : helpers::EnumRange<Direction>{})
+        {
+            const MapPoint curNeighbour = aiMap.GetNeighbour(curPt, dir);
+            // already reached by a path at least as short, don't test again
+            if(pathLens[curNeighbour] <= newPathLen)
+                continue;
+
+            if(IsOwnFlag(curNeighbour))
+            {
+                SetPathLen(curNeighbour, 0);
+                toCheck.push(curNeighbour);
+            } else if(roadPathChecker.IsNodeOk(curNeighbour))
+            {
+                Node& node = aiMap[curNeighbour];
+                if(node.failed_penalty == 0)
+                {
+                    SetPathLen(curNeighbour, newPathLen);
+                    toCheck.push(curNeighbour);
+                } else if(!helpers::contains(penalizedPts, curNeighbour))
+                {
+                    penalizedPts.push_back(curNeighbour);
+                    if(--node.failed_penalty == 0)
+                        nodesWithoutPenalty.push_back(curNeighbour);
+                }
+            }
+        }
+    }
+}
+
+} // namespace AIJH
@@ -0,0 +1,68 @@
+// Copyright (c) 2016 - 2017 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "ai/aijh/AIMap.h"
+#include "world/NodeMapBase.h"
+#include "gameTypes/MapCoordinates.h"
+#include <limits>
+#include <queue>
+#include <vector>
+
+class GameWorldBase;
+
+namespace AIJH {
+
+/// Keeps the reachable flag of the AI map up to date: A node is reachable if a road from one of our flags can go there.
+/// Every reachable node stores the length of a path to one of our flags (not necessarily the shortest one).
+/// A node stays reachable as long as it has a neighbour with a shorter path, so when nodes change only the nodes
+/// depending on them are removed and the area around them is filled again instead of the whole map.
+class AIReachability
+{
+public:
+    AIReachability(const GameWorldBase& gwb, unsigned char playerId, AIMap& aiMap);
+
+    /// Calculate the reachable nodes of the whole map. Also resets the failed penalties
+    void Init();
+    /// Update the reachable nodes after the given nodes might have changed (objects, roads, territory)
+    void Update(const std::vector<MapPoint>& pts);
+    /// Mark the node as unreachable for the given number of checks (e.g. after building there failed).
+    /// Every Update reaching the node counts as one check, including the one done here
+    void SetFailed(MapPoint pt, char penalty);
+
+private:
+    static constexpr unsigned UNREACHABLE = std::numeric_limits<unsigned>::max();
+
+    bool IsOwnFlag(MapPoint pt) const;
+    /// Return true if the node still has a path to one of our flags
+    bool IsConnected(MapPoint pt) const;
+    void SetPathLen(MapPoint pt, unsigned len);
+    /// Add all neighbours of the given reachable nodes which can be reached over them
+    void Expand(std::queue<MapPoint>& toCheck);
+
+    const GameWorldBase& gwb;
+    const unsigned char playerId;
+    AIMap& aiMap;
+    /// Length of a path to one of our flags or UNREACHABLE
+    NodeMapBase<unsigned> pathLens;
+    /// Nodes whose penalty ran out and which might be reachable now
+    std::vector<MapPoint> nodesWithoutPenalty;
+};
+
+} // namespace AIJH
@@ -22,33 +22,110 @@
 #include "buildings/noBuildingSite.h"
 #include "buildings/nobUsual.h"
 #include "gameData/TerrainDesc.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <vector>
 
 namespace AIJH {
 
-AIResourceMap::AIResourceMap(const AIResource res, const AIInterface& aii, const AIMap& aiMap)
-    : res(res), resRadius(RES_RADIUS[static_cast<unsigned>(res)]), aii(aii), aiMap(aiMap)
-{}
+namespace {
+    /// Add radius - distance to all points within the radius around every source, multiplied by the source value.
+    /// This is the same as calling Change(pt, radius, value) for every source but takes O(radius) per node instead of
+    /// O(radius^2) per source:
+    /// In a row at a vertical distance a from a source the a + 1 points closest to it get radius - a and each further
+    /// point one less. Such a trapezoid is the sum of boxes widening by 1 on each side, which can be summed up in O(1)
+    /// using the prefix sums of the prefix sums of the row.
+    /// Relies on the even map height, so the horizontal offsets of the rows are the same when wrapping around.
+    void AddCones(NodeMapBase<int>& map, const std::vector<int>& sources, unsigned radius)
+    {
+        const int width = map.GetWidth();
+        const int height = map.GetHeight();
+        RTTR_Assert(height % 2 == 0);
+        const int r = static_cast<int>(radius);
+        if(r == 0)
+            return;
+        // Rows are extended on both sides by wrapping around so no index computation needs to wrap
+        const int pad = r + 1;
+        const int rowSize = width + 2 * pad + 2;
+        // prefixSums2[y * rowSize + i] = Sum of P[0..i-1] with P[j] = Sum of the extended row y before j
+        std::vector<int64_t> prefixSums2(static_cast<size_t>(height) * rowSize);
+        for(int y = 0; y < height; y++)
+        {
+            int64_t* const rowSums = &prefixSums2[static_cast<size_t>(y) * rowSize];
+            const int* const rowSources = &sources[static_cast<size_t>(y) * width];
+            int64_t prefixSum = 0;
+            rowSums[0] = 0;
+            for(int i = 0; i + 1 < rowSize; i++)
+            {
+                rowSums[i + 1] = rowSums[i] + prefixSum;
+                prefixSum += rowSources[((i - pad) % width + width) % width];
+            }
+        }
+
+        for(int y = 0; y < height; y++)
+        {
+            for(int dy = 1 - r; dy < r; dy++)
+            {
+                const int srcY = ((y + dy) % height + height) % height;
+                const int64_t* const rowSums = &prefixSums2[static_cast<size_t>(srcY) * rowSize];
+                const int a = std::abs(dy);
+                // Odd rows are shifted half a node to the right
+                const int shift = (srcY & 1) - (y & 1);
+                // Offset of the first and last source node with the full weight (a + shift is even)
+                const int firstOffset = pad + (-a - shift) / 2;
+                const int lastOffset = pad + (a - shift) / 2;
+                const int numBoxes = r - a;
+                for(int x = 0; x < width; x++)
+                {
+                    const int first = x + firstOffset;
+                    const int last = x + lastOffset;
+                    const int64_t value = (rowSums[last + numBoxes + 1] - rowSums[last + 1])
+                                          - (rowSums[first + 1] - rowSums[first - numBoxes + 1]);
+                    map[y * width + x] += static_cast<int>(value);
+                }
+            }
+        }
+    }
+} // namespace
+
+AIResourceMap::AIResourceMap(const AIResource res, const AIInterface& aii, const AIMap& aiMap,
+                             const NodeMapBase<AIResource>& resources, std::shared_ptr<Values> values)
+    : res(res), resRadius(RES_RADIUS[static_cast<unsigned>(res)]),
+      values(values ? std::move(values) : std::make_shared<Values>()), aii(aii), aiMap(aiMap), resources(resources)
+{
+    // Values depending on the player cannot be shared
+    RTTR_Assert(this->values.use_count() == 1 || IsPlayerIndependent(res));
+}
 
 AIResourceMap::~AIResourceMap() = default;
 
 void AIResourceMap::Init()
 {
-    const MapExtent mapSize = aiMap.GetSize();
+    const MapExtent mapSize = resources.GetSize();
 
-    map.Resize(mapSize);
+    values->map.Resize(mapSize);
+    ResetBlocks();
+    std::vector<int> sources(prodOfComponents(mapSize));
     RTTR_FOREACH_PT(MapPoint, mapSize)
     {
-        const Node& node = aiMap[pt];
-        if(res == AIResource::FISH && node.res == res)
-            Change(pt, 1);
-        else if(aii.gwb.GetDescription().get(aii.gwb.GetNode(pt).t1).Is(ETerrain::Walkable))
-        {
-            if((res != AIResource::BORDERLAND && node.res == res) || (res == AIResource::BORDERLAND && aii.IsBorder(pt))
-               || (node.res == AIResource::MULTIPLE
-                   && (aii.GetSubsurfaceResource(pt) == res || aii.GetSurfaceResource(pt) == res)))
-                Change(pt, 1);
-        }
+        if(IsSource(pt))
+            sources[values->map.GetIdx(pt)] = 1;
     }
+    AddCones(values->map, sources, resRadius);
+}
+
+bool AIResourceMap::IsSource(const MapPoint pt) const
+{
+    const AIResource nodeRes = resources[pt];
+    if(res == AIResource::FISH && nodeRes == res)
+        return true;
+    if(!aii.gwb.GetDescription().get(aii.gwb.GetNode(pt).t1).Is(ETerrain::Walkable))
+        return false;
+    return (res != AIResource::BORDERLAND && nodeRes == res) || (res == AIResource::BORDERLAND && aii.IsBorder(pt))
+           || (nodeRes == AIResource::MULTIPLE
+               && (aii.GetSubsurfaceResource(pt) == res || aii.GetSurfaceResource(pt) == res));
 }
 
 void AIResourceMap::Recalc()
@@ -81,78 +158,267 @@ void AIResourceMap::AdjustRatingForBlds(BuildingType bld, unsigned radius, int v
 }
 
 namespace {
-    struct ValueAdjuster
+    /// Return the position of the point at the given offset from the center in the order of GetPointsInRadius:
+    /// Ring by ring, each starting at the west-most point and going clockwise.
+    /// The offset is in axial coordinates: dq to the east and dr to the south (south-east on the hex grid)
+    unsigned GetSearchRank(int dq, int dr, unsigned& distance)
     {
-        NodeMapBase<int>& map;
-        unsigned radius;
-        int value;
-
-        ValueAdjuster(NodeMapBase<int>& map, unsigned radius, int value) : map(map), radius(radius), value(value) {}
-        bool operator()(const MapPoint pt, unsigned r) const
+        const int r = std::max(std::max(std::abs(dq), std::abs(dr)), std::abs(dq + dr));
+        distance = static_cast<unsigned>(r);
+        if(r == 0)
+            return 0;
+        // The 6 sides of the ring in walking order starting with going north-east from the west-most point
+        int side, step;
+        if(dq + dr == -r && dr > -r)
+        {
+            side = 0;
+            step = -dr;
+        } else if(dr == -r && dq < r)
+        {
+            side = 1;
+            step = dq;
+        } else if(dq == r && dr < 0)
         {
-            map[pt] += value * (radius - r);
-            return false; // Don't exit
+            side = 2;
+            step = dr + r;
+        } else if(dq + dr == r && dr < r)
+        {
+            side = 3;
+            step = dr;
+        } else if(dr == r && dq > -r)
+        {
+            side = 4;
+            step = -dq;
+        } else
+        {
+            RTTR_Assert(dq == -r && dr > 0);
+            side = 5;
+            step = r - dr;
         }
-    };
+        // The rings inside have 1 + 3r(r-1) points
+        return static_cast<unsigned>(1 + 3 * r * (r - 1) + side * r + step);
+    }
+
+    /// Y coordinate converted to the offset of the axial coordinates (odd rows are shifted half a node to the right)
+    int GetRowShift(int y)
+    {
+        return (y - (y & 1)) / 2;
+    }
 } // namespace
 
 void AIResourceMap::Change(const MapPoint pt, unsigned radius, int value)
 {
-    aii.gwb.CheckPointsInRadius(pt, radius, ValueAdjuster(map, radius, value), true);
+    aii.gwb.CheckPointsInRadius(
+      pt, radius,
+      [this, radius, value](const MapPoint curPt, unsigned r) {
+          values->map[curPt] += value * (radius - r);
+          InvalidateBlock(curPt);
+          return false; // Don't exit
+      },
+      true);
+}
+
+void AIResourceMap::ResetBlocks()
+{
+    values->numBlocks = MapExtent((values->map.GetWidth() + BLOCK_SIZE - 1) / BLOCK_SIZE,
+                                  (values->map.GetHeight() + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    values->blockMax.clear();
+    values->blockMax.resize(prodOfComponents(values->numBlocks));
+    values->isBlockMaxValid.clear();
+    values->isBlockMaxValid.resize(values->blockMax.size(), false);
+}
+
+int AIResourceMap::GetBlockMax(unsigned blockIdx) const
+{
+    if(!values->isBlockMaxValid[blockIdx])
+    {
+        const MapPoint firstPt((blockIdx % values->numBlocks.x) * BLOCK_SIZE,
+                               (blockIdx / values->numBlocks.x) * BLOCK_SIZE);
+        const MapPoint endPt(std::min<unsigned>(firstPt.x + BLOCK_SIZE, values->map.GetWidth()),
+                             std::min<unsigned>(firstPt.y + BLOCK_SIZE, values->map.GetHeight()));
+        int maxValue = std::numeric_limits<int>::min();
+        for(MapCoord y = firstPt.y; y < endPt.y; y++)
+        {
+            for(MapCoord x = firstPt.x; x < endPt.x; x++)
+                maxValue = std::max(maxValue, values->map[MapPoint(x, y)]);
+        }
+        values->blockMax[blockIdx] = maxValue;
+        values->isBlockMaxValid[blockIdx] = true;
+    }
+    return values->blockMax[blockIdx];
+}
+
+bool AIResourceMap::CanUseBlocks(unsigned radius) const
+{
+    // Every point may be reached only once within the radius, else the search order cannot be reconstructed
+    return values->map.GetWidth() > 2 * radius + 2 && values->map.GetHeight() > 2 * radius + 1;
+}
+
+std::vector<unsigned> AIResourceMap::GetBlocksInRadius(const MapPoint pt, unsigned radius) const
+{
+    const auto getBlockCoords = [](int center, int radius, int mapSize) {
+        std::vector<unsigned> result;
+        for(int coord = center - radius; coord <= center + radius; coord++)
+            result.push_back(static_cast<unsigned>((coord % mapSize + mapSize) % mapSize) / BLOCK_SIZE);
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        return result;
+    };
+    // Rows are shifted, so up to one more point on each side
+    const std::vector<unsigned> blockXs = getBlockCoords(pt.x, radius + 1, values->map.GetWidth());
+    const std::vector<unsigned> blockYs = getBlockCoords(pt.y, radius, values->map.GetHeight());
+    std::vector<unsigned> result;
+    result.reserve(blockXs.size() * blockYs.size());
+    for(unsigned blockY : blockYs)
+    {
+        for(unsigned blockX : blockXs)
+            result.push_back(blockY * values->numBlocks.x + blockX);
+    }
+    return result;
+}
+
+template<class T_Func>
+void AIResourceMap::ForEachPointInBlock(unsigned blockIdx, const MapPoint center, unsigned radius, T_Func&& func) const
+{
+    const int width = values->map.GetWidth();
+    const int height = values->map.GetHeight();
+    const MapPoint firstPt((blockIdx % values->numBlocks.x) * BLOCK_SIZE,
+                           (blockIdx / values->numBlocks.x) * BLOCK_SIZE);
+    const MapPoint endPt(std::min<unsigned>(firstPt.x + BLOCK_SIZE, width),
+                         std::min<unsigned>(firstPt.y + BLOCK_SIZE, height));
+    for(MapCoord y = firstPt.y; y < endPt.y; y++)
+    {
+        // Offsets are unique as the point is at most radius away (see CanUseBlocks)
+        int dy = y - center.y;
+        if(dy > height / 2)
+            dy -= height;
+        else if(dy < -height / 2)
+            dy += height;
+        // Unwrapped coordinate has the same parity as the map height is even
+        const int rowShift = GetRowShift(center.y + dy) - GetRowShift(center.y);
+        for(MapCoord x = firstPt.x; x < endPt.x; x++)
+        {
+            int dx = x - center.x;
+            if(dx > width / 2)
+                dx -= width;
+            else if(dx < -width / 2)
+                dx += width;
+            unsigned distance;
+            const unsigned searchRank = GetSearchRank(dx - rowShift, dy, distance);
+            if(distance <= radius)
+                func(MapPoint(x, y), searchRank);
+        }
+    }
 }
 
 MapPoint AIResourceMap::FindGoodPosition(const MapPoint& pt, int threshold, BuildingQuality size, int radius,
                                          bool inTerritory) const
 {
-    RTTR_Assert(pt.x < map.GetWidth() && pt.y < map.GetHeight());
+    RTTR_Assert(pt.x < values->map.GetWidth() && pt.y < values->map.GetHeight());
 
     // TODO was besseres wär schön ;)
     if(radius == -1)
         radius = 30;
 
-    std::vector<MapPoint> pts = aii.gwb.GetPointsInRadiusWithCenter(pt, radius);
-    for(const MapPoint& curPt : pts)
+    const auto isGoodPosition = [this, threshold, size, inTerritory](const MapPoint curPt) {
+        const unsigned idx = values->map.GetIdx(curPt);
+        if(values->map[idx] < threshold || (inTerritory && !aiMap[idx].owned) || aiMap[idx].farmed)
+            return false;
+        RTTR_Assert(aii.GetBuildingQuality(curPt) == aiMap[curPt].bq);
+        return canUseBq(aii.GetBuildingQuality(curPt), size); //(*nodes)[idx].bq; TODO: Update nodes BQ and use that
+    };
+
+    if(!CanUseBlocks(radius))
     {
-        const unsigned idx = map.GetIdx(curPt);
-        if(map[idx] >= threshold)
+        std::vector<MapPoint> pts = aii.gwb.GetPointsInRadiusWithCenter(pt, radius);
+        for(const MapPoint& curPt : pts)
         {
-            if((inTerritory && !aiMap[idx].owned) || aiMap[idx].farmed)
-                continue;
-            RTTR_Assert(aii.GetBuildingQuality(curPt) == aiMap[curPt].bq);
-            if(canUseBq(aii.GetBuildingQuality(curPt), size)) //(*nodes)[idx].bq; TODO: Update nodes BQ and use that
+            if(isGoodPosition(curPt))
                 return curPt;
         }
+        return MapPoint::Invalid();
     }
-    return MapPoint::Invalid();
+
+    // Return the first good position in the order of the points in the radius
+    MapPoint result = MapPoint::Invalid();
+    unsigned resultRank = std::numeric_limits<unsigned>::max();
+    for(unsigned blockIdx : GetBlocksInRadius(pt, radius))
+    {
+        if(GetBlockMax(blockIdx) < threshold)
+            continue;
+        ForEachPointInBlock(blockIdx, pt, radius, [&](const MapPoint curPt, unsigned searchRank) {
+            if(searchRank < resultRank && isGoodPosition(curPt))
+            {
+                result = curPt;
+                resultRank = searchRank;
+            }
+        });
+    }
+    return result;
 }
 
 MapPoint AIResourceMap::FindBestPosition(const MapPoint& pt, BuildingQuality size, int minimum, int radius,
                                          bool inTerritory) const
 {
-    RTTR_Assert(pt.x < map.GetWidth() && pt.y < map.GetHeight());
+    RTTR_Assert(pt.x < values->map.GetWidth() && pt.y < values->map.GetHeight());
 
     // TODO was besseres wär schön ;)
     if(radius == -1)
         radius = 30;
 
+    const auto isUsable = [this, size, inTerritory](const MapPoint curPt) {
+        const unsigned idx = values->map.GetIdx(curPt);
+        if(!aiMap[idx].reachable || (inTerritory && !aiMap[idx].owned) || aiMap[idx].farmed)
+            return false;
+        RTTR_Assert(aii.GetBuildingQuality(curPt) == aiMap[curPt].bq);
+        return canUseBq(aii.GetBuildingQuality(curPt), size); //(*nodes)[idx].bq; TODO: Update nodes BQ and use that
+    };
+
     MapPoint best = MapPoint::Invalid();
     int best_value = (minimum == std::numeric_limits<int>::min()) ? minimum : minimum - 1;
 
-    std::vector<MapPoint> pts = aii.gwb.GetPointsInRadiusWithCenter(pt, radius);
-    for(const MapPoint& curPt : pts)
+    if(!CanUseBlocks(radius))
     {
-        const unsigned idx = map.GetIdx(curPt);
-        if(map[idx] > best_value)
+        std::vector<MapPoint> pts = aii.gwb.GetPointsInRadiusWithCenter(pt, radius);
+        for(const MapPoint& curPt : pts)
         {
-            if(!aiMap[idx].reachable || (inTerritory && !aiMap[idx].owned) || aiMap[idx].farmed)
-                continue;
-            RTTR_Assert(aii.GetBuildingQuality(curPt) == aiMap[curPt].bq);
-            if(canUseBq(aii.GetBuildingQuality(curPt), size)) //(*nodes)[idx].bq; TODO: Update nodes BQ and use that
+            if(values->map[curPt] > best_value && isUsable(curPt))
             {
                 best = curPt;
-                best_value = map[idx];
+                best_value = values->map[curPt];
             }
         }
+        return best;
+    }
+
+    // Same result as going through all points in order and taking the first one with the highest value:
+    // Look at the most promising blocks first and skip blocks which cannot contain a better value.
+    // On equal values the one coming first in the search order wins
+    std::vector<std::pair<int, unsigned>> blocks;
+    for(unsigned blockIdx : GetBlocksInRadius(pt, radius))
+    {
+        const int blockValue = GetBlockMax(blockIdx);
+        if(blockValue > best_value)
+            blocks.emplace_back(blockValue, blockIdx);
+    }
+    std::sort(blocks.begin(), blocks.end(), std::greater<std::pair<int, unsigned>>());
+    unsigned bestRank = std::numeric_limits<unsigned>::max();
+    for(const auto& block : blocks)
+    {
+        if(best.isValid() ? block.first < best_value : block.first <= best_value)
+            break;
+        ForEachPointInBlock(block.second, pt, radius, [&](const MapPoint curPt, unsigned searchRank) {
+            const int value = values->map[curPt];
+            const bool isBetter = best.isValid() ?
+                                    (value > best_value || (value == best_value && searchRank < bestRank)) :
+                                    value > best_value;
+            if(isBetter && isUsable(curPt))
+            {
+                best = curPt;
+                best_value = value;
+                bestRank = searchRank;
+            }
+        });
     }
 
     return best;
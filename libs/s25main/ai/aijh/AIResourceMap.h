@@ -22,6 +22,8 @@
 #include "world/NodeMapBase.h"
 #include "gameTypes/BuildingQuality.h"
 #include "gameTypes/BuildingType.h"
+#include <memory>
+#include <vector>
 
 class AIInterface;
 namespace AIJH {
@@ -29,9 +31,29 @@ namespace AIJH {
 class AIResourceMap
 {
 public:
-    AIResourceMap(AIResource res, const AIInterface& aii, const AIMap& aiMap);
+    /// Side length of the blocks of which the maximum value is kept to speed up searches
+    static constexpr unsigned BLOCK_SIZE = 8;
+
+    /// Values of the map and the maximum value of each block
+    struct Values
+    {
+        NodeMapBase<int> map;
+        /// Number of blocks in x and y direction
+        MapExtent numBlocks;
+        /// Maximum value of each block, updated lazily on searches
+        std::vector<int> blockMax;
+        std::vector<bool> isBlockMaxValid;
+    };
+
+    /// Create a map for the AI using the given interface and map with the resources of all nodes.
+    /// Maps of resources not depending on the player can share their values with the maps of other AIs
+    AIResourceMap(AIResource res, const AIInterface& aii, const AIMap& aiMap, const NodeMapBase<AIResource>& resources,
+                  std::shared_ptr<Values> values = nullptr);
     ~AIResourceMap();
 
+    /// Return true if the values of the map are the same for all players (only the border land is not)
+    static bool IsPlayerIndependent(AIResource res) { return res != AIResource::BORDERLAND; }
+
     /// Initialize the resource map
     void Init();
     void Recalc();
@@ -51,18 +73,44 @@ public:
         return FindBestPosition(pt, size, 1, radius, inTerritory);
     }
 
-    int& operator[](const MapPoint& pt) { return map[pt]; }
-    int operator[](const MapPoint& pt) const { return map[pt]; }
+    int& operator[](const MapPoint& pt)
+    {
+        InvalidateBlock(pt);
+        return values->map[pt];
+    }
+    int operator[](const MapPoint& pt) const { return values->map[pt]; }
 
 private:
+    /// Return true if the point adds to the rating of the surrounding points on Init
+    bool IsSource(MapPoint pt) const;
     void AdjustRatingForBlds(BuildingType bld, unsigned radius, int value);
+
+    /// Resize the blocks to the map size and invalidate them
+    void ResetBlocks();
+    void InvalidateBlock(const MapPoint pt)
+    {
+        values->isBlockMaxValid[(pt.y / BLOCK_SIZE) * values->numBlocks.x + pt.x / BLOCK_SIZE] = false;
+    }
+    /// Return the maximum value of the block, recalculating it if it was invalidated
+    int GetBlockMax(unsigned blockIdx) const;
+    /// Return true if the blocks can be used for searches in the given radius (map is big enough)
+    bool CanUseBlocks(unsigned radius) const;
+    /// Return the indices of all blocks containing points in the radius around pt
+    std::vector<unsigned> GetBlocksInRadius(MapPoint pt, unsigned radius) const;
+    /// Call func(pt, searchRank) for every point of the block within the radius around center.
+    /// searchRank is the index of the point in the result of GetPointsInRadiusWithCenter
+    template<class T_Func>
+    void ForEachPointInBlock(unsigned blockIdx, MapPoint center, unsigned radius, T_Func&& func) const;
+
     /// Which resource is stored in the map and radius of affected nodes
     const AIResource res;
     const unsigned resRadius;
 
-    NodeMapBase<int> map;
+    /// Possibly shared with the maps of other AIs
+    std::shared_ptr<Values> values;
     const AIInterface& aii;
     const AIMap& aiMap;
+    const NodeMapBase<AIResource>& resources;
 };
 
 } // namespace AIJH
@@ -218,10 +218,9 @@ void BuildJob::BuildMainRoad()
             std::cout << "Player " << (unsigned)aijh.GetPlayerId() << ", Job failed: Cannot connect "
                       << BUILDING_NAMES[type] << " at " << target.x << "/" << target.y << ". Retrying..." << std::endl;
 #endif
-            aijh.GetAINode(target).reachable = false;
             // We thought this had be reachable, but it is not (might be blocked by building site itself):
             // It has to be reachable in a check for 20x times, to avoid retrying it too often.
-            aijh.GetAINode(target).failed_penalty = 20;
+            aijh.SetNodeFailed(target, 20);
             aiInterface.DestroyBuilding(target);
             aiInterface.DestroyFlag(houseFlag->GetPos());
             aijh.AddBuildJob(type, around);
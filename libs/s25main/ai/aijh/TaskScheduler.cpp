@@ -0,0 +1,85 @@
+// Copyright (c) 2016 - 2017 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "TaskScheduler.h"
+#include "RTTR_Assert.h"
+#include <algorithm>
+
+namespace AIJH {
+
+TaskScheduler::TaskScheduler(unsigned budgetPerGF) : budgetPerGF(budgetPerGF)
+{
+    RTTR_Assert(budgetPerGF > 0u);
+}
+
+TaskScheduler::TaskFunc TaskScheduler::MakeSingleStepTask(unsigned numOps, std::function<void()> func) const
+{
+    const unsigned minBudget = std::min(numOps, budgetPerGF);
+    return [numOps, minBudget, func](unsigned& budget) {
+        if(budget < minBudget)
+            return false;
+        func();
+        budget -= std::min(budget, numOps);
+        return true;
+    };
+}
+
+void TaskScheduler::Add(std::string name, TaskFunc func)
+{
+    tasks.push_back(Task{std::move(name), std::move(func)});
+}
+
+bool TaskScheduler::AddUnique(std::string name, TaskFunc func)
+{
+    if(IsQueued(name))
+        return false;
+    Add(std::move(name), std::move(func));
+    return true;
+}
+
+bool TaskScheduler::IsQueued(const std::string& name) const
+{
+    return std::any_of(tasks.begin(), tasks.end(), [&name](const Task& task) { return task.name == name; });
+}
+
+void TaskScheduler::RunGF()
+{
+    unsigned budget = budgetPerGF;
+    while(budget > 0u && !tasks.empty())
+    {
+        const unsigned oldBudget = budget;
+        // The task may add new tasks, so don't keep a reference into the queue
+        TaskFunc func = std::move(tasks.front().func);
+        const bool isFinished = func(budget);
+        RTTR_Assert(budget <= oldBudget);
+        if(isFinished)
+        {
+            tasks.pop_front();
+            // Every task costs something, so a GF can only start a limited number of them
+            if(budget == oldBudget)
+                budget--;
+        } else
+        {
+            tasks.front().func = std::move(func);
+            // Not finished or waiting for a GF with enough budget left
+            break;
+        }
+    }
+}
+
+} // namespace AIJH
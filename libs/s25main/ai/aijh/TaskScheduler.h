@@ -0,0 +1,65 @@
+// Copyright (c) 2016 - 2017 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <string>
+
+namespace AIJH {
+
+/// Runs the periodic passes of an AI spread over multiple GFs, so a GF never does more than a fixed amount of work.
+/// Work is counted in operations (e.g. one building or flag checked) instead of time to keep the AI deterministic.
+/// Tasks run in the order they were added. A task not finished in one GF continues in the next one before any other.
+class TaskScheduler
+{
+public:
+    /// Do at most budget operations, subtract the operations done from it and return true when finished.
+    /// Must keep all state needed to continue in the next GF and must not rely on objects staying alive in between
+    using TaskFunc = std::function<bool(unsigned& budget)>;
+
+    explicit TaskScheduler(unsigned budgetPerGF);
+
+    /// Create a task which does all its work at once and counts as the given number of operations.
+    /// It waits for the next GF if less is left of the budget of this GF, unless it costs more than the whole budget.
+    /// Then it waits for a GF in which nothing else was done yet
+    TaskFunc MakeSingleStepTask(unsigned numOps, std::function<void()> func) const;
+
+    /// Add a task to the end of the queue
+    void Add(std::string name, TaskFunc func);
+    /// Add a task unless one with the same name is queued already. Return true if it was added
+    bool AddUnique(std::string name, TaskFunc func);
+    bool IsQueued(const std::string& name) const;
+    unsigned GetNumTasks() const { return static_cast<unsigned>(tasks.size()); }
+    unsigned GetBudgetPerGF() const { return budgetPerGF; }
+
+    /// Run the queued tasks until the budget of this GF is used up
+    void RunGF();
+
+private:
+    struct Task
+    {
+        std::string name;
+        TaskFunc func;
+    };
+    std::deque<Task> tasks;
+    const unsigned budgetPerGF;
+};
+
+} // namespace AIJH
@@ -17,27 +17,19 @@
 
 #include "dskBenchmark.h"
 #include "Game.h"
+#include "GlobalVars.h"
 #include "Loader.h"
-#include "PlayerInfo.h"
-#include "RttrForeachPt.h"
 #include "WindowManager.h"
-#include "buildings/nobMilitary.h"
 #include "controls/ctrlText.h"
 #include "drivers/VideoDriverWrapper.h"
 #include "dskMainMenu.h"
-#include "factories/BuildingFactory.h"
-#include "figures/nofPassiveSoldier.h"
-#include "figures/nofPassiveWorker.h"
-#include "helpers/mathFuncs.h"
+#include "helpers/containerUtils.h"
 #include "helpers/toString.h"
-#include "lua/GameDataLoader.h"
 #include "ogl/FontStyle.h"
 #include "ogl/IRenderer.h"
-#include "random/Random.h"
 #include "world/GameWorld.h"
 #include "world/GameWorldView.h"
 #include "world/GameWorldViewer.h"
-#include "world/MapLoader.h"
 #include "gameTypes/RoadBuildState.h"
 #include "gameData/GameLoader.h"
 #include "s25util/Log.h"
@@ -45,6 +37,7 @@
 #include <helpers/chronoIO.h>
 #include <memory>
 #include <random>
+#include <stdexcept>
 
 namespace {
 enum
@@ -71,7 +64,8 @@ struct dskBenchmark::GameView
 };
 
 dskBenchmark::dskBenchmark()
-    : curTest_(TEST_NONE), runAll_(false), numInstances_(1000), frameCtr_(FrameCounter::clock::duration::max())
+    : curTest_(TEST_NONE), runAll_(false), numInstances_(1000), frameCtr_(FrameCounter::clock::duration::max()),
+      isNonInteractive_(false)
 {
     AddText(ID_txtHelp, DrawPoint(5, 5), "Use F1-F5 to start benchmark, F10 for all, NUM_n to set amount of instances",
             COLOR_YELLOW, FontStyle::LEFT, LargeFont);
@@ -80,6 +74,23 @@ dskBenchmark::dskBenchmark()
         t = std::chrono::milliseconds::zero();
 }
 
+dskBenchmark::dskBenchmark(const std::vector<std::string>& benchmarkNames, int numInstances,
+                           boost::filesystem::path resultPath)
+    : dskBenchmark()
+{
+    numInstances_ = numInstances;
+    resultPath_ = std::move(resultPath);
+    isNonInteractive_ = true;
+    for(const std::string& name : benchmarkNames)
+    {
+        if(benchmarks::isSimulation(name))
+            pendingSimulations_.push_back(name);
+        else
+            pendingTests_.push_back(Test(helpers::indexOf(benchmarks::getDrawingNames(), name) + 1));
+    }
+    GetCtrl<ctrlText>(ID_txtAmount)->SetText("Instances: " + helpers::toString(numInstances_));
+}
+
 dskBenchmark::~dskBenchmark()
 {
     try
@@ -137,6 +148,16 @@ void dskBenchmark::Msg_PaintAfter()
         frameCtr_.update();
         if(frameCtr_.getCurNumFrames() >= numTestFrames)
             finishTest();
+    } else if(isNonInteractive_)
+    {
+        if(pendingTests_.empty())
+            finishNonInteractive();
+        else
+        {
+            const Test test = pendingTests_.front();
+            pendingTests_.erase(pendingTests_.begin());
+            startTest(test);
+        }
     }
     dskMenuBase::Msg_PaintAfter();
 }
@@ -219,64 +240,13 @@ void dskBenchmark::startTest(Test test)
             break;
         }
         case TEST_EMPTY_GAME:
-            createGame();
-            if(!game_)
-                return;
-            RTTR_FOREACH_PT(MapPoint, game_->world_.GetSize())
-            {
-                game_->world_.SetVisibility(pt, 0, VIS_VISIBLE);
-            }
-            break;
         case TEST_BASIC_GAME:
-        {
-            createGame();
-            if(!game_)
-                return;
-            std::vector<MapPoint> hqs(2, MapPoint(0, 0));
-            hqs[1].x += 30;
-            MapLoader::PlaceHQs(game_->world_, hqs, false);
-            break;
-        }
         case TEST_FULL_GAME:
-        {
-            createGame();
+            // Same order as the scenarios
+            createGame(benchmarks::GameScenario(test - TEST_EMPTY_GAME));
             if(!game_)
                 return;
-            std::vector<MapPoint> hqs(2, MapPoint(0, 0));
-            hqs[1].x += 30;
-            MapLoader::PlaceHQs(game_->world_, hqs, false);
-            for(unsigned i = 0; i < hqs.size(); i++)
-            {
-                std::vector<MapPoint> pts = game_->world_.GetPointsInRadius(hqs[i], 15);
-                std::bernoulli_distribution dist(numInstances_ / 1000.f);
-                std::bernoulli_distribution distEqual;
-                std::array<BuildingType, 5> blds = {
-                  {BLD_BARRACKS, BLD_MILL, BLD_IRONMINE, BLD_SLAUGHTERHOUSE, BLD_BAKERY}};
-                std::uniform_int_distribution<unsigned> getBld(0, blds.size() - 1);
-                std::uniform_int_distribution<unsigned> getJob(0, NUM_JOB_TYPES - 1);
-                std::uniform_int_distribution<int> getDir(0, Direction::COUNT - 1);
-                for(MapPoint pt : pts)
-                {
-                    MapPoint flagPt = game_->world_.GetNeighbour(pt, Direction::SOUTHEAST);
-                    if(game_->world_.GetNode(pt).obj || game_->world_.GetNode(flagPt).obj || !dist(rng))
-                        continue;
-                    BuildingType bldType = blds[getBld(rng)];
-                    noBuilding* bld = BuildingFactory::CreateBuilding(game_->world_, bldType, pt, i,
-                                                                      distEqual(rng) ? NAT_AFRICANS : NAT_JAPANESE);
-                    if(bldType == BLD_BARRACKS)
-                    {
-                        auto* mil = static_cast<nobMilitary*>(bld);
-                        auto* sld = new nofPassiveSoldier(pt, i, mil, mil, 0);
-                        mil->AddPassiveSoldier(sld);
-                    }
-                    auto* figure = new nofPassiveWorker(Job(getJob(rng)), flagPt, i, nullptr);
-                    game_->world_.AddFigure(flagPt, figure);
-                    figure->StartWandering();
-                    figure->StartWalking(Direction::fromInt(getDir(rng)));
-                }
-            }
             break;
-        }
     }
     if(game_)
         gameView_ = std::make_unique<GameView>(game_->world_, VIDEODRIVER.GetRenderSize());
@@ -292,6 +262,11 @@ void dskBenchmark::finishTest()
     LOG.write("Benchmark #%1% took %2%. -> %3%m/frame\n") % curTest_
       % duration_cast<duration<float>>(frameCtr_.getCurIntervalLength())
       % duration_cast<milliseconds>(frameCtr_.getCurIntervalLength() / frameCtr_.getCurNumFrames());
+    if(isNonInteractive_)
+    {
+        results_.push_back(benchmarks::Result{benchmarks::getDrawingNames()[curTest_ - 1], frameCtr_.getCurNumFrames(),
+                                              frameCtr_.getCurIntervalLength()});
+    }
     if(testDurations_[curTest_] == milliseconds::zero())
         testDurations_[curTest_] = duration_cast<milliseconds>(frameCtr_.getCurIntervalLength());
     else
@@ -322,60 +297,17 @@ void dskBenchmark::finishTest()
     }
 }
 
-void dskBenchmark::createGame()
+void dskBenchmark::createGame(benchmarks::GameScenario scenario)
 {
-    RANDOM.Init(42);
-    std::vector<PlayerInfo> players;
-    PlayerInfo p;
-    p.ps = PS_OCCUPIED;
-    p.nation = NAT_AFRICANS;
-    p.color = PLAYER_COLORS[0];
-    players.push_back(p);
-    p.nation = NAT_JAPANESE;
-    p.color = PLAYER_COLORS[1];
-    players.push_back(p);
-    game_ = std::make_shared<Game>(GlobalGameSettings(), 0u, players);
-    GameWorld& world = game_->world_;
     try
     {
-        loadGameData(world.GetDescriptionWriteable());
-        world.Init(MapExtent(128, 128));
-        const WorldDescription& desc = world.GetDescription();
-        DescIdx<TerrainDesc> lastTerrain(0);
-        int lastHeight = 10;
-        std::mt19937 rng(42);
-        using std::uniform_int_distribution;
-        uniform_int_distribution<int> percentage(0, 100);
-        uniform_int_distribution<int> randTerrain(0, desc.terrain.size() / 2);
-        RTTR_FOREACH_PT(MapPoint, world.GetSize())
-        {
-            MapNode& node = world.GetNodeWriteable(pt);
-            DescIdx<TerrainDesc> t;
-            // 90% chance of using the same terrain
-            if(percentage(rng) <= 90)
-                t = lastTerrain;
-            else
-                t.value = randTerrain(rng);
-            node.t1 = t;
-            lastTerrain = t;
-            if(percentage(rng) <= 90)
-                t = lastTerrain;
-            else
-                t.value = randTerrain(rng);
-            node.t2 = t;
-            lastTerrain = t;
-            if(percentage(rng) <= 70)
-                lastHeight = helpers::clamp(lastHeight + uniform_int_distribution<int>(-1, 1)(rng), 8, 13);
-            node.altitude = lastHeight;
-        }
-        MapLoader::InitShadows(world);
-        MapLoader::SetMapExplored(world);
-
+        game_ = benchmarks::createGame(scenario, numInstances_);
         GameLoader loader(LOADER, game_);
         if(!loader.load())
-            throw "GUI";
-    } catch(...)
+            throw std::runtime_error("Could not load the game graphics");
+    } catch(const std::exception& e)
     {
+        LOG.write("Benchmark game could not be created: %1%\n") % e.what();
         game_.reset();
     }
 }
@@ -393,3 +325,26 @@ void dskBenchmark::printTimes() const
     LOG.write("Total benchmark time; %1% -> %2%/frame\n") % duration_cast<duration<float>>(total)
       % duration_cast<milliseconds>(total / numTestFrames);
 }
+
+void dskBenchmark::finishNonInteractive()
+{
+    isNonInteractive_ = false;
+    for(const std::string& name : pendingSimulations_)
+    {
+        try
+        {
+            results_.push_back(benchmarks::runSimulation(name, numInstances_));
+            LOG.write("Benchmark %1% took %2%\n") % name
+              % std::chrono::duration_cast<std::chrono::duration<float>>(results_.back().duration);
+        } catch(const std::exception& e)
+        {
+            LOG.write("Benchmark %1% failed: %2%\n") % name % e.what();
+        }
+    }
+    pendingSimulations_.clear();
+    if(benchmarks::writeResults(resultPath_, results_, numInstances_))
+        LOG.write("Benchmark results written to %1%\n") % resultPath_;
+    else
+        LOG.write("Could not write benchmark results to %1%\n") % resultPath_;
+    GLOBALVARS.notdone = false;
+}
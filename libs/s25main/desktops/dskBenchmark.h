@@ -17,10 +17,13 @@
 
 #pragma once
 
+#include "BenchmarkScenarios.h"
 #include "FrameCounter.h"
 #include "desktops/dskMenuBase.h"
+#include <boost/filesystem/path.hpp>
 #include <chrono>
 #include <memory>
+#include <string>
 #include <vector>
 
 class Game;
@@ -52,6 +55,9 @@ class dskBenchmark : public dskMenuBase
 
 public:
     dskBenchmark();
+    /// Run the given benchmarks (see benchmarks::parseNames) without interaction, write the results to resultPath and
+    /// quit the program
+    dskBenchmark(const std::vector<std::string>& benchmarkNames, int numInstances, boost::filesystem::path resultPath);
     ~dskBenchmark();
 
     bool Msg_KeyDown(const KeyEvent& ke) override;
@@ -68,9 +74,17 @@ private:
     std::shared_ptr<Game> game_;
     std::unique_ptr<GameView> gameView_;
     std::array<std::chrono::milliseconds, TEST_CT> testDurations_;
+    /// Tests still to run and simulation benchmarks to run afterwards in non-interactive mode
+    std::vector<Test> pendingTests_;
+    std::vector<std::string> pendingSimulations_;
+    std::vector<benchmarks::Result> results_;
+    boost::filesystem::path resultPath_;
+    bool isNonInteractive_;
 
     void startTest(Test test);
     void finishTest();
-    void createGame();
+    void createGame(benchmarks::GameScenario scenario);
     void printTimes() const;
+    /// Run the simulation benchmarks, write the results and quit
+    void finishNonInteractive();
 };
@@ -18,10 +18,12 @@
 #include "dskGameInterface.h"
 #include "CollisionDetection.h"
 #include "EventManager.h"
+#include "GFProfiler.h"
 #include "Game.h"
 #include "GamePlayer.h"
 #include "Loader.h"
 #include "NWFInfo.h"
+#include "RttrConfig.h"
 #include "Settings.h"
 #include "SoundManager.h"
 #include "WindowManager.h"
@@ -36,6 +38,8 @@
 #include "controls/ctrlText.h"
 #include "driver/MouseCoords.h"
 #include "drivers/VideoDriverWrapper.h"
+#include "dskGameLoader.h"
+#include "files.h"
 #include "helpers/format.hpp"
 #include "helpers/strUtils.h"
 #include "helpers/toString.h"
@@ -84,8 +88,10 @@
 #include "gameData/TerrainDesc.h"
 #include "gameData/const_gui_ids.h"
 #include "liblobby/LobbyClient.h"
+#include "s25util/MyTime.h"
 #include <algorithm>
 #include <cstdio>
+#include <numeric>
 #include <utility>
 
 namespace {
@@ -398,6 +404,60 @@ void dskGameInterface::Msg_PaintAfter()
                          COLOR_YELLOW);
         iconPos -= DrawPoint(magnifierImg->getWidth() + 4, 0);
     }
+
+    if(GFPROFILER.IsEnabled())
+        DrawProfilerOverlay();
+}
+
+void dskGameInterface::DrawProfilerOverlay() const
+{
+    /// Number of GFs averaged
+    constexpr unsigned numAvgGFs = 100;
+    /// Number of slots shown
+    constexpr unsigned numShownSlots = 6;
+
+    const GFProfiler::GFTimes avgTimes = GFPROFILER.GetAverage(numAvgGFs);
+    GFProfiler::Duration maxTime = GFProfiler::Duration::zero();
+    const auto& recordedGFs = GFPROFILER.GetRecordedGFs();
+    for(auto it = recordedGFs.end() - avgTimes.gf; it != recordedGFs.end(); ++it)
+        maxTime = std::max(maxTime, it->total);
+
+    using microseconds = std::chrono::duration<double, std::micro>;
+    DrawPoint curPos(30, 1 + NormalFont->getHeight());
+    NormalFont->Draw(curPos,
+                     helpers::format(_("Profiler: %1% GFs, avg %2$.1f us, max %3$.1f us"), avgTimes.gf,
+                                     microseconds(avgTimes.total).count(), microseconds(maxTime).count()),
+                     FontStyle{}, COLOR_YELLOW);
+
+    std::array<unsigned, GFProfiler::NUM_SLOTS> slots;
+    std::iota(slots.begin(), slots.end(), 0u);
+    std::partial_sort(slots.begin(), slots.begin() + numShownSlots, slots.end(),
+                      [&avgTimes](unsigned lhs, unsigned rhs) { return avgTimes.slots[lhs] > avgTimes.slots[rhs]; });
+    for(unsigned i = 0; i < numShownSlots; i++)
+    {
+        const unsigned slot = slots[i];
+        if(avgTimes.slots[slot] == GFProfiler::Duration::zero())
+            break;
+        curPos.y += NormalFont->getHeight();
+        NormalFont->Draw(curPos,
+                         helpers::format("%1%: %2$.1f us", GFProfiler::GetSlotName(slot),
+                                         microseconds(avgTimes.slots[slot]).count()),
+                         FontStyle{}, COLOR_YELLOW);
+    }
+}
+
+void dskGameInterface::WriteProfile()
+{
+    const bfs::path basePath =
+      RTTRCONFIG.ExpandPath(s25::folders::logs) / s25util::Time::FormatTime("profile_%Y-%m-%d_%H-%i-%s");
+    const bfs::path csvPath = bfs::path(basePath).replace_extension("csv");
+    const bfs::path jsonPath = bfs::path(basePath).replace_extension("json");
+    if(GFPROFILER.WriteCSV(csvPath) && GFPROFILER.WriteJSON(jsonPath))
+    {
+        messenger.AddMessage("", 0, CD_SYSTEM,
+                             helpers::format(_("Profile saved to %1%"), csvPath.parent_path().string()), COLOR_GREEN);
+    } else
+        messenger.AddMessage("", 0, CD_SYSTEM, _("Could not save the profile"), COLOR_RED);
 }
 
 bool dskGameInterface::Msg_LeftDown(const MouseCoords& mc)
@@ -700,6 +760,12 @@ bool dskGameInterface::Msg_KeyDown(const KeyEvent& ke)
             WINDOWMANAGER.ToggleWindow(
               std::make_unique<iwMapDebug>(gwv, game_->world_.IsSinglePlayer() || GAMECLIENT.IsReplayModeOn()));
             return true;
+        case KT_F5: // Toggle the GF profiler
+            GFPROFILER.SetEnabled(!GFPROFILER.IsEnabled());
+            return true;
+        case KT_F6: // Save the GF profile
+            WriteProfile();
+            return true;
         case KT_F8: // Tastaturbelegung
             WINDOWMANAGER.ToggleWindow(std::make_unique<iwTextfile>("keyboardlayout.txt", _("Keyboard layout")));
             return true;
@@ -1104,6 +1170,14 @@ void dskGameInterface::GI_FlagDestroyed(const MapPoint pt)
     }
 }
 
+/**
+ *  Replay is restarted from a keyframe
+ */
+void dskGameInterface::CI_GameLoading(const std::shared_ptr<Game>& game)
+{
+    WINDOWMANAGER.Switch(std::make_unique<dskGameLoader>(game));
+}
+
 void dskGameInterface::CI_PlayerLeft(const unsigned playerId)
 {
     // Info-Meldung ausgeben
@@ -65,6 +65,7 @@ public:
 
     RoadBuildMode GetRoadMode() const { return road.mode; }
 
+    void CI_GameLoading(const std::shared_ptr<Game>& game) override;
     void CI_PlayerLeft(unsigned playerId) override;
     void CI_GGSChanged(const GlobalGameSettings& ggs) override;
     void CI_Chat(unsigned playerId, ChatDestination cd, const std::string& msg) override;
@@ -148,6 +149,11 @@ private:
     void StopScrolling();
     void StartScrolling(const Position& mousePos);
 
+    /// Draw the averaged times of the last GFs and the slowest slots
+    void DrawProfilerOverlay() const;
+    /// Write the recorded GF times to the log folder
+    void WriteProfile();
+
     PostBox& GetPostBox();
     std::shared_ptr<const Game> game_;
     std::shared_ptr<const NWFInfo> nwfInfo_;
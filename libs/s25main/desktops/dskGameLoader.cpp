@@ -79,6 +79,10 @@ void dskGameLoader::Msg_MsgBoxResult(const unsigned msgbox_id, const MsgboxResul
 
 void dskGameLoader::Msg_Timer(const unsigned /*ctrl_id*/)
 {
+    // Wait till the world is loaded (timer keeps running)
+    if(position == 4 && GAMECLIENT.IsWorldLoadPending())
+        return;
+
     auto* timer = GetCtrl<ctrlTimer>(1);
     auto* text = GetCtrl<ctrlText>(10 + position);
     using namespace std::chrono_literals;
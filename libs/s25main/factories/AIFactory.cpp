@@ -17,15 +17,57 @@
 
 #include "AIFactory.h"
 #include "ai/DummyAI.h"
+#include "ai/aijh/AIKnowledge.h"
 #include "ai/aijh/AIPlayerJH.h"
+#include "random/Random.h"
+#include "world/GameWorldBase.h"
 #include "gameTypes/AIInfo.h"
+#include <future>
+
+namespace {
+/// The seed for the random generator of an AI. Derived from the state of the game RNG, which is the same for everyone
+/// starting the same game (or savegame), without drawing from it. So the decisions of the AIs can be reproduced but
+/// they do not change the course of the game RNG
+uint64_t GetRandomSeed(unsigned playerId)
+{
+    return (static_cast<uint64_t>(RANDOM.GetChecksum()) << 32) ^ ((playerId + 1) * UINT64_C(0x9E3779B97F4A7C15));
+}
+} // namespace
 
 std::unique_ptr<AIPlayer> AIFactory::Create(const AI::Info& aiInfo, unsigned playerId, const GameWorldBase& world)
 {
+    std::unique_ptr<AIPlayer> ai = CreateUninitialized(aiInfo, playerId, world, nullptr);
+    ai->Init();
+    return ai;
+}
+
+std::vector<std::unique_ptr<AIPlayer>> AIFactory::Create(const std::vector<unsigned>& playerIds,
+                                                         const GameWorldBase& world)
+{
+    // Creation registers the AIs for notifications, so only the initialization (reading the world) runs in parallel
+    const auto knowledge = std::make_shared<AIJH::AIKnowledge>();
+    std::vector<std::unique_ptr<AIPlayer>> ais;
+    for(unsigned playerId : playerIds)
+        ais.push_back(CreateUninitialized(world.GetPlayer(playerId).aiInfo, playerId, world, knowledge));
+    std::vector<std::future<void>> initResults;
+    for(std::unique_ptr<AIPlayer>& ai : ais)
+        initResults.push_back(std::async(std::launch::async, [&ai]() { ai->Init(); }));
+    for(std::future<void>& result : initResults)
+        result.get();
+    return ais;
+}
+
+std::unique_ptr<AIPlayer> AIFactory::CreateUninitialized(const AI::Info& aiInfo, unsigned playerId,
+                                                         const GameWorldBase& world,
+                                                         const std::shared_ptr<AIJH::AIKnowledge>& knowledge)
+{
+    const uint64_t randomSeed = GetRandomSeed(playerId);
     switch(aiInfo.type)
     {
-        case AI::DUMMY: return std::make_unique<DummyAI>(playerId, world, aiInfo.level); break;
+        case AI::DUMMY: return std::make_unique<DummyAI>(playerId, world, aiInfo.level, randomSeed); break;
         case AI::DEFAULT:
-        default: return std::make_unique<AIJH::AIPlayerJH>(playerId, world, aiInfo.level); break;
+        default:
+            return std::make_unique<AIJH::AIPlayerJH>(playerId, world, aiInfo.level, randomSeed, knowledge);
+            break;
     }
 }
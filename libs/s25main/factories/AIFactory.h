@@ -18,17 +18,31 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 class GameWorldBase;
 class AIPlayer;
 namespace AI {
 struct Info;
 }
+namespace AIJH {
+class AIKnowledge;
+}
 
 class AIFactory
 {
 public:
     AIFactory() = delete;
 
+    /// Create and initialize the AI for a player
     static std::unique_ptr<AIPlayer> Create(const AI::Info& aiInfo, unsigned playerId, const GameWorldBase& world);
+    /// Create the AIs for the given players with their AI infos. The AIs are initialized in parallel and share their
+    /// knowledge about the world
+    static std::vector<std::unique_ptr<AIPlayer>> Create(const std::vector<unsigned>& playerIds,
+                                                         const GameWorldBase& world);
+
+private:
+    static std::unique_ptr<AIPlayer> CreateUninitialized(const AI::Info& aiInfo, unsigned playerId,
+                                                         const GameWorldBase& world,
+                                                         const std::shared_ptr<AIJH::AIKnowledge>& knowledge);
 };
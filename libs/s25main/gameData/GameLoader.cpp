@@ -20,6 +20,7 @@
 #include "GamePlayer.h"
 #include "Loader.h"
 #include "RttrForeachPt.h"
+#include "TraceRecorder.h"
 #include "addons/const_addons.h"
 #include "files.h"
 #include "helpers/containerUtils.h"
@@ -81,6 +82,7 @@ void GameLoader::initTextures()
 
 bool GameLoader::loadTextures()
 {
+    RTTR_TRACE_SCOPE("GameLoader::loadTextures");
     std::vector<AddonId> enabledAddons;
     for(const auto id : rttrEnum::values<AddonId>)
     {
@@ -21,7 +21,12 @@
 #include <boost/nowide/fstream.hpp>
 #include <bzlib.h>
 #include <cmath>
-#include <memory>
+#include <vector>
+
+namespace {
+/// Size of the buffer for decompressed data when streaming
+constexpr unsigned STREAM_BUFFER_SIZE = 64 * 1024;
+} // namespace
 
 bool CompressedData::DecompressToFile(const boost::filesystem::path& filePath, unsigned* checksum)
 {
@@ -33,11 +38,29 @@ bool CompressedData::DecompressToFile(const boost::filesystem::path& filePath, u
         return false;
     }
 
-    auto uncompressedData = std::unique_ptr<char[]>(new char[length]);
+    std::vector<char> uncompressedData;
+    if(!DecompressToBuffer(uncompressedData))
+        return false;
+
+    if(!file.write(uncompressedData.data(), length))
+    {
+        LOG.write("FATAL ERROR: Writing to %s failed\n") % filePath;
+        return false;
+    }
+
+    if(checksum)
+        *checksum = CalcChecksumOfBuffer(uncompressedData.data(), length);
+
+    return true;
+}
+
+bool CompressedData::DecompressToBuffer(std::vector<char>& uncompressedData)
+{
+    uncompressedData.resize(length);
 
     unsigned outLength = length;
 
-    int err = BZ2_bzBuffToBuffDecompress(uncompressedData.get(), &outLength, &data[0], data.size(), 0, 0);
+    int err = BZ2_bzBuffToBuffDecompress(uncompressedData.data(), &outLength, data.data(), data.size(), 0, 0);
     if(err != BZ_OK)
     {
         LOG.write("FATAL ERROR: BZ2_bzBuffToBuffDecompress failed with code %d\n") % err;
@@ -49,45 +72,167 @@ bool CompressedData::DecompressToFile(const boost::filesystem::path& filePath, u
         LOG.write("FATAL ERROR: Length mismatch after decompressing. Expected: %u, got %u\n") % length % outLength;
         return false;
     }
-
-    if(!file.write(uncompressedData.get(), length))
-    {
-        LOG.write("FATAL ERROR: Writing to %s failed\n") % filePath;
-        return false;
-    }
-
-    if(checksum)
-        *checksum = CalcChecksumOfBuffer(uncompressedData.get(), length);
-
     return true;
 }
 
 bool CompressedData::CompressFromFile(const boost::filesystem::path& filePath, unsigned* checksum /* = nullptr */)
 {
     boost::nowide::ifstream file(filePath, std::ios::binary | std::ios::ate);
-    length = static_cast<unsigned>(file.tellg());
-    data.resize(static_cast<int>(std::ceil(length * 1.1))
-                + 600); // Buffer should be at most 1% bigger + 600 Bytes according to docu
+    const auto fileLength = static_cast<unsigned>(file.tellg());
     file.seekg(0);
 
-    auto uncompressedData = std::unique_ptr<char[]>(new char[length]);
+    std::vector<char> uncompressedData(fileLength);
 
-    if(!file.read(uncompressedData.get(), length))
+    if(!file.read(uncompressedData.data(), fileLength))
     {
         LOG.write("Could not read from %s\n") % filePath;
         return false;
     }
 
+    if(!CompressFromBuffer(uncompressedData.data(), fileLength))
+        return false;
+
+    if(checksum)
+        *checksum = CalcChecksumOfBuffer(uncompressedData.data(), length);
+    return true;
+}
+
+bool CompressedData::CompressFromBuffer(const char* uncompressedData, unsigned uncompressedLength)
+{
+    length = uncompressedLength;
+    data.resize(static_cast<int>(std::ceil(length * 1.1))
+                + 600); // Buffer should be at most 1% bigger + 600 Bytes according to docu
+
     unsigned compressedLen = data.size();
-    int err = BZ2_bzBuffToBuffCompress(&data[0], &compressedLen, uncompressedData.get(), length, 9, 0, 250);
+    // bzip2 does not modify the source but takes a non-const pointer
+    int err = BZ2_bzBuffToBuffCompress(data.data(), &compressedLen, const_cast<char*>(uncompressedData), length, 9, 0,
+                                       250);
     if(err != BZ_OK)
     {
         LOG.write("FATAL ERROR: BZ2_bzBuffToBuffCompress failed with error: %d\n") % err;
         return false;
     }
     data.resize(compressedLen);
+    return true;
+}
+
+struct StreamingDecompressor::Stream
+{
+    bz_stream bz;
+    boost::nowide::ofstream file;
+};
+
+StreamingDecompressor::StreamingDecompressor()
+    : uncompressedLength_(0), numCompressedBytes_(0), numUncompressedBytes_(0), checksum_(0), isStreamEnd_(false)
+{}
+
+StreamingDecompressor::~StreamingDecompressor()
+{
+    Abort();
+}
+
+bool StreamingDecompressor::Start(const boost::filesystem::path& filePath, unsigned uncompressedLength)
+{
+    Abort();
+    auto stream = std::make_unique<Stream>();
+    stream->file.open(filePath, std::ios::binary);
+    if(!stream->file)
+    {
+        LOG.write("FATAL ERROR: can't write to %s\n") % filePath;
+        return false;
+    }
+    stream->bz = bz_stream();
+    const int err = BZ2_bzDecompressInit(&stream->bz, 0, 0);
+    if(err != BZ_OK)
+    {
+        LOG.write("FATAL ERROR: BZ2_bzDecompressInit failed with code %d\n") % err;
+        return false;
+    }
+    stream_ = std::move(stream);
+    uncompressedLength_ = uncompressedLength;
+    numCompressedBytes_ = numUncompressedBytes_ = checksum_ = 0;
+    isStreamEnd_ = false;
+    buffer_.resize(STREAM_BUFFER_SIZE);
+    return true;
+}
+
+bool StreamingDecompressor::Add(const char* data, unsigned length)
+{
+    if(!stream_)
+        return false;
+    bz_stream& bz = stream_->bz;
+    // bzip2 does not modify the source but takes a non-const pointer
+    bz.next_in = const_cast<char*>(data);
+    bz.avail_in = length;
+    numCompressedBytes_ += length;
+    // Output might be pending even if all input was consumed
+    bool isOutputFull = false;
+    while(bz.avail_in > 0 || isOutputFull)
+    {
+        if(isStreamEnd_)
+        {
+            if(bz.avail_in == 0)
+                break;
+            LOG.write("FATAL ERROR: Got %u bytes after the end of the compressed data\n") % bz.avail_in;
+            Abort();
+            return false;
+        }
+        bz.next_out = buffer_.data();
+        bz.avail_out = static_cast<unsigned>(buffer_.size());
+        const int err = BZ2_bzDecompress(&bz);
+        if(err != BZ_OK && err != BZ_STREAM_END)
+        {
+            LOG.write("FATAL ERROR: BZ2_bzDecompress failed with code %d\n") % err;
+            Abort();
+            return false;
+        }
+        isStreamEnd_ = err == BZ_STREAM_END;
+        isOutputFull = bz.avail_out == 0;
+        const unsigned numDecompressed = static_cast<unsigned>(buffer_.size()) - bz.avail_out;
+        numUncompressedBytes_ += numDecompressed;
+        if(numUncompressedBytes_ > uncompressedLength_)
+        {
+            LOG.write("FATAL ERROR: Length mismatch after decompressing. Expected: %u, got at least %u\n")
+              % uncompressedLength_ % numUncompressedBytes_;
+            Abort();
+            return false;
+        }
+        // The checksum is a plain sum so it can be calculated piecewise
+        checksum_ += CalcChecksumOfBuffer(buffer_.data(), numDecompressed);
+        if(!stream_->file.write(buffer_.data(), numDecompressed))
+        {
+            LOG.write("FATAL ERROR: Writing the decompressed data failed\n");
+            Abort();
+            return false;
+        }
+    }
+    return true;
+}
 
+bool StreamingDecompressor::Finish(unsigned* checksum)
+{
+    if(!stream_)
+        return false;
+    const bool isComplete = isStreamEnd_ && numUncompressedBytes_ == uncompressedLength_;
+    if(!isComplete)
+    {
+        LOG.write("FATAL ERROR: Length mismatch after decompressing. Expected: %u, got %u\n") % uncompressedLength_
+          % numUncompressedBytes_;
+    }
+    stream_->file.close();
+    const bool isWritten = !stream_->file.fail();
+    Abort();
+    if(!isComplete || !isWritten)
+        return false;
     if(checksum)
-        *checksum = CalcChecksumOfBuffer(uncompressedData.get(), length);
+        *checksum = checksum_;
     return true;
 }
+
+void StreamingDecompressor::Abort()
+{
+    if(!stream_)
+        return;
+    BZ2_bzDecompressEnd(&stream_->bz);
+    stream_.reset();
+}
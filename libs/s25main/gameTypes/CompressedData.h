@@ -18,6 +18,7 @@
 #pragma once
 
 #include <boost/filesystem/path.hpp>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -32,9 +33,40 @@ struct CompressedData
     }
     bool DecompressToFile(const boost::filesystem::path& filePath, unsigned* checksum = nullptr);
     bool CompressFromFile(const boost::filesystem::path& filePath, unsigned* checksum = nullptr);
+    bool DecompressToBuffer(std::vector<char>& uncompressedData);
+    bool CompressFromBuffer(const char* uncompressedData, unsigned uncompressedLength);
 
     /// Uncompressed length
     unsigned length;
     /// Actual data
     std::vector<char> data;
 };
+
+/// Decompresses the data of a CompressedData piece by piece (e.g. while it is received) and writes it to a file.
+/// The checksum is calculated on the way, so there is nothing left to do when the last piece arrived
+class StreamingDecompressor
+{
+public:
+    StreamingDecompressor();
+    ~StreamingDecompressor();
+
+    /// Create the file and prepare for data with the given uncompressed length
+    bool Start(const boost::filesystem::path& filePath, unsigned uncompressedLength);
+    /// Decompress the next piece. On error the decompression is aborted
+    bool Add(const char* data, unsigned length);
+    /// Check that all data was received and close the file. Optionally return the checksum of the uncompressed data
+    bool Finish(unsigned* checksum = nullptr);
+    /// Stop decompressing, leaving an incomplete file
+    void Abort();
+    bool IsActive() const { return stream_ != nullptr; }
+    /// Number of compressed bytes added so far
+    unsigned GetNumCompressedBytes() const { return numCompressedBytes_; }
+
+private:
+    struct Stream;
+    std::unique_ptr<Stream> stream_;
+    unsigned uncompressedLength_, numCompressedBytes_, numUncompressedBytes_;
+    unsigned checksum_;
+    bool isStreamEnd_;
+    std::vector<char> buffer_;
+};
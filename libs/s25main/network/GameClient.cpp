@@ -18,6 +18,7 @@
 #include "GameClient.h"
 #include "CreateServerInfo.h"
 #include "EventManager.h"
+#include "GFProfiler.h"
 #include "Game.h"
 #include "GameEvent.h"
 #include "GameLobby.h"
@@ -33,6 +34,7 @@
 #include "Savegame.h"
 #include "SerializedGameData.h"
 #include "Settings.h"
+#include "TraceRecorder.h"
 #include "addons/const_addons.h"
 #include "ai/AIPlayer.h"
 #include "drivers/VideoDriverWrapper.h"
@@ -66,6 +68,20 @@
 #include <helpers/chronoIO.h>
 #include <memory>
 
+namespace {
+/// Max. time spent on skipping GFs in a replay before the GUI and network are polled again
+constexpr std::chrono::milliseconds SKIP_TIME_SLICE(100);
+
+/// Finish the file written while receiving the data or write it now if that failed
+bool FinishDecompression(StreamingDecompressor& decompressor, CompressedData& data, const bfs::path& filePath,
+                         unsigned& checksum)
+{
+    if(decompressor.IsActive() && decompressor.Finish(&checksum))
+        return true;
+    return data.DecompressToFile(filePath, &checksum);
+}
+} // namespace
+
 void GameClient::ClientConfig::Clear()
 {
     server.clear();
@@ -75,7 +91,9 @@ void GameClient::ClientConfig::Clear()
     isHost = false;
 }
 
-GameClient::GameClient() : skiptogf(0), mainPlayer(0), state(CS_STOPPED), ci(nullptr), replayMode(false) {}
+GameClient::GameClient()
+    : skiptogf(0), mainPlayer(0), state(CS_STOPPED), worldLoadPending_(false), ci(nullptr), replayMode(false)
+{}
 
 GameClient::~GameClient()
 {
@@ -174,7 +192,18 @@ void GameClient::Run()
         }
     }
 
-    if(state == CS_LOADED)
+    if(state == CS_LOADING && worldLoadPending_ && previousGame_.expired())
+    {
+        worldLoadPending_ = false;
+        try
+        {
+            LoadWorld(replayinfo->replay.random_init);
+        } catch(SerializedGameData::Error& error)
+        {
+            LOG.write(_("Error when loading game from replay: %s\n")) % error.what();
+            OnError(CE_INVALID_MAP);
+        }
+    } else if(state == CS_LOADED)
     {
         // All players ready?
         if(nwfInfo->isReady())
@@ -207,6 +236,8 @@ void GameClient::Stop()
     framesinfo.Clear();
     clientconfig.Clear();
     mapinfo.Clear();
+    mapDecompressor.Abort();
+    luaDecompressor.Abort();
 
     if(replayinfo)
     {
@@ -272,8 +303,8 @@ void GameClient::StartGame(const unsigned random_init)
         return;
     }
 
-    // If we have a savegame, start at its first GF, else at 0
-    unsigned startGF = (mapinfo.type == MAPTYPE_SAVEGAME) ? mapinfo.savegame->start_gf : 0;
+    // If we have a savegame (or keyframe), start at its first GF, else at 0
+    unsigned startGF = mapinfo.savegame ? mapinfo.savegame->start_gf : 0;
     // Create the game
     game =
       std::make_shared<Game>(gameLobby->getSettings(), startGF,
@@ -297,35 +328,28 @@ void GameClient::StartGame(const unsigned random_init)
     // Get standard settings before they get overwritten
     GetPlayer(GetPlayerId()).FillVisualSettings(default_settings);
 
+    // Objects of both games can't exist at the same time
+    if(!previousGame_.expired())
+        worldLoadPending_ = true;
+    else
+        LoadWorld(random_init);
+}
+
+void GameClient::LoadWorld(const unsigned random_init)
+{
+    RTTR_TRACE_SCOPE("GameClient::LoadWorld");
+    RTTR_Assert(state == CS_LOADING);
     GameWorld& gameWorld = game->world_;
     if(mapinfo.savegame)
         mapinfo.savegame->sgd.ReadSnapshot(game, *this);
     else
     {
         RTTR_Assert(mapinfo.type != MAPTYPE_SAVEGAME);
-        /// Startbündnisse setzen
-        for(unsigned i = 0; i < gameWorld.GetNumPlayers(); ++i)
-            gameWorld.GetPlayer(i).MakeStartPacts();
-
         if(!gameWorld.LoadMap(game, *this, mapinfo.filepath, mapinfo.luaFilepath))
         {
             OnError(CE_INVALID_MAP);
             return;
         }
-
-        /// Evtl. Goldvorkommen ändern
-        Resource::Type target; // löschen
-        switch(game->ggs_.getSelection(AddonId::CHANGE_GOLD_DEPOSITS))
-        {
-            case 0:
-            default: target = Resource::Gold; break;
-            case 1: target = Resource::Nothing; break;
-            case 2: target = Resource::Iron; break;
-            case 3: target = Resource::Coal; break;
-            case 4: target = Resource::Granite; break;
-        }
-        gameWorld.ConvertMineResourceTypes(Resource::Gold, target);
-        gameWorld.PlaceAndFixWater();
     }
     gameWorld.InitAfterLoad();
 
@@ -355,13 +379,18 @@ void GameClient::GameLoaded()
         // Notify server that we are ready
         if(IsHost())
         {
+            std::vector<unsigned> aiPlayerIds;
             for(unsigned id = 0; id < GetNumPlayers(); id++)
             {
                 if(GetPlayer(id).ps == PS_AI)
-                {
-                    game->AddAIPlayer(CreateAIPlayer(id, GetPlayer(id).aiInfo));
-                    SendNothingNC(id);
-                }
+                    aiPlayerIds.push_back(id);
+            }
+            // Initialize all AIs at once as this takes a while on big maps
+            std::vector<std::unique_ptr<AIPlayer>> ais = AIFactory::Create(aiPlayerIds, game->world_);
+            for(unsigned i = 0; i < ais.size(); i++)
+            {
+                game->AddAIPlayer(std::move(ais[i]));
+                SendNothingNC(aiPlayerIds[i]);
             }
         }
         SendNothingNC();
@@ -372,6 +401,7 @@ void GameClient::ExitGame()
 {
     RTTR_Assert(state == CS_GAME || state == CS_LOADED || state == CS_LOADING);
     game.reset();
+    worldLoadPending_ = false;
     nwfInfo.reset();
     // Clear remaining commands
     gameCommands_.clear();
@@ -914,6 +944,12 @@ bool GameClient::OnGameMessage(const GameMessage_Map_Info& msg)
     mapinfo.luaData.length = msg.luaLen;
     mapinfo.mapData.data.resize(msg.mapCompressedLen);
     mapinfo.luaData.data.resize(msg.luaCompressedLen);
+    // Decompress while receiving. If this fails everything is decompressed after it was received
+    mapDecompressor.Start(mapinfo.filepath, msg.mapLen);
+    if(!mapinfo.luaFilepath.empty())
+        luaDecompressor.Start(mapinfo.luaFilepath, msg.luaLen);
+    else
+        luaDecompressor.Abort();
     mainPlayer.sendMsgAsync(new GameMessage_MapRequest(false));
     return true;
 }
@@ -931,6 +967,12 @@ bool GameClient::OnGameMessage(const GameMessage_Map_Data& msg)
         std::copy(msg.data.begin(), msg.data.end(), mapinfo.mapData.data.begin() + msg.offset);
     else
         std::copy(msg.data.begin(), msg.data.end(), mapinfo.luaData.data.begin() + msg.offset);
+    StreamingDecompressor& decompressor = msg.isMapData ? mapDecompressor : luaDecompressor;
+    // The parts are sent in order. If not, fall back to decompressing all data at the end
+    if(decompressor.IsActive()
+       && (decompressor.GetNumCompressedBytes() != msg.offset
+           || !decompressor.Add(msg.data.data(), static_cast<unsigned>(msg.data.size()))))
+        decompressor.Abort();
 
     const unsigned curSize = msg.offset + msg.data.size();
     bool isCompleted;
@@ -941,12 +983,13 @@ bool GameClient::OnGameMessage(const GameMessage_Map_Data& msg)
 
     if(isCompleted)
     {
-        if(!mapinfo.mapData.DecompressToFile(mapinfo.filepath, &mapinfo.mapChecksum))
+        if(!FinishDecompression(mapDecompressor, mapinfo.mapData, mapinfo.filepath, mapinfo.mapChecksum))
         {
             OnError(CE_MAP_TRANSMISSION);
             return true;
         }
-        if(!mapinfo.luaFilepath.empty() && !mapinfo.luaData.DecompressToFile(mapinfo.luaFilepath, &mapinfo.luaChecksum))
+        if(!mapinfo.luaFilepath.empty()
+           && !FinishDecompression(luaDecompressor, mapinfo.luaData, mapinfo.luaFilepath, mapinfo.luaChecksum))
         {
             OnError(CE_MAP_TRANSMISSION);
             return true;
@@ -1204,6 +1247,7 @@ bool GameClient::OnGameMessage(const GameMessage_GetAsyncLog& /*msg*/)
 /// testet ob ein Netwerkframe abgelaufen ist und führt dann ggf die Befehle aus
 void GameClient::ExecuteGameFrame()
 {
+    RTTR_TRACE_SCOPE("GameClient::ExecuteGameFrame");
     if(framesinfo.isPaused)
         return; // Pause
 
@@ -1236,7 +1280,14 @@ void GameClient::ExecuteGameFrame()
             if(replayMode)
             {
                 // In replay mode we have all commands in the file -> Execute them
-                ExecuteGameFrame_Replay();
+                if(isSkipping)
+                {
+                    // Run as many GFs as possible in one time slice, GUI and sockets are only polled in between
+                    const FramesInfo::UsedClock::time_point sliceEnd = currentTime + SKIP_TIME_SLICE;
+                    FastForwardReplay(skiptogf,
+                                      [sliceEnd](unsigned, unsigned) { return FramesInfo::UsedClock::now() < sliceEnd; });
+                } else
+                    ExecuteGameFrame_Replay();
             } else
             {
                 RTTR_Assert(curGF <= nwfInfo->getNextNWF());
@@ -1262,11 +1313,16 @@ void GameClient::ExecuteGameFrame()
                     ExecuteNWF();
 
                     FramesInfo::milliseconds32_t oldGFLen = framesinfo.gf_length;
+                    const unsigned oldNWFLen = framesinfo.nwf_length;
                     nwfInfo->execute(framesinfo);
                     if(oldGFLen != framesinfo.gf_length)
                     {
                         LOG.write("Client: Speed changed at %1% from %2% to %3% (NWF: %4%)\n") % curGF % oldGFLen
                           % framesinfo.gf_length % framesinfo.nwf_length;
+                    } else if(oldNWFLen != framesinfo.nwf_length)
+                    {
+                        LOG.writeToFile("Client: NWF length changed at %1% from %2% to %3%\n") % curGF % oldNWFLen
+                          % framesinfo.nwf_length;
                     }
                 }
 
@@ -1276,7 +1332,13 @@ void GameClient::ExecuteGameFrame()
 
                 // GF-Ende im Replay aktualisieren
                 if(replayinfo && replayinfo->replay.IsRecording())
+                {
                     replayinfo->replay.UpdateLastGF(curGF);
+                    HandleReplayKeyframe();
+                    // Let the replay writer put everything up to the NWF on disk
+                    if(isNWF)
+                        replayinfo->replay.Flush();
+                }
             }
 
         } catch(LuaExecutionError& e)
@@ -1290,7 +1352,12 @@ void GameClient::ExecuteGameFrame()
             Stop();
         }
         if(skiptogf == GetGFNumber())
+        {
             skiptogf = 0;
+            // Replays stay at the target GF
+            if(replayMode)
+                SetPause(true);
+        }
     }
     framesinfo.frameTime = std::chrono::duration_cast<FramesInfo::milliseconds32_t>(currentTime - framesinfo.lastTime);
     // Check remaining time until next GF
@@ -1316,6 +1383,21 @@ void GameClient::ExecuteGameFrame()
     RTTR_Assert(framesinfo.frameTime < framesinfo.gf_length);
 }
 
+unsigned GameClient::FastForwardReplay(const unsigned targetGF, const FastForwardCallback& callback)
+{
+    RTTR_Assert(replayMode && state == CS_GAME);
+    const unsigned startGF = GetGFNumber();
+    skiptogf = targetGF;
+    // skiptogf gets changed by ExecuteGameFrame_Replay on asyncs and at the end of the replay
+    while(skiptogf > GetGFNumber())
+    {
+        ExecuteGameFrame_Replay();
+        if(callback && !callback(GetGFNumber(), targetGF))
+            break;
+    }
+    return GetGFNumber() - startGF;
+}
+
 void GameClient::HandleAutosave()
 {
     // If inactive or during replay -> no autosave
@@ -1335,12 +1417,36 @@ void GameClient::HandleAutosave()
     }
 }
 
+void GameClient::HandleReplayKeyframe()
+{
+    const unsigned interval = SETTINGS.interface.replay_keyframe_interval;
+    // The keyframe holds the state at the start of the next GF, i.e. before its commands are executed
+    if(!interval || GetGFNumber() % interval != 0)
+        return;
+
+    try
+    {
+        SerializedGameData sgd;
+        sgd.MakeSnapshot(game);
+        replayinfo->replay.AddKeyframe(GetGFNumber(), RANDOM.GetCurrentState(), sgd);
+    } catch(const std::exception& e)
+    {
+        LOG.write(_("Error creating replay keyframe: %1%\n")) % e.what();
+    }
+}
+
 /// Führt notwendige Dinge für nächsten GF aus
 void GameClient::NextGF(bool wasNWF)
 {
+    RTTR_TRACE_SCOPE("GameClient::NextGF");
+    GFPROFILER.StartGF(GetGFNumber());
     for(AIPlayer& ai : game->aiPlayers_)
+    {
+        GFProfiler::ScopedTimer timer(GFProfiler::GetAISlot(ai.GetPlayerId()));
         ai.RunGF(GetGFNumber(), wasNWF);
+    }
     game->RunGF();
+    GFPROFILER.EndGF();
 }
 
 void GameClient::ExecuteAllGCs(uint8_t playerId, const PlayerGameCommands& gcs)
@@ -1375,7 +1481,20 @@ void GameClient::OnGameStart()
     } else if(state == CS_GAME && !game->IsStarted())
     {
         framesinfo.isPaused = replayMode;
-        game->Start(!!mapinfo.savegame);
+        if(replayinfo && replayinfo->keyframeRngState)
+        {
+            // Continue exactly where the keyframe was taken
+            game->Resume();
+            RANDOM.ResetState(*replayinfo->keyframeRngState);
+            replayinfo->keyframeRngState.reset();
+            if(replayinfo->seekTargetGF > GetGFNumber())
+            {
+                skiptogf = replayinfo->seekTargetGF;
+                framesinfo.isPaused = false;
+            }
+            replayinfo->seekTargetGF = 0;
+        } else
+            game->Start(!!mapinfo.savegame);
     }
 }
 
@@ -1412,10 +1531,7 @@ bool GameClient::StartReplay(const boost::filesystem::path& path)
     }
     replayinfo->filename = replayinfo->replay.GetFile().getFilePath().filename();
 
-    gameLobby = std::make_shared<GameLobby>(true, true, replayinfo->replay.GetNumPlayers());
-
-    for(unsigned i = 0; i < replayinfo->replay.GetNumPlayers(); ++i)
-        gameLobby->getPlayer(i) = JoinPlayerInfo(replayinfo->replay.GetPlayer(i));
+    CreateReplayLobby();
 
     bool playerFound = false;
     // Find a player to spectate from
@@ -1442,9 +1558,6 @@ bool GameClient::StartReplay(const boost::filesystem::path& path)
         }
     }
 
-    // GGS-Daten
-    gameLobby->getSettings() = replayinfo->replay.ggs;
-
     switch(mapinfo.type)
     {
         default: break;
@@ -1493,6 +1606,59 @@ bool GameClient::StartReplay(const boost::filesystem::path& path)
     return true;
 }
 
+void GameClient::CreateReplayLobby()
+{
+    gameLobby = std::make_shared<GameLobby>(true, true, replayinfo->replay.GetNumPlayers());
+
+    for(unsigned i = 0; i < replayinfo->replay.GetNumPlayers(); ++i)
+        gameLobby->getPlayer(i) = JoinPlayerInfo(replayinfo->replay.GetPlayer(i));
+
+    // GGS-Daten
+    gameLobby->getSettings() = replayinfo->replay.ggs;
+}
+
+bool GameClient::SeekReplay(unsigned gf)
+{
+    RTTR_Assert(replayMode && state == CS_GAME);
+    const unsigned curGF = GetGFNumber();
+    const ReplayKeyframe* keyframe = replayinfo->replay.FindKeyframe(gf);
+    // Only useful when going back or when there is a keyframe between the current and the target GF
+    if(!keyframe || (gf >= curGF && keyframe->gf <= curGF))
+        return false;
+
+    auto keyframeSave = std::make_unique<Savegame>();
+    UsedPRNG rngState;
+    if(!replayinfo->replay.ReadKeyframe(*keyframe, rngState, keyframeSave->sgd))
+    {
+        LOG.write(_("Could not load replay keyframe at GF %1%: %2%\n")) % keyframe->gf
+          % replayinfo->replay.GetLastErrorMsg();
+        return false;
+    }
+    keyframeSave->start_gf = keyframe->gf;
+    LOG.write("Jumping from GF %1% to keyframe at GF %2%\n") % curGF % keyframe->gf;
+
+    // The old game stays alive till the GUI switched to the loading screen
+    previousGame_ = game;
+    ExitGame();
+    state = CS_STOPPED;
+    skiptogf = 0;
+
+    mapinfo.savegame = std::move(keyframeSave);
+    replayinfo->keyframeRngState = rngState;
+    replayinfo->seekTargetGF = gf;
+    replayinfo->end = false;
+    replayinfo->replay.ReadGF(&replayinfo->next_gf);
+
+    // Keep the player and speed selected by the user
+    const unsigned char playerId = mainPlayer.playerId;
+    const auto gfLength = framesinfo.gf_length;
+    CreateReplayLobby();
+    mainPlayer.playerId = playerId;
+    StartGame(replayinfo->replay.random_init);
+    framesinfo.gf_length = framesinfo.gfLengthReq = gfLength;
+    return true;
+}
+
 unsigned GameClient::GetGlobalAnimation(const unsigned short max, const unsigned char factor_numerator,
                                         const unsigned char factor_denumerator, const unsigned offset)
 {
@@ -1549,6 +1715,9 @@ void GameClient::ServerLost()
  */
 void GameClient::SkipGF(unsigned gf, GameWorldView& gwv)
 {
+    if(replayMode && SeekReplay(gf))
+        return;
+
     if(gf <= GetGFNumber())
         return;
 
@@ -1565,26 +1734,27 @@ void GameClient::SkipGF(unsigned gf, GameWorldView& gwv)
     SetPause(false);
     skiptogf = gf;
 
-    // GFs überspringen
-    for(unsigned i = GetGFNumber(); i < skiptogf; ++i)
+    // GFs überspringen. Each call runs a time slice, the progress is drawn in between
+    while(state == CS_GAME && skiptogf > GetGFNumber())
     {
-        if(i % 1000 == 0)
-        {
-            RoadBuildState road;
-            road.mode = RM_DISABLED;
+        ExecuteGameFrame();
+        if(state != CS_GAME || !skiptogf)
+            break;
 
-            // spiel aktualisieren
-            gwv.Draw(road, MapPoint::Invalid(), false);
+        RoadBuildState road;
+        road.mode = RM_DISABLED;
 
-            // text oben noch hinschreiben
-            boost::format nwfString(_("current GF: %u - still fast forwarding: %d GFs left (%d %%)"));
-            nwfString % GetGFNumber() % (gf - i) % (i * 100 / gf);
-            LargeFont->Draw(DrawPoint(VIDEODRIVER.GetRenderSize() / 2u), nwfString.str(), FontStyle::CENTER,
-                            COLOR_YELLOW);
+        // spiel aktualisieren
+        gwv.Draw(road, MapPoint::Invalid(), false);
 
-            VIDEODRIVER.SwapBuffers();
-        }
-        ExecuteGameFrame();
+        // text oben noch hinschreiben
+        const unsigned curGF = GetGFNumber();
+        boost::format nwfString(_("current GF: %u - still fast forwarding: %d GFs left (%d %%)"));
+        nwfString % curGF % (gf - curGF) % (static_cast<uint64_t>(curGF) * 100 / gf);
+        LargeFont->Draw(DrawPoint(VIDEODRIVER.GetRenderSize() / 2u), nwfString.str(), FontStyle::CENTER,
+                        COLOR_YELLOW);
+
+        VIDEODRIVER.SwapBuffers();
     }
 
     // Spiel pausieren & text ausgabe wie lang das jetzt gedauert hat
@@ -25,12 +25,14 @@
 #include "NetworkPlayer.h"
 #include "factories/GameCommandFactory.h"
 #include "gameTypes/ChatDestination.h"
+#include "gameTypes/CompressedData.h"
 #include "gameTypes/MapInfo.h"
 #include "gameTypes/Nation.h"
 #include "gameTypes/ServerType.h"
 #include "gameTypes/TeamTypes.h"
 #include "gameTypes/VisualSettings.h"
 #include "s25util/Singleton.h"
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -107,6 +109,8 @@ public:
     void StartGame(unsigned random_init);
     /// Called when the game is loaded
     void GameLoaded();
+    /// True if loading the world is delayed till the previous game is released (seeking in replays)
+    bool IsWorldLoadPending() const { return worldLoadPending_; }
 
     /// Beendet das Spiel, zerstört die Spielstrukturen
     void ExitGame();
@@ -181,6 +185,8 @@ public:
     NetworkPlayer& GetMainPlayer() { return mainPlayer; }
 
 private:
+    /// Load the world of the game created in StartGame
+    void LoadWorld(unsigned random_init);
     /// Create an AI player for the current world
     std::unique_ptr<AIPlayer> CreateAIPlayer(unsigned playerId, const AI::Info& aiInfo);
 
@@ -194,6 +200,11 @@ private:
     /// Versucht einen neuen GameFrame auszuführen, falls die Zeit dafür gekommen ist
     void ExecuteGameFrame();
     void ExecuteGameFrame_Replay();
+    /// Called while fast forwarding with the current and the target GF. Return false to stop
+    using FastForwardCallback = std::function<bool(unsigned curGF, unsigned targetGF)>;
+    /// Execute the GFs of the replay till the target GF without any drawing or polling in between.
+    /// Stops early on asyncs, at the end of the replay or when the callback returns false. Returns the number of GFs run
+    unsigned FastForwardReplay(unsigned targetGF, const FastForwardCallback& callback);
     void ExecuteNWF();
     /// Filtert aus einem Network-Command-Paket alle Commands aus und führt sie aus, falls ein Spielerwechsel-Command
     /// dabei ist, füllt er die übergebenen IDs entsprechend aus
@@ -259,6 +270,13 @@ private:
     /// Schreibt den Header der Replaydatei
     void StartReplayRecording(unsigned random_init);
     void WritePlayerInfo(SavedFile& file);
+    /// Store a keyframe in the replay if it is time for one
+    void HandleReplayKeyframe();
+    /// Create the lobby from the players and settings of the replay
+    void CreateReplayLobby();
+    /// Restart the replay from the last keyframe before the given GF and skip to it.
+    /// Return false if there is no suitable keyframe
+    bool SeekReplay(unsigned gf);
 
 public:
     /// Virtuelle Werte der Einstellungsfenster, die aber noch nicht wirksam sind, nur um die Verzögerungen zu
@@ -279,6 +297,9 @@ private:
     std::shared_ptr<NWFInfo> nwfInfo;
     /// Game lobby (valid during CONFIG state)
     std::shared_ptr<GameLobby> gameLobby;
+    /// Game replaced while seeking in a replay. The new world is loaded when it is released by the GUI
+    std::weak_ptr<Game> previousGame_;
+    bool worldLoadPending_;
 
     class ClientConfig
     {
@@ -295,6 +316,8 @@ private:
     } clientconfig;
 
     MapInfo mapinfo;
+    /// Write the map and lua files while they are received
+    StreamingDecompressor mapDecompressor, luaDecompressor;
 
     FramesInfoClient framesinfo;
 
@@ -19,11 +19,13 @@
 #include "GameMessage_GameCommand.h"
 #include "NWFInfo.h"
 #include "ReplayInfo.h"
+#include "TraceRecorder.h"
 #include "ai/AIPlayer.h"
 #include "network/GameClient.h"
 
 void GameClient::ExecuteNWF()
 {
+    RTTR_TRACE_SCOPE("GameClient::ExecuteNWF");
     // Geschickte Network Commands der Spieler ausführen und ggf. im Replay aufzeichnen
 
     AsyncChecksum checksum = AsyncChecksum::create(*game);
@@ -81,6 +81,10 @@ void GameClient::ExecuteGameFrame_Replay()
 
                 replayinfo->async++;
             }
+        } else if(rc == ReplayCommand::Keyframe)
+        {
+            // Only needed for seeking
+            replayinfo->replay.SkipKeyframe();
         }
         // Read GF of next command
         replayinfo->replay.ReadGF(&replayinfo->next_gf);
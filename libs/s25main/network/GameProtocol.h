@@ -165,6 +165,7 @@ const unsigned PING_TIMEOUT = 5 * 60;
 /// Maximum time the players get for loading the map
 const unsigned LOAD_TIMEOUT = 10 * 60;
 
-/// Größe eines Map-Paketes
-/// ACHTUNG: IPV4 garantiert nur maximal 576!!
-const unsigned MAP_PART_SIZE = 512;
+/// Size of a part of the map or lua data sent at once.
+/// Bigger parts need fewer messages but the parts of all players sent in one server run should not fill the socket
+/// buffers (see GameServer::Run)
+const unsigned MAP_PART_SIZE = 4096;
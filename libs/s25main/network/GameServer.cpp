@@ -22,6 +22,7 @@
 #include "GameServerPlayer.h"
 #include "GlobalGameSettings.h"
 #include "RTTR_Version.h"
+#include "Replay.h"
 #include "RttrConfig.h"
 #include "Savegame.h"
 #include "Settings.h"
@@ -30,6 +31,7 @@
 #include "helpers/containerUtils.h"
 #include "network/CreateServerInfo.h"
 #include "network/GameMessages.h"
+#include "network/SpectatorRelay.h"
 #include "ogl/glArchivItem_Map.h"
 #include "gameTypes/LanGameInfo.h"
 #include "gameData/GameConsts.h"
@@ -43,11 +45,22 @@
 #include <boost/filesystem.hpp>
 #include <boost/nowide/convert.hpp>
 #include <boost/nowide/fstream.hpp>
+#include <algorithm>
 #include <cmath>
 #include <helpers/chronoIO.h>
 #include <iomanip>
 #include <mygettext/mygettext.h>
 
+namespace {
+/// Maximum number of messages sent to a player per run. They are combined into as few packets as possible
+constexpr int MAX_SEND_MSGS_PER_RUN = 10;
+/// Ids in the socket poller besides the player ids
+constexpr unsigned SERVER_SOCKET_ID = 0xFFFFFFFF;
+constexpr unsigned SPECTATOR_RELAY_ID = 0xFFFFFFFE;
+/// Maximum time spectators get to receive the end of the stream after the game is over
+constexpr std::chrono::seconds SPECTATOR_FLUSH_TIMEOUT(30);
+} // namespace
+
 inline std::ostream& operator<<(std::ostream& os, const AsyncChecksum& checksum)
 {
     return os << "RandCS = " << checksum.randChecksum << ",\tobjects/ID = " << checksum.objCt << "/" << checksum.objIdCt
@@ -76,6 +89,7 @@ void GameServer::ServerConfig::Clear()
     password.clear();
     port = 0;
     ipv6 = false;
+    adaptiveNWF = false;
 }
 
 GameServer::CountDown::CountDown() : isActive(false), remainingSecs(0) {}
@@ -113,7 +127,9 @@ bool GameServer::CountDown::Update()
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-GameServer::GameServer() : skiptogf(0), state(SS_STOPPED), currentGF(0), lanAnnouncer(LAN_DISCOVERY_CFG) {}
+GameServer::GameServer()
+    : skiptogf(0), state(SS_STOPPED), currentGF(0), spectatorDelay(0), lanAnnouncer(LAN_DISCOVERY_CFG)
+{}
 
 ///////////////////////////////////////////////////////////////////////////////
 //
@@ -128,6 +144,8 @@ bool GameServer::Start(const CreateServerInfo& csi, const boost::filesystem::pat
                        const std::string& hostPw)
 {
     Stop();
+    // Spectators of the last game which did not receive everything yet are out of luck
+    DropSpectatorRelay();
 
     // Name, Password und Kartenname kopieren
     config.gamename = csi.gameName;
@@ -136,6 +154,7 @@ bool GameServer::Start(const CreateServerInfo& csi, const boost::filesystem::pat
     config.servertype = csi.type;
     config.port = csi.port;
     config.ipv6 = csi.ipv6;
+    config.adaptiveNWF = SETTINGS.server.adaptive_nwf;
     mapinfo.type = map_type;
     mapinfo.filepath = map_path;
 
@@ -217,6 +236,7 @@ bool GameServer::Start(const CreateServerInfo& csi, const boost::filesystem::pat
         LOG.writeLastError("Fehler");
         return false;
     }
+    socketPoller.Add(serversocket, SERVER_SOCKET_ID);
 
     if(config.servertype == ServerType::LAN)
         lanAnnouncer.Start();
@@ -283,7 +303,10 @@ void GameServer::LC_Created()
 void GameServer::Run()
 {
     if(state == SS_STOPPED)
+    {
+        RunFinishedSpectatorStream();
         return;
+    }
 
     // auf tote Clients prüfen
     ClientWatchDog();
@@ -312,12 +335,84 @@ void GameServer::Run()
     {
         // Ignore kicked players
         if(!player.socket.isValid())
+        {
+            socketPoller.Remove(player.playerId);
             continue;
-        player.sendMsgs(10);
+        }
+        // If not everything could be sent before, wait till the socket is writable again (see FillPlayerQueues)
+        if(!socketPoller.HasWriteInterest(player.playerId))
+            player.sendMsgs(MAX_SEND_MSGS_PER_RUN);
+        socketPoller.SetWriteInterest(player.playerId, !player.sendQueue.empty());
     }
     helpers::remove_if(networkPlayers, [](const auto& player) { return !player.socket.isValid(); });
 
     lanAnnouncer.Run();
+    if(spectatorRelay)
+        spectatorRelay->Run();
+
+    // Nobody left to play the game
+    if(state != SS_CONFIG && networkPlayers.empty())
+    {
+        LOG.write(_("SERVER: All players left the game\n"));
+        Stop();
+    }
+}
+
+void GameServer::RunFinishedSpectatorStream()
+{
+    if(!spectatorRelay)
+        return;
+    spectatorRelay->Run();
+    if(spectatorRelay->IsFlushed())
+        DropSpectatorRelay();
+    else if(SteadyClock::now() >= spectatorFlushDeadline)
+    {
+        LOG.write("SERVER: Spectators did not receive the end of the game in time\n");
+        DropSpectatorRelay();
+    }
+}
+
+void GameServer::DropSpectatorRelay()
+{
+    if(!spectatorRelay)
+        return;
+    socketPoller.Remove(SPECTATOR_RELAY_ID);
+    spectatorRelay.reset();
+}
+
+bool GameServer::StartSpectatorRelay(uint16_t port, std::chrono::milliseconds delay)
+{
+    RTTR_Assert(state == SS_CONFIG);
+    auto relay = std::make_unique<SpectatorRelay>();
+    if(!relay->Start(port, config.ipv6))
+        return false;
+    spectatorRelay = std::move(relay);
+    socketPoller.AddPoller(spectatorRelay->GetPoller(), SPECTATOR_RELAY_ID);
+    spectatorDelay = delay;
+    LOG.write("SERVER: Spectators can connect to port %1%\n") % port;
+    return true;
+}
+
+std::chrono::milliseconds GameServer::GetMaxWaitTime() const
+{
+    using std::chrono::milliseconds;
+    // Resolution for pings, timeouts, the countdown etc.
+    constexpr milliseconds maxWaitTime(100);
+    for(const GameServerPlayer& player : networkPlayers)
+    {
+        // Not everything was sent yet. Players waiting for a writable socket are handled by the next regular run
+        if(!player.sendQueue.empty() && !socketPoller.HasWriteInterest(player.playerId))
+            return milliseconds::zero();
+    }
+    if(state != SS_GAME || framesinfo.isPaused)
+        return maxWaitTime;
+    if(skiptogf > currentGF)
+        return milliseconds::zero();
+    const auto passedTime =
+      std::chrono::duration_cast<milliseconds>(FramesInfo::UsedClock::now() - framesinfo.lastTime);
+    if(passedTime >= framesinfo.gf_length)
+        return milliseconds::zero();
+    return std::min(maxWaitTime, std::chrono::duration_cast<milliseconds>(framesinfo.gf_length - passedTime));
 }
 
 void GameServer::RunStateConfig()
@@ -403,6 +498,7 @@ void GameServer::Stop()
 
     // player verabschieden
     playerInfos.clear();
+    socketPoller.Clear();
     networkPlayers.clear();
 
     // aufräumen
@@ -420,6 +516,14 @@ void GameServer::Stop()
     asyncLogs.clear();
 
     lanAnnouncer.Stop();
+    if(spectatorRelay && spectatorRelay->IsStreaming())
+    {
+        // Keep the relay till the spectators received the end of the game (see RunFinishedSpectatorStream)
+        spectatorRelay->EndStream();
+        socketPoller.AddPoller(spectatorRelay->GetPoller(), SPECTATOR_RELAY_ID);
+        spectatorFlushDeadline = SteadyClock::now() + SPECTATOR_FLUSH_TIMEOUT;
+    } else
+        spectatorRelay.reset();
 
     if(LOBBYCLIENT.IsLoggedIn()) // steht die Lobbyverbindung noch?
         LOBBYCLIENT.DeleteServer();
@@ -436,6 +540,8 @@ void GameServer::Stop()
 bool GameServer::StartGame()
 {
     lanAnnouncer.Stop();
+    // No more players can join
+    socketPoller.Remove(SERVER_SOCKET_ID);
 
     // Bei Savegames wird der Startwert von den Clients aus der Datei gelesen!
     unsigned random_init;
@@ -450,26 +556,18 @@ bool GameServer::StartGame()
     SendToAll(GameMessage_Server_Start(random_init, nwfInfo.getNextNWF(), nwfInfo.getCmdDelay()));
     LOG.writeToFile("SERVER >>> BROADCAST: NMS_SERVER_START(%d)\n") % random_init;
 
-    // Höchsten Ping ermitteln
-    unsigned highest_ping = 0;
-    for(const JoinPlayerInfo& player : playerInfos)
-    {
-        if(player.ps == PS_OCCUPIED)
-        {
-            if(player.ping > highest_ping)
-                highest_ping = player.ping;
-        }
-    }
-
     framesinfo.gfLengthReq = framesinfo.gf_length = FramesInfo::milliseconds32_t(SPEED_GF_LENGTHS[ggs_.speed]);
 
     // NetworkFrame-Länge bestimmen, je schlechter (also höher) die Pings, desto länger auch die Framelänge
-    framesinfo.nwf_length = CalcNWFLenght(FramesInfo::milliseconds32_t(highest_ping));
+    framesinfo.nwf_length = CalcNWFLenght(FramesInfo::milliseconds32_t(GetHighestPing()));
 
     LOG.write("SERVER: Using gameframe length of %d\n") % framesinfo.gf_length;
     LOG.write("SERVER: Using networkframe length of %u GFs (%u)\n") % framesinfo.nwf_length
       % (framesinfo.nwf_length * framesinfo.gf_length);
 
+    if(spectatorRelay)
+        StartSpectatorStream(random_init);
+
     for(unsigned id = 0; id < playerInfos.size(); id++)
     {
         if(playerInfos[id].isUsed())
@@ -487,6 +585,31 @@ bool GameServer::StartGame()
     return true;
 }
 
+void GameServer::StartSpectatorStream(unsigned random_init)
+{
+    // Same header as written by the clients
+    Replay replay;
+    replay.random_init = random_init;
+    for(const JoinPlayerInfo& player : playerInfos)
+        replay.AddPlayer(player);
+    replay.ggs = ggs_;
+    // The server only has the header of a savegame but spectators need all of it
+    if(mapinfo.type == MAPTYPE_SAVEGAME)
+    {
+        mapinfo.savegame = std::make_unique<Savegame>();
+        if(!mapinfo.savegame->Load(mapinfo.filepath, SaveGameDataToLoad::All))
+            mapinfo.savegame.reset();
+    }
+    if((mapinfo.type == MAPTYPE_SAVEGAME && !mapinfo.savegame)
+       || !spectatorRelay->StartStream(replay, mapinfo, spectatorDelay))
+    {
+        LOG.write(_("SERVER: Could not start the stream for spectators\n"));
+        DropSpectatorRelay();
+    } else
+        LOG.write("SERVER: Relaying the game to spectators with a delay of %1%\n") % spectatorDelay;
+    mapinfo.savegame.reset();
+}
+
 unsigned GameServer::CalcNWFLenght(FramesInfo::milliseconds32_t minDuration) const
 {
     constexpr unsigned maxNumGF = 20;
@@ -498,6 +621,28 @@ unsigned GameServer::CalcNWFLenght(FramesInfo::milliseconds32_t minDuration) con
     return maxNumGF;
 }
 
+unsigned GameServer::GetHighestPing() const
+{
+    unsigned highestPing = 0;
+    for(const JoinPlayerInfo& player : playerInfos)
+    {
+        if(player.ps == PS_OCCUPIED)
+            highestPing = std::max(highestPing, player.ping);
+    }
+    return highestPing;
+}
+
+unsigned GameServer::CalcAdaptiveNWFLength() const
+{
+    // The pings are smoothed already
+    const unsigned requiredLength = CalcNWFLenght(FramesInfo::milliseconds32_t(GetHighestPing()));
+    // Grow at once to avoid lags but shrink slowly, so the length does not flip every NWF when the ping is close to a
+    // multiple of the GF length
+    if(requiredLength + 1 < framesinfo.nwf_length)
+        return framesinfo.nwf_length - 1;
+    return std::max(requiredLength, framesinfo.nwf_length);
+}
+
 void GameServer::SendNWFDone(const NWFServerInfo& info)
 {
     nwfInfo.addServerInfo(info);
@@ -524,7 +669,10 @@ void GameServer::KickPlayer(uint8_t playerId, KickReason cause, uint32_t param)
     JoinPlayerInfo& playerInfo = playerInfos[playerId];
     GameServerPlayer* player = GetNetworkPlayer(playerId);
     if(player)
+    {
+        socketPoller.Remove(playerId);
         player->closeConnection();
+    }
     // Non-existing or connecting player
     if(!playerInfo.isUsed())
         return;
@@ -547,28 +695,9 @@ void GameServer::KickPlayer(uint8_t playerId, KickReason cause, uint32_t param)
 
 ///////////////////////////////////////////////////////////////////////////////
 // testet, ob in der Verbindungswarteschlange Clients auf Verbindung warten
+// Socket errors are handled in FillPlayerQueues
 void GameServer::ClientWatchDog()
 {
-    SocketSet set;
-    set.Clear();
-
-    // sockets zum set hinzufügen
-    for(GameServerPlayer& player : networkPlayers)
-        set.Add(player.socket);
-
-    // auf fehler prüfen
-    if(set.Select(0, 2) > 0)
-    {
-        for(const GameServerPlayer& player : networkPlayers)
-        {
-            if(set.InSet(player.socket))
-            {
-                LOG.write(_("SERVER: Error on socket of player %1%, bye bye!\n")) % player.playerId;
-                KickPlayer(player.playerId, NP_CONNECTIONLOST, __LINE__);
-            }
-        }
-    }
-
     for(GameServerPlayer& player : networkPlayers)
     {
         if(player.hasTimedOut())
@@ -597,7 +726,6 @@ void GameServer::ExecuteGameFrame()
             if(CheckForLaggingPlayers())
             {
                 // Check for kicking every second
-                static FramesInfo::UsedClock::time_point lastLagKickTime;
                 if(currentTime - lastLagKickTime >= std::chrono::seconds(1))
                 {
                     lastLagKickTime = currentTime;
@@ -650,6 +778,16 @@ void GameServer::ExecuteNWF()
     // First save old values
     unsigned lastNWF = nwfInfo.getLastNWF();
     FramesInfo::milliseconds32_t oldGFLen = framesinfo.gf_length;
+    if(spectatorRelay)
+    {
+        // Same as recorded by the clients but without a checksum as the server does not run the game
+        for(const NWFPlayerInfo& player : nwfInfo.getPlayerInfos())
+        {
+            const PlayerGameCommands& cmds = player.commands.front();
+            if(!cmds.gcs.empty())
+                spectatorRelay->AddGameCommand(currentGF, player.id, PlayerGameCommands(AsyncChecksum(), cmds.gcs));
+        }
+    }
     nwfInfo.execute(framesinfo);
     if(oldGFLen != framesinfo.gf_length)
     {
@@ -666,6 +804,16 @@ void GameServer::ExecuteNWF()
         double newNWFLen =
           framesinfo.nwf_length * framesinfo.gf_length / duration_cast<MsDouble>(framesinfo.gfLengthReq);
         newInfo.nextNWF = lastNWF + std::max(1l, std::lround(newNWFLen));
+    } else if(config.adaptiveNWF)
+    {
+        // Applied by all clients when they reach lastNWF, which is deterministic as they all use the same server info
+        const unsigned newNWFLength = CalcAdaptiveNWFLength();
+        if(newNWFLength != framesinfo.nwf_length)
+        {
+            LOG.write(_("SERVER: At GF %1%: Networkframe length changes from %2% to %3% GFs at GF %4%\n")) % currentGF
+              % framesinfo.nwf_length % newNWFLength % lastNWF;
+        }
+        newInfo.nextNWF = lastNWF + newNWFLength;
     }
     SendNWFDone(newInfo);
 }
@@ -740,6 +888,7 @@ void GameServer::WaitForClients()
             if(playerInfos[playerId].ps == PS_FREE && !GetNetworkPlayer(playerId))
             {
                 networkPlayers.push_back(GameServerPlayer(playerId, socket));
+                socketPoller.Add(socket, playerId);
                 newPlayerId = playerId;
                 break;
             }
@@ -758,36 +907,33 @@ void GameServer::WaitForClients()
 // füllt die warteschlangen mit "paketen"
 void GameServer::FillPlayerQueues()
 {
-    SocketSet set;
-    bool msgReceived = false;
-
-    // erstmal auf Daten überprüfen
-    do
+    // Only sockets with pending data, free space for pending messages or errors are reported
+    for(const SocketPoller::Event& event : socketPoller.Wait(std::chrono::milliseconds::zero()))
     {
-        // sockets zum set hinzufügen
-        for(const GameServerPlayer& player : networkPlayers)
-            set.Add(player.socket);
-
-        msgReceived = false;
-
-        // ist eines der Sockets im Set lesbar?
-        if(set.Select(0, 0) > 0)
+        // Handled by WaitForClients and the spectator relay
+        if(event.id == SERVER_SOCKET_ID || event.id == SPECTATOR_RELAY_ID)
+            continue;
+        GameServerPlayer* player = GetNetworkPlayer(event.id);
+        // Ignore kicked players
+        if(!player || !player->socket.isValid())
+            continue;
+        if(event.error)
         {
-            for(GameServerPlayer& player : networkPlayers)
-            {
-                if(set.InSet(player.socket))
-                {
-                    // nachricht empfangen
-                    if(!player.receiveMsgs())
-                    {
-                        LOG.write(_("SERVER: Receiving Message for player %1% failed, kicking...\n")) % player.playerId;
-                        KickPlayer(player.playerId, NP_CONNECTIONLOST, __LINE__);
-                    } else
-                        msgReceived = true;
-                }
-            }
+            LOG.write(_("SERVER: Error on socket of player %1%, bye bye!\n")) % player->playerId;
+            KickPlayer(player->playerId, NP_CONNECTIONLOST, __LINE__);
+            continue;
+        }
+        // Receives everything available on the socket at once
+        if(event.readable && !player->receiveMsgs())
+        {
+            LOG.write(_("SERVER: Receiving Message for player %1% failed, kicking...\n")) % player->playerId;
+            KickPlayer(player->playerId, NP_CONNECTIONLOST, __LINE__);
+            continue;
         }
-    } while(msgReceived);
+        // Continue sending messages that did not fit before. New messages are sent after executing the received ones
+        if(event.writable)
+            player->sendMsgs(MAX_SEND_MSGS_PER_RUN);
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1090,9 +1236,9 @@ bool GameServer::OnGameMessage(const GameMessage_MapRequest& msg)
             curPos += chunkSize;
             remainingSize -= chunkSize;
         }
-        // estimate time. max 60 chunks/s (currently limited by framerate), assume 50 (~25kb/s)
-        auto numChunks = (mapinfo.mapData.data.size() + mapinfo.luaData.data.size()) / MAP_PART_SIZE;
-        player->setMapSending(std::chrono::seconds(numChunks / 50 + 1));
+        // Estimate the time conservatively assuming ~25kB/s. The parts for all players are sent interleaved
+        const auto numBytes = mapinfo.mapData.data.size() + mapinfo.luaData.data.size();
+        player->setMapSending(std::chrono::seconds(numBytes / (25 * 1024) + 1));
     }
     return true;
 }
@@ -1606,6 +1752,7 @@ void GameServer::SwapPlayer(const uint8_t player1, const uint8_t player2)
         newPlayer->playerId = player1;
     if(oldPlayer)
         oldPlayer->playerId = player2;
+    socketPoller.SwapIds(player1, player2);
     SendToAll(GameMessage_Player_Swap(player1, player2));
     const auto pSwap = std::make_pair(player1, player2);
     for(GameServerPlayer& player : networkPlayers)
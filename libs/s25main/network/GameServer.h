@@ -23,12 +23,14 @@
 #include "GlobalGameSettings.h"
 #include "JoinPlayerInfo.h"
 #include "NWFInfo.h"
+#include "SocketPoller.h"
 #include "gameTypes/MapInfo.h"
 #include "gameTypes/ServerType.h"
 #include "liblobby/LobbyInterface.h"
 #include "s25util/LANDiscoveryService.h"
 #include "s25util/Singleton.h"
 #include <chrono>
+#include <memory>
 #include <vector>
 
 struct CreateServerInfo;
@@ -37,6 +39,7 @@ class GameMessageWithPlayer;
 class GameMessage_GameCommand;
 class GameServerPlayer;
 struct AIServerPlayer;
+class SpectatorRelay;
 
 class GameServer :
     public Singleton<GameServer, SingletonPolicies::WithLongevity>,
@@ -62,10 +65,31 @@ public:
 
     void Stop();
 
+    bool IsRunning() const { return state != SS_STOPPED; }
+    /// True while the game is over but spectators did not receive the end of it yet. Run has to be called till then
+    bool IsFlushingSpectatorStream() const { return !IsRunning() && spectatorRelay != nullptr; }
+    /// Poller of all sockets the server handles (including the spectators), so one can wait till there is something to
+    /// do. Stays valid while the server exists
+    const SocketPoller& GetSocketPoller() const { return socketPoller; }
+    /// Return the maximum time Run can be delayed when no data is received (e.g. till the next GF)
+    std::chrono::milliseconds GetMaxWaitTime() const;
+    /// Relay the game to read-only spectators connecting to the given port. Only possible before the game starts.
+    /// Commands are sent to them after the given delay
+    bool StartSpectatorRelay(uint16_t port, std::chrono::milliseconds delay);
+
 private:
     bool StartGame();
+    /// Send the replay header to the spectators
+    void StartSpectatorStream(unsigned random_init);
+    /// Send the end of the stream to the spectators after the game is over and drop the relay when done
+    void RunFinishedSpectatorStream();
+    void DropSpectatorRelay();
 
     unsigned CalcNWFLenght(FramesInfo::milliseconds32_t minDuration) const;
+    /// Return the highest ping of all human players
+    unsigned GetHighestPing() const;
+    /// Calculate the length of the next NWF from the current pings
+    unsigned CalcAdaptiveNWFLength() const;
 
     GameServerPlayer* GetNetworkPlayer(unsigned playerId);
     /// Swap players ingame or during config
@@ -165,6 +189,8 @@ private:
         std::string hostPassword, password;
         unsigned short port;
         bool ipv6;
+        /// Adapt the NWF length to the current pings during the game
+        bool adaptiveNWF;
     } config;
 
     MapInfo mapinfo;
@@ -172,6 +198,9 @@ private:
     Socket serversocket;
     std::vector<JoinPlayerInfo> playerInfos;
     std::vector<GameServerPlayer> networkPlayers;
+    /// Sockets of the network players, identified by the player id, the server socket (while in the config state) and
+    /// the sockets of the spectator relay
+    SocketPoller socketPoller;
     NWFInfo nwfInfo;
     GlobalGameSettings ggs_;
 
@@ -198,6 +227,14 @@ private:
     std::vector<AsyncLog> asyncLogs;
     /// Time at which the loading started
     std::chrono::steady_clock::time_point loadStartTime;
+    /// Last time lagging players were checked for being kicked
+    FramesInfo::UsedClock::time_point lastLagKickTime;
+    /// Forwards the commands to spectators (if enabled)
+    std::unique_ptr<SpectatorRelay> spectatorRelay;
+    /// Time the commands are held back before they are sent to spectators
+    std::chrono::milliseconds spectatorDelay;
+    /// Time after the game ended at which spectators that did not receive everything are dropped
+    SteadyClock::time_point spectatorFlushDeadline;
 
     LANDiscoveryService lanAnnouncer;
     void RunStateLoading();
@@ -16,22 +16,126 @@
 // along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
 
 #include "PlayerGameCommands.h"
+#include "GameCommands.h"
 #include "s25util/Serializer.h"
+#include <stdexcept>
+#include <vector>
+
+namespace {
+enum Flags : uint8_t
+{
+    HAS_CHECKSUM = 1 << 0,
+    HAS_COMMANDS = 1 << 1
+};
+/// Set in the type of a command whose point is stored (delta coded) separately
+constexpr uint8_t DELTA_POINT_FLAG = 0x80;
+
+/// Store small negative values as small positive ones: 0, -1, 1, -2, ... -> 0, 1, 2, 3, ...
+void PushVarInt(Serializer& ser, int32_t value)
+{
+    ser.PushVarSize((static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31));
+}
+
+int32_t PopVarInt(Serializer& ser)
+{
+    const uint32_t value = ser.PopVarSize();
+    return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+}
+} // namespace
 
 void PlayerGameCommands::Serialize(Serializer& ser) const
 {
-    checksum.Serialize(ser);
+    const bool hasChecksum = checksum != AsyncChecksum();
+    ser.PushUnsignedChar((hasChecksum ? HAS_CHECKSUM : 0) | (gcs.empty() ? 0 : HAS_COMMANDS));
+    if(hasChecksum)
+    {
+        ser.PushVarSize(checksum.randChecksum);
+        ser.PushVarSize(checksum.objCt);
+        ser.PushVarSize(checksum.objIdCt);
+        ser.PushVarSize(checksum.eventCt);
+        ser.PushVarSize(checksum.evInstanceCt);
+    }
+    if(gcs.empty())
+        return;
 
-    ser.PushUnsignedInt(gcs.size());
+    ser.PushVarSize(gcs.size());
+    // The commands keep their own format but their points are delta coded and only the rest is copied
+    Serializer gcSer;
+    MapPoint lastPt(0, 0);
     for(const gc::GameCommandPtr& gc : gcs)
-        gc->Serialize(ser);
+    {
+        gcSer.Clear();
+        gc->Serialize(gcSer);
+        const uint8_t* data = gcSer.GetData();
+        const auto* coordsGC = dynamic_cast<const gc::Coords*>(gc.get());
+        unsigned headerSize = 1;
+        if(coordsGC)
+        {
+            const MapPoint pt = coordsGC->GetPos();
+            ser.PushUnsignedChar(data[0] | DELTA_POINT_FLAG);
+            PushVarInt(ser, pt.x - lastPt.x);
+            PushVarInt(ser, pt.y - lastPt.y);
+            lastPt = pt;
+            headerSize = gc::Coords::SERIALIZED_HEADER_SIZE;
+        } else
+            ser.PushUnsignedChar(data[0]);
+        ser.PushVarSize(gcSer.GetLength() - headerSize);
+        ser.PushRawData(data + headerSize, gcSer.GetLength() - headerSize);
+    }
 }
 
 void PlayerGameCommands::Deserialize(Serializer& ser)
 {
-    checksum.Deserialize(ser);
+    const uint8_t flags = ser.PopUnsignedChar();
+    if(flags & HAS_CHECKSUM)
+    {
+        checksum.randChecksum = ser.PopVarSize();
+        checksum.objCt = ser.PopVarSize();
+        checksum.objIdCt = ser.PopVarSize();
+        checksum.eventCt = ser.PopVarSize();
+        checksum.evInstanceCt = ser.PopVarSize();
+    } else
+        checksum = AsyncChecksum();
+    if(!(flags & HAS_COMMANDS))
+    {
+        gcs.clear();
+        return;
+    }
 
-    gcs.resize(ser.PopUnsignedInt());
+    gcs.resize(ser.PopVarSize());
+    MapPoint lastPt(0, 0);
+    std::vector<uint8_t> gcData;
     for(gc::GameCommandPtr& gc : gcs)
-        gc = gc::GameCommand::Deserialize(ser);
+    {
+        // Restore the regular format of the command and let it deserialize itself
+        Serializer gcSer;
+        const uint8_t type = ser.PopUnsignedChar();
+        gcSer.PushUnsignedChar(type & ~DELTA_POINT_FLAG);
+        if(type & DELTA_POINT_FLAG)
+        {
+            lastPt.x += PopVarInt(ser);
+            lastPt.y += PopVarInt(ser);
+            gcSer.PushUnsignedShort(lastPt.x);
+            gcSer.PushUnsignedShort(lastPt.y);
+        }
+        const unsigned dataSize = ser.PopVarSize();
+        if(dataSize > ser.GetBytesLeft())
+            throw std::range_error("Invalid game command size");
+        if(dataSize)
+        {
+            gcData.resize(dataSize);
+            ser.PopRawData(gcData.data(), dataSize);
+            gcSer.PushRawData(gcData.data(), dataSize);
+        }
+        gc = gc::GameCommand::Deserialize(gcSer);
+    }
+}
+
+void PlayerGameCommands::SerializeFullWidth(Serializer& ser) const
+{
+    checksum.Serialize(ser);
+
+    ser.PushUnsignedInt(gcs.size());
+    for(const gc::GameCommandPtr& gc : gcs)
+        gc->Serialize(ser);
 }
@@ -22,7 +22,10 @@
 #include <utility>
 #include <vector>
 
-/// GameCommands for 1 player
+/// GameCommands for 1 player.
+/// Sent every NWF for every player and stored in replays, so a compact encoding is used:
+/// Numbers are stored as varints, points of commands relative to the previous one
+/// and an NWF without commands and checksum (e.g. for AIs) needs only a single byte.
 struct PlayerGameCommands
 {
     /// Checksum for this NWF
@@ -36,4 +39,6 @@ struct PlayerGameCommands
     {}
     void Serialize(Serializer& ser) const;
     void Deserialize(Serializer& ser);
+    /// Serialize with fixed size fields (the former format). For comparison only, there is no counterpart to read it
+    void SerializeFullWidth(Serializer& ser) const;
 };
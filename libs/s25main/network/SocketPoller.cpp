@@ -0,0 +1,265 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#include "SocketPoller.h"
+#include "RTTR_Assert.h"
+#include "s25util/SocketSet.h"
+#include <algorithm>
+#ifdef __linux__
+#    include <sys/epoll.h>
+#    include <unistd.h>
+#endif
+
+#ifdef __linux__
+struct SocketPoller::EpollData
+{
+    int fd;
+    std::vector<epoll_event> events;
+};
+#else
+struct SocketPoller::EpollData
+{};
+#endif
+
+struct SocketPoller::SelectSets
+{
+    SocketSet read, write, error;
+    bool hasWriteInterest = false;
+    bool anyReadable = false, anyWritable = false, anyError = false;
+};
+
+SocketPoller::SocketPoller()
+{
+#ifdef __linux__
+    const int fd = epoll_create1(EPOLL_CLOEXEC);
+    // Otherwise use select
+    if(fd >= 0)
+        epoll_.reset(new EpollData{fd, {}});
+#endif
+}
+
+SocketPoller::~SocketPoller()
+{
+#ifdef __linux__
+    if(epoll_)
+        close(epoll_->fd);
+#endif
+}
+
+void SocketPoller::Add(const Socket& socket, unsigned id)
+{
+    RTTR_Assert(Find(id) == entries_.end());
+    entries_.push_back(Entry{id, socket, nullptr, false});
+#ifdef __linux__
+    UpdateEpoll(entries_.back(), EPOLL_CTL_ADD);
+#endif
+}
+
+void SocketPoller::AddPoller(const SocketPoller& poller, unsigned id)
+{
+    RTTR_Assert(Find(id) == entries_.end());
+    RTTR_Assert(&poller != this);
+    entries_.push_back(Entry{id, Socket(), &poller, false});
+#ifdef __linux__
+    // An epoll instance is readable when any of its sockets is ready. Without one select is used (see CanUseEpoll)
+    UpdateEpoll(entries_.back(), EPOLL_CTL_ADD);
+#endif
+}
+
+void SocketPoller::Remove(unsigned id)
+{
+    auto it = Find(id);
+    if(it == entries_.end())
+        return;
+#ifdef __linux__
+    // Fails if the socket was already closed, which removes it from epoll anyway
+    if(epoll_ && (!it->poller || it->poller->epoll_))
+    {
+        const int fd = it->poller ? it->poller->epoll_->fd : static_cast<int>(it->socket.GetSocket());
+        epoll_ctl(epoll_->fd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+#endif
+    entries_.erase(it);
+}
+
+void SocketPoller::Clear()
+{
+    while(!entries_.empty())
+        Remove(entries_.back().id);
+}
+
+void SocketPoller::SwapIds(unsigned id1, unsigned id2)
+{
+    auto it1 = Find(id1);
+    auto it2 = Find(id2);
+    if(it1 != entries_.end())
+        it1->id = id2;
+    if(it2 != entries_.end())
+        it2->id = id1;
+#ifdef __linux__
+    if(it1 != entries_.end())
+        UpdateEpoll(*it1, EPOLL_CTL_MOD);
+    if(it2 != entries_.end())
+        UpdateEpoll(*it2, EPOLL_CTL_MOD);
+#endif
+}
+
+void SocketPoller::SetWriteInterest(unsigned id, bool enabled)
+{
+    auto it = Find(id);
+    if(it == entries_.end() || it->wantWrite == enabled)
+        return;
+    // Watched pollers handle the write interest of their sockets
+    RTTR_Assert(!it->poller);
+    it->wantWrite = enabled;
+#ifdef __linux__
+    UpdateEpoll(*it, EPOLL_CTL_MOD);
+#endif
+}
+
+bool SocketPoller::HasWriteInterest(unsigned id) const
+{
+    auto it = Find(id);
+    return it != entries_.end() && it->wantWrite;
+}
+
+const std::vector<SocketPoller::Event>& SocketPoller::Wait(std::chrono::milliseconds timeout)
+{
+    events_.clear();
+    if(entries_.empty())
+        return events_;
+    const int timeoutMs = static_cast<int>(timeout.count());
+    if(CanUseEpoll())
+        WaitEpoll(timeoutMs);
+    else
+        WaitSelect(timeoutMs);
+    return events_;
+}
+
+bool SocketPoller::CanUseEpoll() const
+{
+    if(!epoll_)
+        return false;
+    return std::all_of(entries_.begin(), entries_.end(),
+                       [](const Entry& entry) { return !entry.poller || entry.poller->CanUseEpoll(); });
+}
+
+std::vector<SocketPoller::Entry>::iterator SocketPoller::Find(unsigned id)
+{
+    return std::find_if(entries_.begin(), entries_.end(), [id](const Entry& entry) { return entry.id == id; });
+}
+
+std::vector<SocketPoller::Entry>::const_iterator SocketPoller::Find(unsigned id) const
+{
+    return std::find_if(entries_.begin(), entries_.end(), [id](const Entry& entry) { return entry.id == id; });
+}
+
+#ifdef __linux__
+void SocketPoller::UpdateEpoll(const Entry& entry, int operation)
+{
+    if(!epoll_)
+        return;
+    epoll_event event{};
+    // Errors and hangups are always reported
+    event.events = EPOLLIN | (entry.wantWrite ? EPOLLOUT : 0u);
+    event.data.u32 = entry.id;
+    // Watched poller using select
+    if(entry.poller && !entry.poller->epoll_)
+        return;
+    const int fd = entry.poller ? entry.poller->epoll_->fd : static_cast<int>(entry.socket.GetSocket());
+    if(epoll_ctl(epoll_->fd, operation, fd, &event) != 0 && operation == EPOLL_CTL_ADD)
+    {
+        // Can't watch this socket (e.g. not supported by epoll) so switch to select for all
+        close(epoll_->fd);
+        epoll_.reset();
+    }
+}
+
+void SocketPoller::WaitEpoll(int timeoutMs)
+{
+    std::vector<epoll_event>& epollEvents = epoll_->events;
+    epollEvents.resize(entries_.size());
+    const int numEvents = epoll_wait(epoll_->fd, epollEvents.data(), static_cast<int>(epollEvents.size()), timeoutMs);
+    // Interrupted or timed out
+    if(numEvents <= 0)
+        return;
+    for(int i = 0; i < numEvents; i++)
+    {
+        const epoll_event& event = epollEvents[i];
+        // A hangup is handled by reading from the socket which detects the closed connection
+        events_.push_back(Event{event.data.u32, (event.events & (EPOLLIN | EPOLLHUP)) != 0,
+                                (event.events & EPOLLOUT) != 0, (event.events & EPOLLERR) != 0});
+    }
+}
+#else
+void SocketPoller::UpdateEpoll(const Entry&, int) {}
+
+void SocketPoller::WaitEpoll(int) {}
+#endif
+
+void SocketPoller::WaitSelect(int timeoutMs)
+{
+    // SocketSet can only check for one condition at a time so only the first check waits
+    SelectSets sets;
+    AddToSets(sets);
+    sets.anyReadable = sets.read.Select(timeoutMs, 0) > 0;
+    sets.anyWritable = sets.hasWriteInterest && sets.write.Select(0, 1) > 0;
+    sets.anyError = sets.error.Select(0, 2) > 0;
+    if(!sets.anyReadable && !sets.anyWritable && !sets.anyError)
+        return;
+    for(const Entry& entry : entries_)
+    {
+        const Event event = GetSelectEvent(entry, sets);
+        if(event.readable || event.writable || event.error)
+            events_.push_back(event);
+    }
+}
+
+void SocketPoller::AddToSets(SelectSets& sets) const
+{
+    for(const Entry& entry : entries_)
+    {
+        if(entry.poller)
+        {
+            entry.poller->AddToSets(sets);
+            continue;
+        }
+        sets.read.Add(entry.socket);
+        sets.error.Add(entry.socket);
+        if(entry.wantWrite)
+        {
+            sets.write.Add(entry.socket);
+            sets.hasWriteInterest = true;
+        }
+    }
+}
+
+SocketPoller::Event SocketPoller::GetSelectEvent(const Entry& entry, SelectSets& sets) const
+{
+    if(entry.poller)
+    {
+        const std::vector<Entry>& entries = entry.poller->entries_;
+        const bool isAnyReady = std::any_of(entries.begin(), entries.end(), [&entry, &sets](const Entry& innerEntry) {
+            const Event event = entry.poller->GetSelectEvent(innerEntry, sets);
+            return event.readable || event.writable || event.error;
+        });
+        return Event{entry.id, isAnyReady, false, false};
+    }
+    return Event{entry.id, sets.anyReadable && sets.read.InSet(entry.socket),
+                 sets.anyWritable && entry.wantWrite && sets.write.InSet(entry.socket),
+                 sets.anyError && sets.error.InSet(entry.socket)};
+}
@@ -0,0 +1,94 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "s25util/Socket.h"
+#include <chrono>
+#include <memory>
+#include <vector>
+
+/// Waits for a set of sockets to become ready and reports only those that are.
+/// Uses epoll where available so the cost depends on the number of ready sockets only.
+/// Otherwise (or if epoll cannot be used) falls back to select via SocketSet.
+/// Other pollers can be watched too, so one can wait for the sockets of multiple owners at once.
+class SocketPoller
+{
+public:
+    struct Event
+    {
+        /// Id given when the socket was added
+        unsigned id;
+        /// Data (or a closed connection) can be read
+        bool readable;
+        /// Data can be written without blocking. Only reported when requested via SetWriteInterest
+        bool writable;
+        bool error;
+    };
+
+    SocketPoller();
+    ~SocketPoller();
+    SocketPoller(const SocketPoller&) = delete;
+    SocketPoller& operator=(const SocketPoller&) = delete;
+
+    /// Watch the socket for incoming data. The id is used to identify it in the events
+    void Add(const Socket& socket, unsigned id);
+    /// Watch all sockets of another poller. It is reported as readable when any of them is ready.
+    /// The poller has to be removed before it is destroyed
+    void AddPoller(const SocketPoller& poller, unsigned id);
+    /// Stop watching the socket or poller with the given id. Should be called before the socket is closed
+    void Remove(unsigned id);
+    void Clear();
+    /// Exchange the ids of the sockets (if they exist)
+    void SwapIds(unsigned id1, unsigned id2);
+    /// Set whether to check if the socket can be written to, e.g. when data is waiting to be sent
+    void SetWriteInterest(unsigned id, bool enabled);
+    bool HasWriteInterest(unsigned id) const;
+    /// Wait at most the given time till any socket is ready and return all ready ones
+    const std::vector<Event>& Wait(std::chrono::milliseconds timeout);
+    bool IsUsingEpoll() const { return epoll_ != nullptr; }
+
+private:
+    struct Entry
+    {
+        unsigned id;
+        Socket socket;
+        /// Watched poller instead of the socket
+        const SocketPoller* poller;
+        bool wantWrite;
+    };
+    struct EpollData;
+    struct SelectSets;
+
+    /// True if epoll can be used for this and all watched pollers
+    bool CanUseEpoll() const;
+    std::vector<Entry>::iterator Find(unsigned id);
+    std::vector<Entry>::const_iterator Find(unsigned id) const;
+    /// Register the changed interest of the entry with epoll
+    void UpdateEpoll(const Entry& entry, int operation);
+    void WaitEpoll(int timeoutMs);
+    void WaitSelect(int timeoutMs);
+    /// Add all sockets (including those of watched pollers) to the sets
+    void AddToSets(SelectSets& sets) const;
+    /// Get the readiness of the entry after the select
+    Event GetSelectEvent(const Entry& entry, SelectSets& sets) const;
+
+    std::vector<Entry> entries_;
+    std::vector<Event> events_;
+    /// Epoll instance and its event buffer. Empty when select is used
+    std::unique_ptr<EpollData> epoll_;
+};
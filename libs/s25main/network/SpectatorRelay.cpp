@@ -0,0 +1,206 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#include "SpectatorRelay.h"
+#include "BinaryBuffer.h"
+#include "PlayerGameCommands.h"
+#include "RTTR_Assert.h"
+#include "Replay.h"
+#include "s25util/Log.h"
+#include "s25util/Serializer.h"
+#include "s25util/SocketSet.h"
+#include <algorithm>
+
+namespace {
+/// Maximum number of bytes sent at once. Small enough to not block when the socket reports being writable
+constexpr size_t MAX_SEND_SIZE = 4096;
+/// Maximum number of spectators accepted per run
+constexpr unsigned MAX_ACCEPTS_PER_RUN = 10;
+/// Id of the listen socket in the poller. Spectators are numbered from 0
+constexpr unsigned LISTEN_SOCKET_ID = 0xFFFFFFFF;
+
+/// Append an unsigned int in the (little endian) format used by BinaryFile
+void AppendUnsignedInt(std::vector<uint8_t>& data, uint32_t value)
+{
+    for(unsigned i = 0; i < 4; i++)
+        data.push_back(static_cast<uint8_t>(value >> (i * 8)));
+}
+} // namespace
+
+SpectatorRelay::SpectatorRelay() : nextSpectatorId_(0), numReleasedBytes_(0), delay_(0) {}
+
+SpectatorRelay::~SpectatorRelay()
+{
+    Stop();
+}
+
+bool SpectatorRelay::Start(uint16_t port, bool ipv6)
+{
+    Stop();
+    if(!listenSocket_.Listen(port, ipv6, false))
+    {
+        LOG.write("SERVER: Could not listen for spectators on port %1%\n") % port;
+        return false;
+    }
+    poller_.Add(listenSocket_, LISTEN_SOCKET_ID);
+    return true;
+}
+
+void SpectatorRelay::Stop()
+{
+    poller_.Clear();
+    for(Spectator& spectator : spectators_)
+        spectator.socket.Close();
+    spectators_.clear();
+    listenSocket_.Close();
+    stream_.clear();
+    numReleasedBytes_ = 0;
+    delayedCmds_.clear();
+}
+
+bool SpectatorRelay::StartStream(Replay& replay, const MapInfo& mapInfo, std::chrono::milliseconds delay)
+{
+    RTTR_Assert(!IsStreaming());
+    // Same header as written by a recording client
+    BinaryBuffer header;
+    if(!replay.WriteHeader(header, mapInfo))
+        return false;
+
+    AppendUnsignedInt(stream_, header.Tell());
+    AppendUnsignedInt(stream_, replay.GetLastGFFilePos());
+    stream_.insert(stream_.end(), header.GetData().begin(), header.GetData().end());
+    numReleasedBytes_ = stream_.size();
+    delay_ = delay;
+    return true;
+}
+
+void SpectatorRelay::AddGameCommand(unsigned gf, uint8_t player, const PlayerGameCommands& cmds)
+{
+    if(!IsStreaming())
+        return;
+    // Same format as written by the ReplayWriter
+    Serializer ser;
+    ser.PushUnsignedChar(player);
+    cmds.Serialize(ser);
+    AppendUnsignedInt(stream_, gf);
+    stream_.push_back(static_cast<uint8_t>(ReplayCommand::Game));
+    AppendUnsignedInt(stream_, ser.GetLength());
+    stream_.insert(stream_.end(), ser.GetData(), ser.GetData() + ser.GetLength());
+    delayedCmds_.emplace_back(Clock::now(), stream_.size());
+}
+
+void SpectatorRelay::EndStream()
+{
+    if(!IsStreaming())
+        return;
+    AppendUnsignedInt(stream_, Replay::END_GF);
+    stream_.push_back(static_cast<uint8_t>(ReplayCommand::End));
+    numReleasedBytes_ = stream_.size();
+    delayedCmds_.clear();
+    if(listenSocket_.isValid())
+    {
+        poller_.Remove(LISTEN_SOCKET_ID);
+        listenSocket_.Close();
+    }
+}
+
+bool SpectatorRelay::IsFlushed() const
+{
+    return std::all_of(spectators_.begin(), spectators_.end(),
+                       [this](const Spectator& spectator) { return spectator.numSentBytes == numReleasedBytes_; });
+}
+
+void SpectatorRelay::Run()
+{
+    if(listenSocket_.isValid())
+        AcceptSpectators();
+
+    const Clock::time_point now = Clock::now();
+    while(!delayedCmds_.empty() && delayedCmds_.front().first + delay_ <= now)
+    {
+        numReleasedBytes_ = delayedCmds_.front().second;
+        delayedCmds_.pop_front();
+    }
+    for(const Spectator& spectator : spectators_)
+        poller_.SetWriteInterest(spectator.id, spectator.numSentBytes < numReleasedBytes_);
+
+    std::vector<unsigned> brokenIds;
+    for(const SocketPoller::Event& event : poller_.Wait(std::chrono::milliseconds::zero()))
+    {
+        // New spectators were accepted already
+        if(event.id == LISTEN_SOCKET_ID)
+            continue;
+        auto it = std::find_if(spectators_.begin(), spectators_.end(),
+                               [&event](const Spectator& spectator) { return spectator.id == event.id; });
+        RTTR_Assert(it != spectators_.end());
+        bool isBroken = event.error;
+        if(!isBroken && event.readable)
+        {
+            // Spectators have nothing to say, but this detects closed connections
+            char buffer[256];
+            isBroken = it->socket.Recv(buffer, sizeof(buffer), false) <= 0;
+        }
+        if(!isBroken && event.writable)
+            isBroken = !SendData(*it);
+        if(isBroken)
+            brokenIds.push_back(event.id);
+    }
+    for(unsigned id : brokenIds)
+        RemoveSpectator(id);
+}
+
+void SpectatorRelay::AcceptSpectators()
+{
+    for(unsigned i = 0; i < MAX_ACCEPTS_PER_RUN; i++)
+    {
+        SocketSet set;
+        set.Add(listenSocket_);
+        if(set.Select(0, 0) <= 0)
+            return;
+        Socket socket = listenSocket_.Accept();
+        if(!socket.isValid())
+            return;
+        const unsigned id = nextSpectatorId_++;
+        spectators_.push_back(Spectator{id, socket, 0});
+        poller_.Add(socket, id);
+        LOG.write("SERVER: Spectator %1% connected\n") % id;
+    }
+}
+
+void SpectatorRelay::RemoveSpectator(unsigned id)
+{
+    auto it = std::find_if(spectators_.begin(), spectators_.end(),
+                           [id](const Spectator& spectator) { return spectator.id == id; });
+    if(it == spectators_.end())
+        return;
+    poller_.Remove(id);
+    it->socket.Close();
+    spectators_.erase(it);
+    LOG.write("SERVER: Spectator %1% disconnected\n") % id;
+}
+
+bool SpectatorRelay::SendData(Spectator& spectator)
+{
+    const size_t numBytes = std::min(numReleasedBytes_ - spectator.numSentBytes, MAX_SEND_SIZE);
+    if(numBytes == 0)
+        return true;
+    const int numSent = spectator.socket.Send(&stream_[spectator.numSentBytes], static_cast<int>(numBytes));
+    if(numSent < 0)
+        return false;
+    spectator.numSentBytes += numSent;
+    return true;
+}
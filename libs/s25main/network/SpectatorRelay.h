@@ -0,0 +1,93 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "Clock.h"
+#include "SocketPoller.h"
+#include "s25util/Socket.h"
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+class MapInfo;
+class Replay;
+struct PlayerGameCommands;
+
+/// Relays the commands of a running game to any number of read-only spectators.
+/// The stream has the format of a replay file prefixed by the size of the replay header (u32) and the position of the
+/// last GF in it (u32), so spectators can write a replay that is valid after each command (see s25replay --spectate).
+/// Commands are held back for a fixed time after they were added, independent of the game speed. Spectators never delay
+/// the game: Data they cannot receive yet is kept and sent later. Spectators joining late get everything from the start
+/// and can fast-forward through it.
+class SpectatorRelay
+{
+public:
+    SpectatorRelay();
+    ~SpectatorRelay();
+
+    /// Start listening for spectators on the given port
+    bool Start(uint16_t port, bool ipv6);
+    /// Disconnect all spectators and drop all data
+    void Stop();
+    bool IsRunning() const { return listenSocket_.isValid(); }
+
+    /// Start the stream with the header of the replay and the map. Commands are delayed by the given time
+    bool StartStream(Replay& replay, const MapInfo& mapInfo, std::chrono::milliseconds delay);
+    bool IsStreaming() const { return !stream_.empty(); }
+    /// Add the commands of a player which are executed at the given GF
+    void AddGameCommand(unsigned gf, uint8_t player, const PlayerGameCommands& cmds);
+    /// Add the end marker. Everything is released regardless of the delay and no new spectators are accepted, so the port
+    /// can be used again. The connected spectators are served till they received everything (see IsFlushed)
+    void EndStream();
+    /// True if all connected spectators received everything released so far
+    bool IsFlushed() const;
+
+    /// Accept new spectators and send them what is due. Never blocks
+    void Run();
+    /// Poller of all sockets that need attention, so one can wait till there is something to do
+    const SocketPoller& GetPoller() const { return poller_; }
+    unsigned GetNumSpectators() const { return static_cast<unsigned>(spectators_.size()); }
+
+private:
+    struct Spectator
+    {
+        unsigned id;
+        Socket socket;
+        /// Number of bytes of the stream sent to this spectator
+        size_t numSentBytes;
+    };
+
+    void AcceptSpectators();
+    void RemoveSpectator(unsigned id);
+    /// Send the next part of the stream. Return false if the connection is broken
+    bool SendData(Spectator& spectator);
+
+    Socket listenSocket_;
+    SocketPoller poller_;
+    std::vector<Spectator> spectators_;
+    unsigned nextSpectatorId_;
+
+    /// Everything to send, starting with the header
+    std::vector<uint8_t> stream_;
+    /// Number of bytes of the stream which may be sent already
+    size_t numReleasedBytes_;
+    /// Time at which they were added and end position of the commands that are still held back
+    std::deque<std::pair<Clock::time_point, size_t>> delayedCmds_;
+    std::chrono::milliseconds delay_;
+};
@@ -51,6 +51,13 @@ public:
                                        FP_Node_OK_Callback IsNodeOK, FP_Node_OK_Callback IsNodeOKAlternate,
                                        FP_Node_OK_Callback IsNodeToDestOk, const void* param);
 
+    /// Length of the shortest path from start to each of the targets found in a single breadth-first search.
+    /// Paths do not lead through nodes not fulfilling the conditions but those are valid targets.
+    /// Targets without a path of at most maxLength get the length std::numeric_limits<unsigned>::max()
+    template<class TNodeChecker>
+    std::vector<unsigned> FindPathLengths(MapPoint start, const std::vector<MapPoint>& targets, unsigned maxLength,
+                                          const TNodeChecker& nodeChecker);
+
     /// Ermittelt, ob eine freie Route noch passierbar ist und gibt den Endpunkt der Route zurück
     template<class TNodeChecker>
     bool CheckRoute(MapPoint start, const std::vector<Direction>& route, unsigned pos, const TNodeChecker& nodeChecker,
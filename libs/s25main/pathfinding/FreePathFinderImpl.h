@@ -18,12 +18,16 @@
 #pragma once
 
 #include "EventManager.h"
+#include "GFProfiler.h"
 #include "pathfinding/FreePathFinder.h"
 #include "pathfinding/NewNode.h"
 #include "pathfinding/OpenListBinaryHeap.h"
 #include "pathfinding/OpenListPrioQueue.h"
 #include "pathfinding/PathfindingPoint.h"
 #include "world/GameWorldBase.h"
+#include <algorithm>
+#include <limits>
+#include <utility>
 
 using FreePathNodes = std::vector<FreePathNode>;
 extern FreePathNodes fpNodes;
@@ -56,6 +60,7 @@ bool FreePathFinder::FindPath(const MapPoint start, const MapPoint dest, bool ra
                               const TNodeChecker& nodeChecker)
 {
     RTTR_Assert(start != dest);
+    GFProfiler::ScopedTimer timer(GFProfiler::GetSlot(GFProfiler::Section::Pathfinding));
 
     // increase currentVisit, so we don't have to clear the visited-states at every run
     IncreaseCurrentVisit();
@@ -177,6 +182,59 @@ bool FreePathFinder::FindPath(const MapPoint start, const MapPoint dest, bool ra
     return false;
 }
 
+template<class TNodeChecker>
+std::vector<unsigned> FreePathFinder::FindPathLengths(const MapPoint start, const std::vector<MapPoint>& targets,
+                                                      const unsigned maxLength, const TNodeChecker& nodeChecker)
+{
+    GFProfiler::ScopedTimer timer(GFProfiler::GetSlot(GFProfiler::Section::Pathfinding));
+
+    std::vector<unsigned> lengths(targets.size(), std::numeric_limits<unsigned>::max());
+    // Node index and index of the target, sorted by node
+    std::vector<std::pair<unsigned, unsigned>> targetIds;
+    targetIds.reserve(targets.size());
+    for(unsigned i = 0; i < targets.size(); i++)
+        targetIds.emplace_back(gwb_.GetIdx(targets[i]), i);
+    std::sort(targetIds.begin(), targetIds.end());
+    unsigned numUnreached = targets.size();
+    const auto setReached = [&](const unsigned nodeId, const unsigned length) {
+        const auto range = std::equal_range(targetIds.begin(), targetIds.end(), std::make_pair(nodeId, 0u),
+                                            [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+        for(auto it = range.first; it != range.second; ++it)
+        {
+            lengths[it->second] = length;
+            numUnreached--;
+        }
+    };
+
+    IncreaseCurrentVisit();
+    FreePathNode& startNode = fpNodes[gwb_.GetIdx(start)];
+    startNode.lastVisited = currentVisit;
+    setReached(startNode.idx, 0);
+
+    // All edges have the same cost, so each layer of the search holds the nodes with the same path length
+    std::vector<FreePathNode*> curLayer(1, &startNode), nextLayer;
+    for(unsigned length = 1; length <= maxLength && numUnreached > 0 && !curLayer.empty(); length++)
+    {
+        nextLayer.clear();
+        for(const FreePathNode* node : curLayer)
+        {
+            for(const Direction dir : helpers::EnumRange<Direction>{})
+            {
+                const MapPoint neighbourPos = gwb_.GetNeighbour(node->mapPt, dir);
+                FreePathNode& neighbour = fpNodes[gwb_.GetIdx(neighbourPos)];
+                if(neighbour.lastVisited == currentVisit || !nodeChecker.IsEdgeOk(node->mapPt, dir))
+                    continue;
+                neighbour.lastVisited = currentVisit;
+                setReached(neighbour.idx, length);
+                if(nodeChecker.IsNodeOk(neighbourPos))
+                    nextLayer.push_back(&neighbour);
+            }
+        }
+        std::swap(curLayer, nextLayer);
+    }
+    return lengths;
+}
+
 /// Ermittelt, ob eine freie Route noch passierbar ist und gibt den Endpunkt der Route zurück
 template<class TNodeChecker>
 bool FreePathFinder::CheckRoute(const MapPoint start, const std::vector<Direction>& route, unsigned pos,
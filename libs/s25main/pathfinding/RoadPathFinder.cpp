@@ -17,6 +17,7 @@
 
 #include "RoadPathFinder.h"
 #include "EventManager.h"
+#include "GFProfiler.h"
 #include "RttrForeachPt.h"
 #include "buildings/nobHarborBuilding.h"
 #include "pathfinding/OpenListPrioQueue.h"
@@ -120,6 +121,7 @@ bool RoadPathFinder::FindPathImpl(const noRoadNode& start, const noRoadNode& goa
                                   unsigned* const length, RoadPathDirection* const firstDir,
                                   MapPoint* const firstNodePos)
 {
+    GFProfiler::ScopedTimer timer(GFProfiler::GetSlot(GFProfiler::Section::Pathfinding));
     if(&start == &goal)
     {
         // Path where start==goal should never happen
@@ -16,8 +16,10 @@
 // along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
 
 #include "GameWorld.h"
+#include "GamePlayer.h"
 #include "GlobalGameSettings.h"
 #include "SerializedGameData.h"
+#include "addons/const_addons.h"
 #include "buildings/noBuildingSite.h"
 #include "lua/LuaInterfaceGame.h"
 #include "ogl/glArchivItem_Map.h"
@@ -45,6 +47,10 @@ bool GameWorld::LoadMap(const std::shared_ptr<Game>& game, ILocalGameState& loca
 
     const glArchivItem_Map& map = *static_cast<glArchivItem_Map*>(mapArchiv[0]);
 
+    /// Startbündnisse setzen
+    for(unsigned i = 0; i < GetNumPlayers(); ++i)
+        GetPlayer(i).MakeStartPacts();
+
     if(bfs::exists(luaFilePath))
     {
         SetLua(std::make_unique<LuaInterfaceGame>(game, localgameState));
@@ -62,6 +68,20 @@ bool GameWorld::LoadMap(const std::shared_ptr<Game>& game, ILocalGameState& loca
         return false;
 
     CreateTradeGraphs();
+
+    /// Evtl. Goldvorkommen ändern
+    Resource::Type target; // löschen
+    switch(GetGGS().getSelection(AddonId::CHANGE_GOLD_DEPOSITS))
+    {
+        case 0:
+        default: target = Resource::Gold; break;
+        case 1: target = Resource::Nothing; break;
+        case 2: target = Resource::Iron; break;
+        case 3: target = Resource::Coal; break;
+        case 4: target = Resource::Granite; break;
+    }
+    ConvertMineResourceTypes(Resource::Gold, target);
+    PlaceAndFixWater();
     return true;
 }
 
@@ -31,7 +31,7 @@ class GameWorld : public GameWorldGame
 public:
     GameWorld(const std::vector<PlayerInfo>& playerInfos, const GlobalGameSettings& gameSettings, EventManager& em);
 
-    /// Lädt eine Karte
+    /// Lädt eine Karte für ein neues Spiel (inkl. Startbündnisse und Änderungen durch Addons)
     bool LoadMap(const std::shared_ptr<Game>& game, ILocalGameState& localgameState,
                  const boost::filesystem::path& mapFilePath, const boost::filesystem::path& luaFilePath);
 
@@ -22,6 +22,7 @@
 #include "GlobalGameSettings.h"
 #include "Loader.h"
 #include "MapGeometry.h"
+#include "TraceRecorder.h"
 #include "addons/AddonMaxWaterwayLength.h"
 #include "buildings/noBuildingSite.h"
 #include "buildings/nobMilitary.h"
@@ -120,6 +121,7 @@ struct ObjectBetweenLines
 
 void GameWorldView::Draw(const RoadBuildState& rb, const MapPoint selected, bool drawMouse, unsigned* water)
 {
+    RTTR_TRACE_SCOPE("GameWorldView::Draw");
     SetNextZoomFactor();
 
     int shortestDistToMouse = 100000;
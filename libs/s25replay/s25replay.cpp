@@ -0,0 +1,550 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#include "GFProfiler.h"
+#include "Replay.h"
+#include "ReplayRunner.h"
+#include "RttrConfig.h"
+#include "network/PlayerGameCommands.h"
+#include "ogl/glAllocator.h"
+#include "gameTypes/MapInfo.h"
+#include "libsiedler2/libsiedler2.h"
+#include "s25util/LocaleHelper.h"
+#include "s25util/Serializer.h"
+#include "s25util/Socket.h"
+#include <boost/filesystem.hpp>
+#include <boost/nowide/args.hpp>
+#include <boost/nowide/fstream.hpp>
+#include <boost/nowide/iostream.hpp>
+#include <boost/process.hpp>
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bfs = boost::filesystem;
+namespace bnw = boost::nowide;
+namespace bp = boost::process;
+namespace po = boost::program_options;
+
+namespace {
+/// Exit codes of a single replay run
+enum ReplayExitCode
+{
+    RESULT_OK = 0,
+    RESULT_ERROR = 1,
+    RESULT_ASYNC = 2,
+    /// Spectating: The connection was closed before the end of the game, so the replay is incomplete
+    RESULT_INCOMPLETE = 3
+};
+
+/// Closes the socket and shuts down the socket library when leaving the scope
+class SocketGuard
+{
+public:
+    explicit SocketGuard(Socket& socket) : socket_(socket) {}
+    ~SocketGuard()
+    {
+        socket_.Close();
+        Socket::Shutdown();
+    }
+    SocketGuard(const SocketGuard&) = delete;
+    SocketGuard& operator=(const SocketGuard&) = delete;
+
+private:
+    Socket& socket_;
+};
+
+/// Play the replay as fast as possible and print the simulation speed.
+/// On an async the random log is written to asyncLogPath (if set).
+/// If profilePath is set the time spent per GF is written to it (JSON if the extension is .json, else CSV)
+int RunReplay(const bfs::path& replayPath, const unsigned targetGF, const bool stopOnAsync,
+              const bfs::path& asyncLogPath, const bfs::path& profilePath)
+{
+    ReplayRunner runner;
+    const auto loadStartTime = std::chrono::steady_clock::now();
+    if(!runner.Load(replayPath))
+    {
+        bnw::cerr << "Error loading replay " << replayPath << ": " << runner.GetLastErrorMsg() << std::endl;
+        return RESULT_ERROR;
+    }
+    const auto startTime = std::chrono::steady_clock::now();
+    const unsigned startGF = runner.GetCurrentGF();
+    bnw::cout << "Loaded " << replayPath << " in "
+              << std::chrono::duration<double>(startTime - loadStartTime).count() << "s. Running GF " << startGF
+              << " to " << std::min(targetGF, runner.GetLastGF() + 1) << std::endl;
+
+    GFPROFILER.SetEnabled(!profilePath.empty());
+    const unsigned numGFs = runner.Run(targetGF, stopOnAsync);
+    const double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    GFPROFILER.SetEnabled(false);
+    if(!profilePath.empty())
+    {
+        const bool written = profilePath.extension() == ".json" ? GFPROFILER.WriteJSON(profilePath) :
+                                                                   GFPROFILER.WriteCSV(profilePath);
+        if(written)
+            bnw::cout << "Profile written to " << profilePath << std::endl;
+        else
+            bnw::cerr << "Could not write profile to " << profilePath << std::endl;
+    }
+
+    // Parsed by VerifyReplays, keep the format
+    bnw::cout << "Executed " << numGFs << " GFs (" << runner.FormatGFTime(numGFs) << " game time) in " << duration
+              << "s: " << (duration > 0 ? numGFs / duration : 0.) << " GF/s" << std::endl;
+    if(!runner.GetFirstAsyncGF())
+        return RESULT_OK;
+
+    const AsyncChecksum& expected = runner.GetExpectedChecksum();
+    const AsyncChecksum& actual = runner.GetActualChecksum();
+    bnw::cout << "Async at GF " << *runner.GetFirstAsyncGF() << ": Checksum " << expected.randChecksum << ":"
+              << actual.randChecksum << " ObjCt " << expected.objCt << ":" << actual.objCt << " ObjIdCt "
+              << expected.objIdCt << ":" << actual.objIdCt << std::endl;
+    if(!asyncLogPath.empty())
+    {
+        bnw::ofstream logFile(asyncLogPath);
+        for(const RandomEntry& entry : runner.GetAsyncLog())
+            logFile << entry << std::endl;
+        if(logFile)
+            bnw::cout << "Random log written to " << asyncLogPath << std::endl;
+        else
+            bnw::cerr << "Could not write random log to " << asyncLogPath << std::endl;
+    }
+    return RESULT_ASYNC;
+}
+
+std::vector<bfs::path> FindReplays(const bfs::path& directory)
+{
+    std::vector<bfs::path> replays;
+    for(const auto& entry : bfs::directory_iterator(directory))
+    {
+        if(bfs::is_regular_file(entry.status()) && entry.path().extension() == ".rpl")
+            replays.push_back(entry.path());
+    }
+    std::sort(replays.begin(), replays.end());
+    return replays;
+}
+
+/// Size of the game command messages of all players, which are sent every NWF
+struct CommandSizeStats
+{
+    uint64_t numNWFs = 0, numEmptyNWFs = 0, numGCs = 0;
+    uint64_t fullWidthSize = 0, compactSize = 0;
+};
+
+bool AddCommandSizes(const bfs::path& replayPath, CommandSizeStats& stats)
+{
+    Replay replay;
+    MapInfo mapInfo;
+    if(!replay.LoadHeader(replayPath, true) || !replay.LoadGameData(mapInfo))
+    {
+        bnw::cerr << "Error loading replay " << replayPath << ": " << replay.GetLastErrorMsg() << std::endl;
+        return false;
+    }
+    unsigned gf;
+    Serializer ser;
+    while(replay.ReadGF(&gf))
+    {
+        switch(replay.ReadRCType())
+        {
+            case ReplayCommand::Chat:
+            {
+                uint8_t player, dest;
+                std::string message;
+                replay.ReadChatCommand(player, dest, message);
+                break;
+            }
+            case ReplayCommand::Game:
+            {
+                uint8_t player;
+                PlayerGameCommands cmds;
+                replay.ReadGameCommand(player, cmds);
+                stats.numNWFs++;
+                if(cmds.gcs.empty())
+                    stats.numEmptyNWFs++;
+                stats.numGCs += cmds.gcs.size();
+                ser.Clear();
+                cmds.SerializeFullWidth(ser);
+                stats.fullWidthSize += ser.GetLength();
+                ser.Clear();
+                cmds.Serialize(ser);
+                stats.compactSize += ser.GetLength();
+                break;
+            }
+            case ReplayCommand::Keyframe: replay.SkipKeyframe(); break;
+            default: bnw::cerr << "Invalid command in replay " << replayPath << std::endl; return false;
+        }
+    }
+    return true;
+}
+
+/// Read an unsigned int in the (little endian) format used by BinaryFile
+uint32_t GetUnsignedInt(const std::vector<uint8_t>& data, size_t pos)
+{
+    return static_cast<uint32_t>(data[pos]) | (static_cast<uint32_t>(data[pos + 1]) << 8)
+           | (static_cast<uint32_t>(data[pos + 2]) << 16) | (static_cast<uint32_t>(data[pos + 3]) << 24);
+}
+
+/// Write the game relayed to spectators by a server (see SpectatorRelay) into a replay file.
+/// The file is updated after each received command, so it can be played (and fast-forwarded) while recording
+int RecordSpectatorStream(const std::string& address, const bfs::path& replayPath)
+{
+    const size_t portPos = address.rfind(':');
+    if(portPos == std::string::npos)
+    {
+        bnw::cerr << "Invalid address " << address << ". Expected host:port" << std::endl;
+        return RESULT_ERROR;
+    }
+    const std::string host = address.substr(0, portPos);
+    unsigned long port = 0;
+    try
+    {
+        port = std::stoul(address.substr(portPos + 1));
+    } catch(const std::logic_error&)
+    {}
+    if(port == 0 || port > std::numeric_limits<uint16_t>::max())
+    {
+        bnw::cerr << "Invalid port in address " << address << std::endl;
+        return RESULT_ERROR;
+    }
+    if(bfs::exists(replayPath))
+    {
+        bnw::cerr << replayPath << " already exists" << std::endl;
+        return RESULT_ERROR;
+    }
+    bnw::fstream file(replayPath.string(), std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!file)
+    {
+        bnw::cerr << "Could not open " << replayPath << std::endl;
+        return RESULT_ERROR;
+    }
+    if(!Socket::Initialize())
+    {
+        bnw::cerr << "Could not init sockets!" << std::endl;
+        return RESULT_ERROR;
+    }
+    Socket socket;
+    const SocketGuard socketGuard(socket);
+    if(!socket.Connect(host, static_cast<uint16_t>(port), false))
+    {
+        bnw::cerr << "Could not connect to " << address << std::endl;
+        return RESULT_ERROR;
+    }
+
+    // The stream starts with the size of the replay header and the position of the last GF in it
+    constexpr size_t preambleSize = 8;
+    // GF and command type
+    constexpr size_t cmdHeaderSize = 5;
+    std::vector<uint8_t> buffer;
+    bool isHeaderWritten = false, isFinished = false;
+    unsigned lastGFFilePos = 0, lastGF = 0, numCmds = 0;
+    while(!isFinished)
+    {
+        char chunk[4096];
+        const int numReceived = socket.Recv(chunk, sizeof(chunk));
+        if(numReceived <= 0)
+            break;
+        buffer.insert(buffer.end(), chunk, chunk + numReceived);
+
+        size_t pos = 0;
+        if(!isHeaderWritten)
+        {
+            if(buffer.size() < preambleSize)
+                continue;
+            const unsigned headerSize = GetUnsignedInt(buffer, 0);
+            lastGFFilePos = GetUnsignedInt(buffer, 4);
+            if(buffer.size() < preambleSize + headerSize)
+                continue;
+            file.write(reinterpret_cast<const char*>(&buffer[preambleSize]), headerSize);
+            pos = preambleSize + headerSize;
+            isHeaderWritten = true;
+        }
+        // Write all complete commands
+        const size_t cmdsStartPos = pos;
+        while(pos + cmdHeaderSize <= buffer.size())
+        {
+            const unsigned gf = GetUnsignedInt(buffer, pos);
+            const auto type = static_cast<ReplayCommand>(buffer[pos + 4]);
+            if(type == ReplayCommand::End)
+            {
+                pos += cmdHeaderSize;
+                isFinished = true;
+                break;
+            }
+            if(type != ReplayCommand::Game)
+            {
+                bnw::cerr << "Invalid command received" << std::endl;
+                return RESULT_ERROR;
+            }
+            if(pos + cmdHeaderSize + 4 > buffer.size())
+                break;
+            const size_t cmdEndPos = pos + cmdHeaderSize + 4 + GetUnsignedInt(buffer, pos + cmdHeaderSize);
+            if(cmdEndPos > buffer.size())
+                break;
+            pos = cmdEndPos;
+            lastGF = gf;
+            numCmds++;
+        }
+        if(pos == cmdsStartPos && !isFinished)
+        {
+            buffer.erase(buffer.begin(), buffer.begin() + pos);
+            continue;
+        }
+        file.write(reinterpret_cast<const char*>(buffer.data() + cmdsStartPos), pos - cmdsStartPos);
+        // Make the new commands visible to readers of the replay
+        const uint8_t lastGFData[4] = {static_cast<uint8_t>(lastGF), static_cast<uint8_t>(lastGF >> 8),
+                                       static_cast<uint8_t>(lastGF >> 16), static_cast<uint8_t>(lastGF >> 24)};
+        file.seekp(lastGFFilePos);
+        file.write(reinterpret_cast<const char*>(lastGFData), sizeof(lastGFData));
+        file.seekp(0, std::ios::end);
+        file.flush();
+        buffer.erase(buffer.begin(), buffer.begin() + pos);
+    }
+    bnw::cout << "Received " << numCmds << " commands up to GF " << lastGF << std::endl;
+    if(!isFinished)
+    {
+        bnw::cerr << "Connection closed before the end of the game" << std::endl;
+        return isHeaderWritten ? RESULT_INCOMPLETE : RESULT_ERROR;
+    }
+    return RESULT_OK;
+}
+
+/// Print the size of the game commands per NWF and player using the fixed size and the compact encoding
+int PrintCommandSizes(const std::vector<bfs::path>& replays)
+{
+    CommandSizeStats stats;
+    for(const bfs::path& replayPath : replays)
+    {
+        if(!AddCommandSizes(replayPath, stats))
+            return RESULT_ERROR;
+    }
+    if(!stats.numNWFs)
+    {
+        bnw::cerr << "No game commands found" << std::endl;
+        return RESULT_ERROR;
+    }
+    const auto perNWF = [&stats](uint64_t size) { return static_cast<double>(size) / stats.numNWFs; };
+    bnw::cout << replays.size() << " replays: " << stats.numNWFs << " NWFs of all players (" << stats.numEmptyNWFs
+              << " without commands) with " << stats.numGCs << " commands\n"
+              << "Full width: " << stats.fullWidthSize << " bytes, " << perNWF(stats.fullWidthSize)
+              << " bytes per NWF and player\n"
+              << "Compact:    " << stats.compactSize << " bytes, " << perNWF(stats.compactSize)
+              << " bytes per NWF and player ("
+              << (100. * stats.compactSize / std::max<uint64_t>(stats.fullWidthSize, 1u)) << "%)" << std::endl;
+    return RESULT_OK;
+}
+
+struct VerifyResult
+{
+    int exitCode = RESULT_ERROR;
+    unsigned numGFs = 0;
+    std::string output;
+};
+
+/// Run the replay in a new process of this program and collect its output.
+/// A process is required as the game uses global state
+VerifyResult RunReplayProcess(const bfs::path& programPath, const bfs::path& replayPath, const unsigned targetGF,
+                              const bfs::path& asyncLogPath)
+{
+    std::vector<std::string> args{replayPath.string(), "--stop-on-async", "--async-log", asyncLogPath.string()};
+    if(targetGF != std::numeric_limits<unsigned>::max())
+    {
+        args.push_back("--gf");
+        args.push_back(std::to_string(targetGF));
+    }
+
+    VerifyResult result;
+    try
+    {
+        bp::ipstream output;
+        bp::child process(programPath, args, (bp::std_out & bp::std_err) > output);
+        std::string line;
+        while(std::getline(output, line))
+        {
+            std::istringstream lineStream(line);
+            std::string word;
+            if(lineStream >> word && word == "Executed")
+                lineStream >> result.numGFs;
+            result.output += line + '\n';
+        }
+        process.wait();
+        result.exitCode = process.exit_code();
+    } catch(const std::exception& e)
+    {
+        result.output += std::string("Failed to run replay: ") + e.what() + '\n';
+    }
+    return result;
+}
+
+/// Play all replays in the directory in parallel and check them for asyncs
+int VerifyReplays(const bfs::path& programPath, const bfs::path& directory, unsigned numJobs, const unsigned targetGF,
+                  const bfs::path& logDirectory)
+{
+    const std::vector<bfs::path> replays = FindReplays(directory);
+    if(replays.empty())
+    {
+        bnw::cerr << "No replays found in " << directory << std::endl;
+        return RESULT_ERROR;
+    }
+    numJobs = std::max(1u, std::min<unsigned>(numJobs, replays.size()));
+    bfs::create_directories(logDirectory);
+    bnw::cout << "Verifying " << replays.size() << " replays using " << numJobs << " processes" << std::endl;
+
+    std::vector<VerifyResult> results(replays.size());
+    std::atomic<size_t> nextReplay(0);
+    std::mutex outputMutex;
+    const auto startTime = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for(unsigned i = 0; i < numJobs; i++)
+    {
+        workers.emplace_back([&]() {
+            for(size_t idx = nextReplay++; idx < replays.size(); idx = nextReplay++)
+            {
+                const bfs::path asyncLogPath = logDirectory / (replays[idx].stem().string() + "_async.log");
+                VerifyResult& result = results[idx];
+                result = RunReplayProcess(programPath, replays[idx], targetGF, asyncLogPath);
+
+                std::lock_guard<std::mutex> lock(outputMutex);
+                const char* status =
+                  (result.exitCode == RESULT_OK) ? "OK" : (result.exitCode == RESULT_ASYNC) ? "ASYNC" : "ERROR";
+                bnw::cout << "[" << status << "] " << replays[idx].filename().string() << ": " << result.numGFs
+                          << " GFs" << std::endl;
+                if(result.exitCode != RESULT_OK)
+                    bnw::cout << result.output;
+            }
+        });
+    }
+    for(std::thread& worker : workers)
+        worker.join();
+
+    const double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    uint64_t totalGFs = 0;
+    unsigned numAsync = 0, numFailed = 0;
+    for(const VerifyResult& result : results)
+    {
+        totalGFs += result.numGFs;
+        if(result.exitCode == RESULT_ASYNC)
+            numAsync++;
+        else if(result.exitCode != RESULT_OK)
+            numFailed++;
+    }
+    bnw::cout << "\n"
+              << replays.size() << " replays: " << (replays.size() - numAsync - numFailed) << " in sync, " << numAsync
+              << " async, " << numFailed << " failed\n"
+              << "Executed " << totalGFs << " GFs in " << duration
+              << "s: " << (duration > 0 ? totalGFs / duration : 0.) << " GF/s" << std::endl;
+    if(numFailed)
+        return RESULT_ERROR;
+    return numAsync ? RESULT_ASYNC : RESULT_OK;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    bnw::args _(argc, argv);
+
+    po::options_description desc("Allowed options");
+    // clang-format off
+    desc.add_options()
+        ("help,h", "Show help")
+        ("replay,r", po::value<std::string>(), "Replay to play or directory with replays to verify")
+        ("gf", po::value<unsigned>(), "Stop at this GF instead of the end of the replay")
+        ("stop-on-async", "Stop at the first async")
+        ("async-log", po::value<std::string>(), "File to write the random log to on an async")
+        ("profile", po::value<std::string>(), "File to write the time spent per GF to (CSV or .json)")
+        ("jobs,j", po::value<unsigned>()->default_value(std::max(1u, std::thread::hardware_concurrency())),
+            "Number of replays verified in parallel")
+        ("log-dir", po::value<std::string>()->default_value("."), "Directory for the random logs of async replays")
+        ("command-sizes", "Only print the size of the game commands sent per NWF and player")
+        ("spectate", po::value<std::string>(),
+            "Record the game a server relays to spectators (host:port) into the given replay. "
+            "Exits with 3 if the connection was closed before the end of the game")
+        ;
+    // clang-format on
+    po::positional_options_description positionalOptions;
+    positionalOptions.add("replay", 1);
+
+    po::variables_map options;
+    try
+    {
+        po::store(po::command_line_parser(argc, argv).options(desc).positional(positionalOptions).run(), options);
+    } catch(const po::error& e)
+    {
+        bnw::cerr << "Error: " << e.what() << "\n\n";
+        bnw::cerr << desc << "\n";
+        return RESULT_ERROR;
+    }
+    po::notify(options);
+
+    if(options.count("help") || !options.count("replay"))
+    {
+        bnw::cout << "Plays a replay without graphics as fast as possible (e.g. to benchmark the simulation).\n"
+                     "If a directory is given, all replays in it are played in parallel and checked for asyncs.\n"
+                  << desc << "\n";
+        return options.count("help") ? RESULT_OK : RESULT_ERROR;
+    }
+
+    const bfs::path replayPath = options["replay"].as<std::string>();
+    const unsigned targetGF =
+      options.count("gf") ? options["gf"].as<unsigned>() : std::numeric_limits<unsigned>::max();
+
+    try
+    {
+        if(options.count("spectate"))
+            return RecordSpectatorStream(options["spectate"].as<std::string>(), replayPath);
+        if(options.count("command-sizes"))
+        {
+            const std::vector<bfs::path> replays =
+              bfs::is_directory(replayPath) ? FindReplays(replayPath) : std::vector<bfs::path>{replayPath};
+            return PrintCommandSizes(replays);
+        }
+        if(bfs::is_directory(replayPath))
+        {
+            bfs::path programPath = argv[0];
+            if(!programPath.has_parent_path())
+                programPath = bp::search_path(programPath);
+            return VerifyReplays(bfs::absolute(programPath), replayPath, options["jobs"].as<unsigned>(), targetGF,
+                                 options["log-dir"].as<std::string>());
+        }
+
+        if(!LocaleHelper::init())
+            return RESULT_ERROR;
+        if(!RTTRCONFIG.Init())
+            return RESULT_ERROR;
+        // Needed for loading the maps even if nothing is drawn
+        libsiedler2::setAllocator(new GlAllocator());
+
+        const bfs::path asyncLogPath = options.count("async-log") ? options["async-log"].as<std::string>() : "";
+        const bfs::path profilePath = options.count("profile") ? options["profile"].as<std::string>() : "";
+        const int result =
+          RunReplay(replayPath, targetGF, options.count("stop-on-async") > 0, asyncLogPath, profilePath);
+        libsiedler2::setAllocator(nullptr);
+        return result;
+    } catch(const std::exception& e)
+    {
+        bnw::cerr << "Error: " << e.what() << std::endl;
+        return RESULT_ERROR;
+    }
+}
@@ -0,0 +1,288 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#include "RttrConfig.h"
+#include "Settings.h"
+#include "files.h"
+#include "network/CreateServerInfo.h"
+#include "network/GameServer.h"
+#include "network/SocketPoller.h"
+#include "ogl/glAllocator.h"
+#include "gameTypes/MapType.h"
+#include "libsiedler2/libsiedler2.h"
+#include "s25util/LocaleHelper.h"
+#include "s25util/Log.h"
+#include "s25util/Socket.h"
+#include "s25util/strFuncs.h"
+#include <boost/filesystem.hpp>
+#include <boost/nowide/args.hpp>
+#include <boost/nowide/iostream.hpp>
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace bfs = boost::filesystem;
+namespace bnw = boost::nowide;
+namespace po = boost::program_options;
+
+namespace {
+volatile std::sig_atomic_t stopRequested = 0;
+
+void StopSignalHandler(int)
+{
+    stopRequested = 1;
+}
+
+/// A game hosted by this process
+struct HostedGame
+{
+    HostedGame(CreateServerInfo csi, bfs::path mapPath, MapType mapType, uint16_t spectatorPort)
+        : csi(std::move(csi)), mapPath(std::move(mapPath)), mapType(mapType), spectatorPort(spectatorPort)
+    {}
+    CreateServerInfo csi;
+    bfs::path mapPath;
+    MapType mapType;
+    /// Port for spectators, 0 if disabled
+    uint16_t spectatorPort;
+    std::unique_ptr<GameServer> server;
+    /// Server of the last game while its spectators still receive the end of it
+    std::unique_ptr<GameServer> finishedServer;
+};
+
+MapType GetMapType(const bfs::path& mapPath)
+{
+    return (s25util::toLower(mapPath.extension().string()) == ".sav") ? MAPTYPE_SAVEGAME : MAPTYPE_OLDMAP;
+}
+
+bool StartGame(HostedGame& game, const std::string& hostPassword, std::chrono::milliseconds spectatorDelay)
+{
+    game.server = std::make_unique<GameServer>();
+    if(!game.server->Start(game.csi, game.mapPath, game.mapType, hostPassword))
+    {
+        LOG.write("Could not start game on port %1% with map %2%\n", LogTarget::FileAndStderr) % game.csi.port
+          % game.mapPath;
+        game.server.reset();
+        return false;
+    }
+    LOG.write("Hosting %1% on port %2%\n", LogTarget::FileAndStdout) % game.mapPath % game.csi.port;
+    // The game is still playable without spectators
+    if(game.spectatorPort && !game.server->StartSpectatorRelay(game.spectatorPort, spectatorDelay))
+        LOG.write("Could not listen for spectators on port %1%\n", LogTarget::FileAndStderr) % game.spectatorPort;
+    return true;
+}
+
+/// Run all games till a stop is requested or all games failed.
+/// Sleeps till a socket of any game is ready or the next GF of any game is due
+int RunServers(std::vector<HostedGame>& games, const std::string& hostPassword,
+               std::chrono::milliseconds spectatorDelay)
+{
+    // Watches the poller of each game, identified by the index of the game.
+    // Finished games still sending to their spectators use the index plus the number of games
+    SocketPoller poller;
+    const auto finishedId = [&games](unsigned idx) { return static_cast<unsigned>(games.size()) + idx; };
+    const auto startGame = [&](unsigned idx) {
+        if(StartGame(games[idx], hostPassword, spectatorDelay))
+            poller.AddPoller(games[idx].server->GetSocketPoller(), idx);
+    };
+    for(unsigned i = 0; i < games.size(); i++)
+        startGame(i);
+
+    while(!stopRequested)
+    {
+        if(std::none_of(games.begin(), games.end(), [](const HostedGame& game) { return game.server != nullptr; }))
+        {
+            LOG.write("No games left to host\n", LogTarget::FileAndStderr);
+            return 1;
+        }
+
+        std::chrono::milliseconds waitTime(1000);
+        for(const HostedGame& game : games)
+        {
+            if(game.server)
+                waitTime = std::min(waitTime, game.server->GetMaxWaitTime());
+            if(game.finishedServer)
+                waitTime = std::min(waitTime, game.finishedServer->GetMaxWaitTime());
+        }
+        // Returns early when any socket is ready. The events are handled by the servers themselves
+        poller.Wait(waitTime);
+
+        for(unsigned i = 0; i < games.size(); i++)
+        {
+            HostedGame& game = games[i];
+            if(game.finishedServer)
+            {
+                game.finishedServer->Run();
+                if(!game.finishedServer->IsFlushingSpectatorStream())
+                {
+                    poller.Remove(finishedId(i));
+                    game.finishedServer.reset();
+                }
+            }
+            if(!game.server)
+                continue;
+            game.server->Run();
+            // Game is over or all players left: Reopen the lobby with the same settings
+            if(!game.server->IsRunning())
+            {
+                poller.Remove(i);
+                if(game.server->IsFlushingSpectatorStream())
+                {
+                    if(game.finishedServer)
+                        poller.Remove(finishedId(i));
+                    game.finishedServer = std::move(game.server);
+                    poller.AddPoller(game.finishedServer->GetSocketPoller(), finishedId(i));
+                }
+                startGame(i);
+            }
+        }
+    }
+
+    poller.Clear();
+    for(HostedGame& game : games)
+    {
+        if(game.server)
+            game.server->Stop();
+        game.finishedServer.reset();
+    }
+    return 0;
+}
+
+bool InitLog()
+{
+    const bfs::path logDir = RTTRCONFIG.ExpandPath(s25::folders::logs);
+    boost::system::error_code ec;
+    bfs::create_directories(logDir, ec);
+    if(ec)
+    {
+        bnw::cerr << "Could not create log directory " << logDir << ": " << ec.message() << std::endl;
+        return false;
+    }
+    LOG.setLogFilepath(logDir);
+    try
+    {
+        LOG.open();
+    } catch(const std::exception& e)
+    {
+        bnw::cerr << "Error initializing log: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    bnw::args _(argc, argv);
+
+    po::options_description desc("Allowed options");
+    // clang-format off
+    desc.add_options()
+        ("help,h", "Show help")
+        ("map,m", po::value<std::vector<std::string>>()->multitoken(),
+            "Map or savegame to host. Can be given multiple times to host multiple games")
+        ("port,p", po::value<uint16_t>()->default_value(3665),
+            "Port of the first game, the others use the following ports")
+        ("name", po::value<std::string>()->default_value("Dedicated Server"), "Name of the games")
+        ("password", po::value<std::string>()->default_value(""), "Password required to join")
+        ("host-password", po::value<std::string>(),
+            "Password for the player who controls the game settings. Randomly generated if not given")
+        ("ipv6", "Use IPv6")
+        ("adaptive-nwf", "Adapt the network frame length to the pings of the players")
+        ("spectator-port", po::value<uint16_t>()->default_value(0),
+            "Port for spectators of the first game, the others use the following ports. 0 to disable spectators")
+        ("spectator-delay", po::value<unsigned>()->default_value(60),
+            "Seconds the game is shown delayed to spectators")
+        ;
+    // clang-format on
+    po::positional_options_description positionalOptions;
+    positionalOptions.add("map", -1);
+
+    po::variables_map options;
+    try
+    {
+        po::store(po::command_line_parser(argc, argv).options(desc).positional(positionalOptions).run(), options);
+    } catch(const po::error& e)
+    {
+        bnw::cerr << "Error: " << e.what() << "\n\n";
+        bnw::cerr << desc << "\n";
+        return 1;
+    }
+    po::notify(options);
+
+    if(options.count("help") || !options.count("map"))
+    {
+        bnw::cout << "Hosts games without graphics or sound. Players connect directly to the given ports.\n"
+                     "The player using the host password controls the game settings and starts the game.\n"
+                  << desc << "\n";
+        return options.count("help") ? 0 : 1;
+    }
+
+    if(!LocaleHelper::init())
+        return 1;
+    if(!RTTRCONFIG.Init())
+        return 1;
+    if(!InitLog())
+        return 1;
+    if(!Socket::Initialize())
+    {
+        bnw::cerr << "Could not init sockets!" << std::endl;
+        return 1;
+    }
+    // Needed for loading the map headers even if nothing is drawn
+    libsiedler2::setAllocator(new GlAllocator());
+
+    SETTINGS.server.adaptive_nwf = options.count("adaptive-nwf") > 0;
+    const std::string hostPassword =
+      options.count("host-password") ? options["host-password"].as<std::string>() : createRandString(20);
+    if(!options.count("host-password"))
+        bnw::cout << "Host password: " << hostPassword << std::endl;
+
+    std::vector<HostedGame> games;
+    auto port = options["port"].as<uint16_t>();
+    auto spectatorPort = options["spectator-port"].as<uint16_t>();
+    for(const std::string& mapPath : options["map"].as<std::vector<std::string>>())
+    {
+        // The lobby client and the LAN announcement exist only once, so games are only reachable directly
+        CreateServerInfo csi(ServerType::DIRECT, port++, options["name"].as<std::string>(),
+                             options["password"].as<std::string>(), options.count("ipv6") > 0);
+        games.emplace_back(std::move(csi), mapPath, GetMapType(mapPath), spectatorPort);
+        if(spectatorPort)
+            spectatorPort++;
+    }
+
+    std::signal(SIGINT, StopSignalHandler);
+    std::signal(SIGTERM, StopSignalHandler);
+
+    int result;
+    try
+    {
+        result = RunServers(games, hostPassword, std::chrono::seconds(options["spectator-delay"].as<unsigned>()));
+    } catch(const std::exception& e)
+    {
+        LOG.write("Error: %1%\n", LogTarget::FileAndStderr) % e.what();
+        result = 1;
+    }
+    games.clear();
+
+    Socket::Shutdown();
+    libsiedler2::setAllocator(nullptr);
+    return result;
+}
@@ -0,0 +1,402 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "AIGameRunner.h"
+#include "GlobalGameSettings.h"
+#include "RttrConfig.h"
+#include "ogl/glAllocator.h"
+#include "libsiedler2/libsiedler2.h"
+#include "s25util/LocaleHelper.h"
+#include <boost/algorithm/string/split.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/nowide/args.hpp>
+#include <boost/nowide/fstream.hpp>
+#include <boost/nowide/iostream.hpp>
+#include <boost/process.hpp>
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bfs = boost::filesystem;
+namespace bnw = boost::nowide;
+namespace bp = boost::process;
+namespace po = boost::program_options;
+
+namespace {
+enum TournamentExitCode
+{
+    RESULT_OK = 0,
+    RESULT_ERROR = 1
+};
+
+/// Settings shared by all games of the tournament
+struct TournamentConfig
+{
+    std::string aiLevels;
+    std::vector<AI::Info> players;
+    unsigned maxGF, statisticsInterval;
+    std::string objective;
+    bool randomStartPosition;
+};
+
+AI::Info ParseAI(const std::string& name)
+{
+    if(name == "dummy")
+        return AI::Info(AI::DUMMY);
+    if(name == "easy")
+        return AI::Info(AI::DEFAULT, AI::EASY);
+    if(name == "medium")
+        return AI::Info(AI::DEFAULT, AI::MEDIUM);
+    if(name == "hard")
+        return AI::Info(AI::DEFAULT, AI::HARD);
+    throw std::invalid_argument("Unknown AI: " + name);
+}
+
+GameObjective ParseObjective(const std::string& name)
+{
+    if(name == "none")
+        return GO_NONE;
+    if(name == "conquer")
+        return GO_CONQUER3_4;
+    if(name == "domination")
+        return GO_TOTALDOMINATION;
+    throw std::invalid_argument("Unknown objective: " + name);
+}
+
+/// Play a single game in this process and write the statistics of it to statisticsPath.
+/// Prints a line with the result parsed by RunTournament
+int RunGame(const bfs::path& mapPath, const TournamentConfig& config, const unsigned seed,
+            const bfs::path& statisticsPath)
+{
+    GlobalGameSettings ggs;
+    ggs.objective = ParseObjective(config.objective);
+    ggs.randomStartPosition = config.randomStartPosition;
+
+    AIGameRunner runner;
+    const auto loadStartTime = std::chrono::steady_clock::now();
+    if(!runner.Load(mapPath, config.players, seed, ggs))
+    {
+        bnw::cerr << "Error loading map " << mapPath << ": " << runner.GetLastErrorMsg() << std::endl;
+        return RESULT_ERROR;
+    }
+    const auto startTime = std::chrono::steady_clock::now();
+    bnw::cout << "Loaded " << mapPath << " in " << std::chrono::duration<double>(startTime - loadStartTime).count()
+              << "s. Seed: " << seed << std::endl;
+    const unsigned numGFs = runner.Run(config.maxGF, config.statisticsInterval);
+    const double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    bnw::ofstream file(statisticsPath);
+    file << "gf,player,defeated,country,military,productivity,vanquished\n";
+    for(const AIGameRunner::Sample& sample : runner.GetSamples())
+    {
+        file << sample.gf << "," << unsigned(sample.playerId) << "," << sample.isDefeated << "," << sample.country
+             << "," << sample.military << "," << sample.productivity << "," << sample.vanquished << "\n";
+    }
+    if(!file)
+    {
+        bnw::cerr << "Could not write statistics to " << statisticsPath << std::endl;
+        return RESULT_ERROR;
+    }
+
+    // Parsed by RunGameProcess, keep the format
+    bnw::cout << "Result " << numGFs << " " << duration << " " << runner.GetWinnerMask() << " " << runner.IsFinished()
+              << std::endl;
+    return RESULT_OK;
+}
+
+struct GameResult
+{
+    bfs::path mapPath;
+    unsigned seed;
+    int exitCode = RESULT_ERROR;
+    unsigned numGFs = 0;
+    double duration = 0;
+    unsigned winnerMask = 0;
+    bool isFinished = false;
+    std::string output;
+};
+
+/// Run a game in a new process of this program and collect its output.
+/// A process is required as the game uses global state
+void RunGameProcess(const bfs::path& programPath, const TournamentConfig& config, const bfs::path& statisticsPath,
+                    GameResult& result)
+{
+    std::vector<std::string> args{result.mapPath.string(),
+                                  "--ai",
+                                  config.aiLevels,
+                                  "--gf",
+                                  std::to_string(config.maxGF),
+                                  "--stats-interval",
+                                  std::to_string(config.statisticsInterval),
+                                  "--objective",
+                                  config.objective,
+                                  "--seed",
+                                  std::to_string(result.seed),
+                                  "--run",
+                                  statisticsPath.string()};
+    if(config.randomStartPosition)
+        args.push_back("--random-start");
+
+    try
+    {
+        bp::ipstream output;
+        bp::child process(programPath, args, (bp::std_out & bp::std_err) > output);
+        std::string line;
+        while(std::getline(output, line))
+        {
+            std::istringstream lineStream(line);
+            std::string word;
+            if(lineStream >> word && word == "Result")
+                lineStream >> result.numGFs >> result.duration >> result.winnerMask >> result.isFinished;
+            result.output += line + '\n';
+        }
+        process.wait();
+        result.exitCode = process.exit_code();
+    } catch(const std::exception& e)
+    {
+        result.output += std::string("Failed to run game: ") + e.what() + '\n';
+    }
+}
+
+std::string FormatWinners(unsigned winnerMask)
+{
+    std::string result;
+    for(unsigned i = 0; winnerMask; i++, winnerMask >>= 1)
+    {
+        if(!(winnerMask & 1))
+            continue;
+        if(!result.empty())
+            result += ";";
+        result += std::to_string(i);
+    }
+    return result;
+}
+
+/// Write the per game results, the merged statistics and the win rates to the output directory
+bool WriteResults(const bfs::path& outputDir, const TournamentConfig& config, const std::vector<GameResult>& results)
+{
+    bnw::ofstream gamesFile(outputDir / "games.csv");
+    gamesFile << "game,map,seed,status,gfs,seconds,gfPerSecond,finished,winners\n" << std::fixed;
+    bnw::ofstream statisticsFile(outputDir / "statistics.csv");
+    statisticsFile << "game,gf,player,defeated,country,military,productivity,vanquished\n";
+    std::vector<unsigned> numWins(config.players.size());
+    unsigned numValidGames = 0;
+    for(unsigned i = 0; i < results.size(); i++)
+    {
+        const GameResult& result = results[i];
+        const bool isValid = result.exitCode == RESULT_OK;
+        gamesFile << i << "," << result.mapPath.filename().string() << "," << result.seed << ","
+                  << (isValid ? "OK" : "ERROR") << "," << result.numGFs << "," << std::setprecision(3)
+                  << result.duration << "," << std::setprecision(1)
+                  << (result.duration > 0 ? result.numGFs / result.duration : 0.) << "," << result.isFinished << ","
+                  << FormatWinners(result.winnerMask) << "\n";
+        if(!isValid)
+            continue;
+        numValidGames++;
+        for(unsigned player = 0; player < numWins.size(); player++)
+        {
+            if(result.winnerMask & (1u << player))
+                numWins[player]++;
+        }
+
+        const bfs::path gameStatisticsPath = outputDir / ("game" + std::to_string(i) + ".csv");
+        bnw::ifstream gameStatistics(gameStatisticsPath);
+        std::string line;
+        // Skip the header
+        std::getline(gameStatistics, line);
+        while(std::getline(gameStatistics, line))
+            statisticsFile << i << "," << line << "\n";
+        gameStatistics.close();
+        boost::system::error_code ec;
+        bfs::remove(gameStatisticsPath, ec);
+    }
+
+    std::vector<std::string> aiNames;
+    boost::split(aiNames, config.aiLevels, [](char c) { return c == ','; });
+    bnw::ofstream winRatesFile(outputDir / "winrates.csv");
+    winRatesFile << "player,ai,games,wins,winRate\n" << std::fixed << std::setprecision(3);
+    for(unsigned player = 0; player < numWins.size(); player++)
+    {
+        winRatesFile << player << "," << aiNames[player] << "," << numValidGames << "," << numWins[player] << ","
+                     << (numValidGames ? static_cast<double>(numWins[player]) / numValidGames : 0.) << "\n";
+        bnw::cout << "Player " << player << " (" << aiNames[player] << "): " << numWins[player] << "/"
+                  << numValidGames << " wins" << std::endl;
+    }
+    return gamesFile && statisticsFile && winRatesFile;
+}
+
+/// Play each map numGames times in parallel, each game with its own seed
+int RunTournament(const bfs::path& programPath, const std::vector<bfs::path>& maps, const TournamentConfig& config,
+                  const unsigned numGames, const unsigned baseSeed, unsigned numJobs, const bfs::path& outputDir)
+{
+    std::vector<GameResult> results;
+    for(const bfs::path& mapPath : maps)
+    {
+        for(unsigned i = 0; i < numGames; i++)
+        {
+            GameResult result;
+            result.mapPath = bfs::absolute(mapPath);
+            // Each game gets a different but reproducible seed
+            result.seed = baseSeed + static_cast<unsigned>(results.size());
+            results.push_back(result);
+        }
+    }
+    numJobs = std::max(1u, std::min<unsigned>(numJobs, results.size()));
+    bfs::create_directories(outputDir);
+    bnw::cout << "Playing " << results.size() << " games using " << numJobs << " processes" << std::endl;
+
+    std::atomic<size_t> nextGame(0);
+    std::mutex outputMutex;
+    const auto startTime = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for(unsigned i = 0; i < numJobs; i++)
+    {
+        workers.emplace_back([&]() {
+            for(size_t idx = nextGame++; idx < results.size(); idx = nextGame++)
+            {
+                GameResult& result = results[idx];
+                RunGameProcess(programPath, config, outputDir / ("game" + std::to_string(idx) + ".csv"), result);
+
+                std::lock_guard<std::mutex> lock(outputMutex);
+                bnw::cout << "[" << (result.exitCode == RESULT_OK ? "OK" : "ERROR") << "] Game " << idx << " on "
+                          << result.mapPath.filename().string() << " (seed " << result.seed << "): " << result.numGFs
+                          << " GFs, winners: " << FormatWinners(result.winnerMask) << std::endl;
+                if(result.exitCode != RESULT_OK)
+                    bnw::cout << result.output;
+            }
+        });
+    }
+    for(std::thread& worker : workers)
+        worker.join();
+
+    const double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    bnw::cout << "\nPlayed " << results.size() << " games in " << duration << "s" << std::endl;
+    if(!WriteResults(outputDir, config, results))
+    {
+        bnw::cerr << "Could not write the results to " << outputDir << std::endl;
+        return RESULT_ERROR;
+    }
+    bnw::cout << "Results written to " << outputDir << std::endl;
+    const bool anyFailed = std::any_of(results.begin(), results.end(),
+                                       [](const GameResult& result) { return result.exitCode != RESULT_OK; });
+    return anyFailed ? RESULT_ERROR : RESULT_OK;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    bnw::args _(argc, argv);
+
+    po::options_description desc("Allowed options");
+    // clang-format off
+    desc.add_options()
+        ("help,h", "Show help")
+        ("map,m", po::value<std::vector<std::string>>(), "Maps to play on")
+        ("ai", po::value<std::string>()->default_value("hard,hard"),
+            "Comma separated AIs of the players (dummy, easy, medium, hard)")
+        ("gf", po::value<unsigned>()->default_value(100000), "Maximum number of GFs per game")
+        ("stats-interval", po::value<unsigned>()->default_value(1000), "Number of GFs between statistic samples")
+        ("objective", po::value<std::string>()->default_value("conquer"),
+            "Objective of the games (none, conquer, domination). Without a winner the largest country wins")
+        ("random-start", "Randomize the start positions")
+        ("games,n", po::value<unsigned>()->default_value(1), "Number of games per map")
+        ("seed", po::value<unsigned>()->default_value(1), "Seed of the first game. Each further game uses the next one")
+        ("jobs,j", po::value<unsigned>()->default_value(std::max(1u, std::thread::hardware_concurrency())),
+            "Number of games played in parallel")
+        ("output,o", po::value<std::string>()->default_value("."),
+            "Directory for games.csv, statistics.csv and winrates.csv")
+        ("run", po::value<std::string>(),
+            "Play only one game on the first map with the given seed in this process and write its statistics to the "
+            "given file (e.g. to reproduce a game of a tournament)")
+        ;
+    // clang-format on
+    po::positional_options_description positionalOptions;
+    positionalOptions.add("map", -1);
+
+    po::variables_map options;
+    try
+    {
+        po::store(po::command_line_parser(argc, argv).options(desc).positional(positionalOptions).run(), options);
+    } catch(const po::error& e)
+    {
+        bnw::cerr << "Error: " << e.what() << "\n\n";
+        bnw::cerr << desc << "\n";
+        return RESULT_ERROR;
+    }
+    po::notify(options);
+
+    if(options.count("help") || !options.count("map"))
+    {
+        bnw::cout << "Plays games of AIs against each other without graphics as fast as possible.\n"
+                     "The games are played in parallel and the results of all games are written as CSV.\n"
+                  << desc << "\n";
+        return options.count("help") ? RESULT_OK : RESULT_ERROR;
+    }
+
+    try
+    {
+        TournamentConfig config;
+        config.aiLevels = options["ai"].as<std::string>();
+        std::vector<std::string> aiNames;
+        boost::split(aiNames, config.aiLevels, [](char c) { return c == ','; });
+        for(const std::string& aiName : aiNames)
+            config.players.push_back(ParseAI(aiName));
+        config.maxGF = options["gf"].as<unsigned>();
+        config.statisticsInterval = options["stats-interval"].as<unsigned>();
+        config.objective = options["objective"].as<std::string>();
+        ParseObjective(config.objective);
+        config.randomStartPosition = options.count("random-start") > 0;
+
+        std::vector<bfs::path> maps;
+        for(const std::string& map : options["map"].as<std::vector<std::string>>())
+            maps.push_back(map);
+        const unsigned seed = options["seed"].as<unsigned>();
+
+        if(!options.count("run"))
+        {
+            bfs::path programPath = argv[0];
+            if(!programPath.has_parent_path())
+                programPath = bp::search_path(programPath);
+            return RunTournament(bfs::absolute(programPath), maps, config, options["games"].as<unsigned>(), seed,
+                                 options["jobs"].as<unsigned>(), options["output"].as<std::string>());
+        }
+
+        if(!LocaleHelper::init())
+            return RESULT_ERROR;
+        if(!RTTRCONFIG.Init())
+            return RESULT_ERROR;
+        // Needed for loading the maps even if nothing is drawn
+        libsiedler2::setAllocator(new GlAllocator());
+        const int result = RunGame(maps.front(), config, seed, options["run"].as<std::string>());
+        libsiedler2::setAllocator(nullptr);
+        return result;
+    } catch(const std::exception& e)
+    {
+        bnw::cerr << "Error: " << e.what() << std::endl;
+        return RESULT_ERROR;
+    }
+}
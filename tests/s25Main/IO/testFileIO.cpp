@@ -15,13 +15,18 @@
 // You should have received a copy of the GNU General Public License
 // along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
 
+#include "FileChecksum.h"
 #include "ListDir.h"
+#include "gameTypes/CompressedData.h"
+#include "rttr/test/TmpFolder.hpp"
 #include <s25util/utf8.h>
 #include <boost/filesystem.hpp>
 #include <boost/iostreams/device/mapped_file.hpp>
 #include <boost/iostreams/stream.hpp>
 #include <boost/nowide/fstream.hpp>
 #include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <vector>
 
 namespace bfs = boost::filesystem;
 namespace bnw = boost::nowide;
@@ -98,4 +103,45 @@ BOOST_FIXTURE_TEST_CASE(TestListDir, FileOpenFixture)
     }
 }
 
+BOOST_AUTO_TEST_CASE(StreamingDecompressionMatchesDecompression)
+{
+    rttr::test::TmpFolder tmpFolder;
+    std::vector<char> uncompressed(300 * 1000);
+    for(unsigned i = 0; i < uncompressed.size(); i++)
+        uncompressed[i] = static_cast<char>((i * 7919u) % 251u + (i / 1000u));
+    CompressedData compressed;
+    BOOST_TEST_REQUIRE(compressed.CompressFromBuffer(uncompressed.data(), uncompressed.size()));
+    const bfs::path expectedFilePath = tmpFolder.get() / "expected.dat";
+    unsigned expectedChecksum;
+    BOOST_TEST_REQUIRE(compressed.DecompressToFile(expectedFilePath, &expectedChecksum));
+    BOOST_TEST(expectedChecksum == CalcChecksumOfBuffer(uncompressed.data(), uncompressed.size()));
+
+    const bfs::path filePath = tmpFolder.get() / "streamed.dat";
+    StreamingDecompressor decompressor;
+    BOOST_TEST_REQUIRE(decompressor.Start(filePath, compressed.length));
+    // Use an odd part size so the parts don't line up with the blocks
+    constexpr unsigned partSize = 999;
+    for(unsigned pos = 0; pos < compressed.data.size(); pos += partSize)
+    {
+        const auto curPartSize = std::min<unsigned>(partSize, compressed.data.size() - pos);
+        BOOST_TEST_REQUIRE(decompressor.Add(&compressed.data[pos], curPartSize));
+        BOOST_TEST(decompressor.GetNumCompressedBytes() == pos + curPartSize);
+    }
+    unsigned checksum = 0;
+    BOOST_TEST_REQUIRE(decompressor.Finish(&checksum));
+    BOOST_TEST(!decompressor.IsActive());
+    BOOST_TEST(checksum == expectedChecksum);
+    BOOST_TEST(CalcChecksumOfFile(filePath) == expectedChecksum);
+    BOOST_TEST(bfs::file_size(filePath) == uncompressed.size());
+
+    // Incomplete data is detected
+    BOOST_TEST_REQUIRE(decompressor.Start(filePath, compressed.length));
+    BOOST_TEST_REQUIRE(decompressor.Add(compressed.data.data(), compressed.data.size() / 2));
+    BOOST_TEST(!decompressor.Finish());
+    // So is a wrong length
+    BOOST_TEST_REQUIRE(decompressor.Start(filePath, compressed.length - 1));
+    BOOST_TEST(!decompressor.Add(compressed.data.data(), compressed.data.size()));
+    BOOST_TEST(!decompressor.IsActive());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,33 @@
+// Copyright (c) 2016 - 2017 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "Benchmark.h"
+#include <boost/format.hpp>
+#include <iostream>
+
+namespace rttr { namespace bench {
+    void printResult(const Result& result)
+    {
+        const auto toNsPerOp = [&result](std::chrono::nanoseconds duration) {
+            return static_cast<double>(duration.count()) / result.numOps;
+        };
+        std::cout << boost::format("%1$-40s %2$10u ops %3$14.1f ns/op (min %4$14.1f) checksum %5$016x\n") % result.name
+                       % result.numOps % toNsPerOp(result.median) % toNsPerOp(result.min) % result.checksum
+                  << std::flush;
+    }
+}} // namespace rttr::bench
@@ -0,0 +1,80 @@
+// Copyright (c) 2016 - 2017 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rttr { namespace bench {
+    /// Number of timed runs of each benchmark. They are preceded by an untimed warm-up run
+    constexpr unsigned NUM_RUNS = 11;
+
+    struct Result
+    {
+        std::string name;
+        /// Number of operations done per run
+        unsigned numOps;
+        /// Median and minimum time of a run
+        std::chrono::nanoseconds median, min;
+        /// Value computed from the results of the operations. Must be the same for all runs and only changes if the
+        /// benchmarked code behaves differently, so timings with different checksums are not comparable
+        uint64_t checksum;
+    };
+
+    /// Print the result as a line of a table with fixed column widths
+    void printResult(const Result& result);
+
+    /// Run the benchmark: Call setup (not timed) and then runOps which does numOps operations and returns a checksum
+    template<class T_Setup, class T_RunOps>
+    Result run(const std::string& name, unsigned numOps, T_Setup&& setup, T_RunOps&& runOps)
+    {
+        using Clock = std::chrono::steady_clock;
+        Result result{name, numOps, {}, {}, 0};
+        std::vector<std::chrono::nanoseconds> durations;
+        for(unsigned i = 0; i <= NUM_RUNS; i++)
+        {
+            setup();
+            const Clock::time_point startTime = Clock::now();
+            const uint64_t checksum = runOps();
+            const Clock::time_point endTime = Clock::now();
+            if(i == 0)
+                result.checksum = checksum;
+            else
+            {
+                BOOST_CHECK_MESSAGE(checksum == result.checksum, name << " is not deterministic");
+                durations.push_back(endTime - startTime);
+            }
+        }
+        std::sort(durations.begin(), durations.end());
+        result.median = durations[durations.size() / 2];
+        result.min = durations.front();
+        printResult(result);
+        return result;
+    }
+
+    template<class T_RunOps>
+    Result run(const std::string& name, unsigned numOps, T_RunOps&& runOps)
+    {
+        return run(name, numOps, []() {}, std::forward<T_RunOps>(runOps));
+    }
+}} // namespace rttr::bench
@@ -0,0 +1,116 @@
+// Copyright (c) 2016 - 2017 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "Benchmark.h"
+#include "EventManager.h"
+#include "GameObject.h"
+#include <boost/test/unit_test.hpp>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+constexpr unsigned NUM_EVENTS = 100000;
+/// Events are spread over this many GFs, similar to a running game
+constexpr unsigned MAX_EVENT_LENGTH = 1000;
+
+class BenchEventHandler : public GameObject
+{
+public:
+    uint64_t handledIdSum = 0;
+
+    void HandleEvent(unsigned evId) override { handledIdSum += evId; }
+    void Destroy() override {}
+    void Serialize(SerializedGameData&) const override {}
+    GO_Type GetGOT() const override { return GOT_UNKNOWN; }
+};
+
+/// Fixed pseudo-random event lengths. mt19937 (unlike the distributions) gives the same values everywhere
+std::vector<unsigned> getEventLengths()
+{
+    std::mt19937 rng(0x1337);
+    std::vector<unsigned> lengths(NUM_EVENTS);
+    for(unsigned& length : lengths)
+        length = rng() % MAX_EVENT_LENGTH + 1;
+    return lengths;
+}
+
+struct EventFixture
+{
+    const std::vector<unsigned> lengths = getEventLengths();
+    BenchEventHandler obj;
+    std::unique_ptr<EventManager> em;
+    std::vector<const GameEvent*> events;
+
+    /// Create a new event manager with all events added
+    void addAllEvents()
+    {
+        em = std::make_unique<EventManager>(0);
+        events.clear();
+        for(unsigned i = 0; i < NUM_EVENTS; i++)
+            events.push_back(em->AddEvent(&obj, lengths[i], i % 16));
+    }
+};
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(Events, EventFixture)
+
+BOOST_AUTO_TEST_CASE(AddEvents)
+{
+    rttr::bench::run(
+      "EventManager::AddEvent", NUM_EVENTS, [this]() { em = std::make_unique<EventManager>(0); },
+      [this]() {
+          for(unsigned i = 0; i < NUM_EVENTS; i++)
+              em->AddEvent(&obj, lengths[i], i % 16);
+          return em->GetNumActiveEvents();
+      });
+}
+
+BOOST_AUTO_TEST_CASE(RemoveEvents)
+{
+    // Remove in a fixed but mixed order, not the order of insertion
+    std::vector<unsigned> order(NUM_EVENTS);
+    std::mt19937 rng(42);
+    for(unsigned i = 0; i < NUM_EVENTS; i++)
+        order[i] = i;
+    for(unsigned i = NUM_EVENTS - 1; i > 0; i--)
+        std::swap(order[i], order[rng() % (i + 1)]);
+    rttr::bench::run("EventManager::RemoveEvent", NUM_EVENTS, [this]() { addAllEvents(); },
+                     [this, &order]() {
+                         for(unsigned idx : order)
+                             em->RemoveEvent(events[idx]);
+                         return em->GetNumActiveEvents();
+                     });
+}
+
+BOOST_AUTO_TEST_CASE(ExecuteEvents)
+{
+    rttr::bench::run(
+      "EventManager::ExecuteNextGF", NUM_EVENTS,
+      [this]() {
+          addAllEvents();
+          obj.handledIdSum = 0;
+      },
+      [this]() {
+          for(unsigned gf = 0; gf < MAX_EVENT_LENGTH; gf++)
+              em->ExecuteNextGF();
+          return obj.handledIdSum;
+      });
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,65 @@
+// Copyright (c) 2016 - 2017 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "Benchmark.h"
+#include "notifications/NodeNote.h"
+#include "notifications/NotificationManager.h"
+#include "random/Random.h"
+#include <boost/test/unit_test.hpp>
+#include <vector>
+
+namespace {
+constexpr unsigned NUM_RANDS = 1000000;
+constexpr unsigned NUM_NOTES = 1000000;
+constexpr unsigned NUM_SUBSCRIBERS = 8;
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(Misc)
+
+BOOST_AUTO_TEST_CASE(RandomRand)
+{
+    rttr::bench::run(
+      "Random::Rand", NUM_RANDS, []() { RANDOM.Init(0x1337); },
+      []() {
+          uint64_t sum = 0;
+          for(unsigned i = 0; i < NUM_RANDS; i++)
+              sum += RANDOM_RAND(i, 1000);
+          return sum;
+      });
+}
+
+BOOST_AUTO_TEST_CASE(PublishNotifications)
+{
+    NotificationManager notifications;
+    uint64_t checksum = 0;
+    std::vector<Subscription> subscriptions;
+    for(unsigned i = 0; i < NUM_SUBSCRIBERS; i++)
+    {
+        subscriptions.push_back(notifications.subscribe<NodeNote>(
+          [&checksum](const NodeNote& note) { checksum += note.pos.x + note.pos.y * 64u; }));
+    }
+    rttr::bench::run(
+      "NotificationManager::publish", NUM_NOTES, [&checksum]() { checksum = 0; },
+      [&]() {
+          for(unsigned i = 0; i < NUM_NOTES; i++)
+              notifications.publish(NodeNote(NodeNote::BQ, MapPoint(i % 64, i / 64 % 64)));
+          return checksum;
+      });
+}
+
+BOOST_AUTO_TEST_SUITE_END()
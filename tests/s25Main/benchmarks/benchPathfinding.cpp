@@ -0,0 +1,111 @@
+// Copyright (c) 2016 - 2017 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "Benchmark.h"
+#include "nodeObjs/noFlag.h"
+#include "worldFixtures/CreateEmptyWorld.h"
+#include "worldFixtures/WorldFixture.h"
+#include "worldFixtures/WorldWithGCExecution.h"
+#include "gameTypes/RoadPathDirection.h"
+#include <boost/test/unit_test.hpp>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr unsigned NUM_FREE_PATHS = 1000;
+
+using EmptyWorldFixture = WorldFixture<CreateEmptyWorld, 0, 64, 64>;
+
+/// World with a grid of flags around the HQ, connected by roads
+struct RoadNetworkFixture : public WorldWithGCExecution<1, 32, 32>
+{
+    std::vector<const noFlag*> flags;
+
+    RoadNetworkFixture()
+    {
+        const MapPoint hqFlagPos = world.GetNeighbour(hqPos, Direction::SOUTHEAST);
+        std::vector<MapPoint> gridPts;
+        for(int dy = -6; dy <= 6; dy += 2)
+        {
+            for(int dx = -6; dx <= 6; dx += 2)
+                gridPts.push_back(world.MakeMapPoint(hqFlagPos + Position(dx, dy)));
+        }
+        // Points occupied by the HQ are just skipped
+        for(const MapPoint& pt : gridPts)
+            world.SetFlag(pt, curPlayer);
+        for(const MapPoint& pt : gridPts)
+        {
+            if(!world.GetSpecObj<noFlag>(pt))
+                continue;
+            world.BuildRoad(curPlayer, false, pt, {Direction::EAST, Direction::EAST});
+            world.BuildRoad(curPlayer, false, pt, {Direction::SOUTHEAST, Direction::SOUTHWEST});
+        }
+        for(const MapPoint& pt : gridPts)
+        {
+            if(world.GetSpecObj<noFlag>(pt))
+                flags.push_back(world.GetSpecObj<noFlag>(pt));
+        }
+        BOOST_TEST_REQUIRE(flags.size() > 40u);
+    }
+};
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(Pathfinding)
+
+BOOST_FIXTURE_TEST_CASE(FreePathFinder, EmptyWorldFixture)
+{
+    std::mt19937 rng(42);
+    std::vector<std::pair<MapPoint, MapPoint>> queries;
+    for(unsigned i = 0; i < NUM_FREE_PATHS; i++)
+    {
+        const MapPoint start(rng() % world.GetWidth(), rng() % world.GetHeight());
+        const MapPoint dest(rng() % world.GetWidth(), rng() % world.GetHeight());
+        queries.emplace_back(start, dest);
+    }
+    rttr::bench::run("FreePathFinder::FindHumanPath", NUM_FREE_PATHS, [this, &queries]() {
+        uint64_t lengthSum = 0;
+        for(const auto& query : queries)
+        {
+            unsigned length;
+            if(world.FindHumanPath(query.first, query.second, 0xFFFFFFFF, false, &length))
+                lengthSum += length;
+        }
+        return lengthSum;
+    });
+}
+
+BOOST_FIXTURE_TEST_CASE(RoadPathFinder, RoadNetworkFixture)
+{
+    const auto numQueries = static_cast<unsigned>(flags.size() * (flags.size() - 1));
+    rttr::bench::run("RoadPathFinder::FindPathForWareOnRoads", numQueries, [this]() {
+        uint64_t lengthSum = 0;
+        for(const noFlag* start : flags)
+        {
+            for(const noFlag* goal : flags)
+            {
+                unsigned length;
+                if(start != goal && world.FindPathForWareOnRoads(*start, *goal, &length) != RoadPathDirection::None)
+                    lengthSum += length;
+            }
+        }
+        return lengthSum;
+    });
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,108 @@
+// Copyright (c) 2016 - 2017 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "Benchmark.h"
+#include "Game.h"
+#include "GamePlayer.h"
+#include "PlayerInfo.h"
+#include "RttrForeachPt.h"
+#include "SerializedGameData.h"
+#include "buildings/noBaseBuilding.h"
+#include "worldFixtures/CreateEmptyWorld.h"
+#include "worldFixtures/MockLocalGameState.h"
+#include "worldFixtures/TestEventManager.h"
+#include "worldFixtures/WorldFixture.h"
+#include "world/GameWorld.h"
+#include <boost/test/unit_test.hpp>
+#include <memory>
+#include <vector>
+
+namespace {
+constexpr unsigned RADIUS = 5;
+constexpr unsigned NUM_TERRITORY_RECALCS = 25;
+
+using EmptyWorldFixture = WorldFixture<CreateEmptyWorld, 0, 64, 64>;
+using PlayerWorldFixture = WorldFixture<CreateEmptyWorld, 4, 64, 64>;
+
+uint64_t getOwnerChecksum(const GameWorld& world)
+{
+    uint64_t checksum = 0;
+    RTTR_FOREACH_PT(MapPoint, world.GetSize())
+        checksum = checksum * 31 + world.GetNode(pt).owner;
+    return checksum;
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(Map)
+
+BOOST_FIXTURE_TEST_CASE(PointsInRadius, EmptyWorldFixture)
+{
+    rttr::bench::run("MapBase::GetPointsInRadius", prodOfComponents(world.GetSize()), [this]() {
+        uint64_t numPts = 0;
+        RTTR_FOREACH_PT(MapPoint, world.GetSize())
+            numPts += world.GetPointsInRadius(pt, RADIUS).size();
+        return numPts;
+    });
+}
+
+BOOST_FIXTURE_TEST_CASE(RecalcTerritory, PlayerWorldFixture)
+{
+    std::vector<const noBaseBuilding*> hqs;
+    for(unsigned i = 0; i < world.GetNumPlayers(); i++)
+        hqs.push_back(world.GetSpecObj<noBaseBuilding>(world.GetPlayer(i).GetHQPos()));
+    rttr::bench::run("GameWorldGame::RecalcTerritory", NUM_TERRITORY_RECALCS * world.GetNumPlayers(), [this, &hqs]() {
+        for(unsigned i = 0; i < NUM_TERRITORY_RECALCS; i++)
+        {
+            for(const noBaseBuilding* hq : hqs)
+                world.RecalcTerritory(*hq, TerritoryChangeReason::Build);
+        }
+        return getOwnerChecksum(world);
+    });
+}
+
+BOOST_FIXTURE_TEST_CASE(SaveSnapshot, PlayerWorldFixture)
+{
+    SerializedGameData sgd;
+    rttr::bench::run("SerializedGameData::MakeSnapshot", 1, [this, &sgd]() {
+        sgd.MakeSnapshot(game);
+        return sgd.GetLength();
+    });
+}
+
+BOOST_FIXTURE_TEST_CASE(LoadSnapshot, PlayerWorldFixture)
+{
+    SerializedGameData sgd;
+    sgd.MakeSnapshot(game);
+    std::vector<PlayerInfo> players;
+    for(unsigned i = 0; i < world.GetNumPlayers(); i++)
+        players.push_back(PlayerInfo(world.GetPlayer(i)));
+    const GlobalGameSettings settings = ggs;
+    // Loading checks the global object count so only the loaded game may exist
+    game.reset();
+    MockLocalGameState localGameState;
+    std::shared_ptr<Game> loadedGame;
+    rttr::bench::run(
+      "SerializedGameData::ReadSnapshot", 1, [&loadedGame]() { loadedGame.reset(); },
+      [&]() {
+          loadedGame = std::make_shared<Game>(settings, std::make_unique<TestEventManager>(), players);
+          sgd.ReadSnapshot(loadedGame, localGameState);
+          return getOwnerChecksum(loadedGame->world_) + loadedGame->em_->GetNumActiveEvents();
+      });
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,37 @@
+// Copyright (c) 2016 - 2017 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+
+#define BOOST_TEST_MODULE RTTR_Benchmarks
+
+#include "Benchmark.h"
+#include <rttr/test/Fixture.hpp>
+#include <boost/test/unit_test.hpp>
+#include <iostream>
+
+struct Fixture : rttr::test::Fixture
+{
+    Fixture()
+    {
+#ifndef NDEBUG
+        std::cout << "Warning: Benchmarks of a debug build are not representative\n";
+#endif
+        std::cout << "Median of " << rttr::bench::NUM_RUNS << " runs per benchmark\n";
+    }
+};
+
+BOOST_GLOBAL_FIXTURE(Fixture);
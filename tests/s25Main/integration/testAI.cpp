@@ -17,8 +17,14 @@
 
 #include "PointOutput.h"
 #include "RttrForeachPt.h"
+#include "ai/AIEventManager.h"
+#include "ai/AIInterface.h"
 #include "ai/AIPlayer.h"
+#include "ai/aijh/AIKnowledge.h"
 #include "ai/aijh/AIPlayerJH.h"
+#include "ai/aijh/AIReachability.h"
+#include "ai/aijh/AIResourceMap.h"
+#include "ai/aijh/TaskScheduler.h"
 #include "buildings/noBuilding.h"
 #include "buildings/noBuildingSite.h"
 #include "buildings/nobBaseWarehouse.h"
@@ -26,16 +32,23 @@
 #include "factories/AIFactory.h"
 #include "factories/BuildingFactory.h"
 #include "notifications/NodeNote.h"
+#include "random/Random.h"
 #include "worldFixtures/WorldWithGCExecution.h"
 #include "nodeObjs/noFlag.h"
 #include "nodeObjs/noTree.h"
 #include "gameData/BuildingProperties.h"
+#include <rttr/test/random.hpp>
 #include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <array>
 #include <memory>
+#include <numeric>
 #include <set>
+#include <string>
 
 // We need border land
 using BiggerWorldWithGCExecution = WorldWithGCExecution<1, 24, 22>;
+using BigWorldWithGCExecution = WorldWithGCExecution<1, 64, 64>;
 
 template<class T_Col>
 inline bool containsBldType(const T_Col& collection, BuildingType type)
@@ -301,4 +314,361 @@ BOOST_FIXTURE_TEST_CASE(ExpandWhenNoSpace, BiggerWorldWithGCExecution)
     BOOST_REQUIRE(containsBldType(bldSites, BLD_BARRACKS) || containsBldType(bldSites, BLD_GUARDHOUSE));
 }
 
+namespace {
+/// Check that initializing the resource maps gives the same values as adding the rating of every node one by one
+void checkResourceMapsMatchChange(const GameWorldBase& world)
+{
+    std::vector<gc::GameCommandPtr> gcs;
+    const AIInterface aii(world, gcs, 0);
+    AIJH::AIMap aiMap;
+    aiMap.Resize(world.GetSize());
+    NodeMapBase<AIResource> resources;
+    resources.Resize(world.GetSize());
+    const std::array<AIResource, 4> nodeResources = {
+      {AIResource::WOOD, AIResource::PLANTSPACE, AIResource::FISH, AIResource::NOTHING}};
+    RTTR_FOREACH_PT(MapPoint, world.GetSize())
+        resources[pt] = nodeResources[rttr::test::randomValue<unsigned>(0, nodeResources.size() - 1)];
+
+    for(unsigned i = 0; i < NUM_AIRESOURCES; i++)
+    {
+        const auto res = static_cast<AIResource>(i);
+        AIJH::AIResourceMap resMap(res, aii, aiMap, resources);
+        resMap.Init();
+        AIJH::AIResourceMap expectedMap(res, aii, aiMap, resources);
+        expectedMap.Init();
+        RTTR_FOREACH_PT(MapPoint, world.GetSize())
+            expectedMap[pt] = 0;
+        RTTR_FOREACH_PT(MapPoint, world.GetSize())
+        {
+            if(res == AIResource::BORDERLAND ? aii.IsBorder(pt) : resources[pt] == res)
+                expectedMap.Change(pt, 1);
+        }
+        RTTR_FOREACH_PT(MapPoint, world.GetSize())
+        {
+            BOOST_TEST_INFO("Resource " << i << " at " << pt);
+            BOOST_TEST_REQUIRE(resMap[pt] == expectedMap[pt]);
+        }
+    }
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_CASE(ResourceMapInit, BiggerWorldWithGCExecution)
+{
+    checkResourceMapsMatchChange(world);
+}
+
+// Smaller than the rating radius of some resources, so points are rated multiple times by the same node
+BOOST_FIXTURE_TEST_CASE(ResourceMapInitSmallWorld, WorldWithGCExecution<1>)
+{
+    checkResourceMapsMatchChange(world);
+}
+
+BOOST_FIXTURE_TEST_CASE(ResourceMapFindPosition, BigWorldWithGCExecution)
+{
+    std::vector<gc::GameCommandPtr> gcs;
+    const AIInterface aii(world, gcs, 0);
+    AIJH::AIMap aiMap;
+    aiMap.Resize(world.GetSize());
+    RTTR_FOREACH_PT(MapPoint, world.GetSize())
+    {
+        aiMap[pt].bq = aii.GetBuildingQuality(pt);
+        aiMap[pt].reachable = rttr::test::randomValue(0, 3) != 0;
+        aiMap[pt].owned = rttr::test::randomValue(0, 3) != 0;
+        aiMap[pt].farmed = rttr::test::randomValue(0, 5) == 0;
+    }
+    NodeMapBase<AIResource> resources;
+    resources.Resize(world.GetSize());
+    AIJH::AIResourceMap resMap(AIResource::WOOD, aii, aiMap, resources);
+    resMap.Init();
+    // Few distinct values so there are many points with the same value
+    RTTR_FOREACH_PT(MapPoint, world.GetSize())
+        resMap[pt] = rttr::test::randomValue(-2, 6);
+    // The non-const access invalidates the cached block maxima, so only read through this one
+    const AIJH::AIResourceMap& constResMap = resMap;
+
+    for(unsigned i = 0; i < 200; i++)
+    {
+        const MapPoint center(rttr::test::randomValue<MapCoord>(0, world.GetWidth() - 1),
+                              rttr::test::randomValue<MapCoord>(0, world.GetHeight() - 1));
+        // Include radii too big for the map
+        const int radius = rttr::test::randomValue(0, 35);
+        const bool inTerritory = rttr::test::randomValue(0, 1) == 1;
+        const BuildingQuality size = rttr::test::randomValue(0, 1) == 1 ? BQ_HUT : BQ_FLAG;
+        const int value = rttr::test::randomValue(-2, 6);
+
+        MapPoint expectedGood = MapPoint::Invalid();
+        MapPoint expectedBest = MapPoint::Invalid();
+        int bestValue = value - 1;
+        for(const MapPoint pt : world.GetPointsInRadiusWithCenter(center, radius))
+        {
+            if((inTerritory && !aiMap[pt].owned) || aiMap[pt].farmed || !canUseBq(aiMap[pt].bq, size))
+                continue;
+            if(!expectedGood.isValid() && constResMap[pt] >= value)
+                expectedGood = pt;
+            if(aiMap[pt].reachable && constResMap[pt] > bestValue)
+            {
+                expectedBest = pt;
+                bestValue = constResMap[pt];
+            }
+        }
+        BOOST_TEST_INFO("Center " << center << " radius " << radius << " value " << value);
+        BOOST_TEST(resMap.FindGoodPosition(center, value, size, radius, inTerritory) == expectedGood);
+        BOOST_TEST_INFO("Center " << center << " radius " << radius << " value " << value);
+        BOOST_TEST(resMap.FindBestPosition(center, size, value, radius, inTerritory) == expectedBest);
+
+        // Changes must be reflected by the next search
+        resMap.Change(center, rttr::test::randomValue(1u, 5u), rttr::test::randomValue(-1, 1));
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(ReachabilityUpdatedIncrementally, BiggerWorldWithGCExecution)
+{
+    AIJH::AIMap aiMap, expectedAIMap;
+    aiMap.Resize(world.GetSize());
+    expectedAIMap.Resize(world.GetSize());
+    AIJH::AIReachability reachability(world, curPlayer, aiMap);
+    reachability.Init();
+    std::vector<MapPoint> changedPts;
+    const Subscription sub = AIJH::recordBQsToUpdate(world, changedPts);
+    const auto assertReachabilityIsUpdated = [&](unsigned line) {
+        reachability.Update(changedPts);
+        changedPts.clear();
+        AIJH::AIReachability expectedReachability(world, curPlayer, expectedAIMap);
+        expectedReachability.Init();
+        RTTR_FOREACH_PT(MapPoint, world.GetSize())
+        {
+            BOOST_TEST_INFO("Line " << line << " at " << pt);
+            BOOST_TEST_REQUIRE(aiMap[pt].reachable == expectedAIMap[pt].reachable);
+        }
+    };
+
+    std::vector<MapPoint> possibleFlagNodes;
+    RTTR_FOREACH_PT(MapPoint, world.GetSize())
+    {
+        if(world.GetBQ(pt, curPlayer) != BQ_NOTHING && !world.IsFlagAround(pt))
+            possibleFlagNodes.push_back(pt);
+    }
+    for(unsigned i = 0; i < 10; i++)
+    {
+        const MapPoint flagPos = possibleFlagNodes[rttr::test::randomValue<unsigned>(0, possibleFlagNodes.size() - 1)];
+        this->SetFlag(flagPos);
+        assertReachabilityIsUpdated(__LINE__);
+        this->DestroyFlag(flagPos);
+        assertReachabilityIsUpdated(__LINE__);
+    }
+
+    // Roads block other roads
+    const MapPoint startPos = world.GetNeighbour(hqPos, Direction::SOUTHEAST);
+    const MapPoint flagPos = world.MakeMapPoint(startPos + Position(4, 0));
+    this->BuildRoad(startPos, false, std::vector<Direction>(4, Direction::EAST));
+    BOOST_REQUIRE(world.GetSpecObj<noFlag>(flagPos)->GetRoute(Direction::WEST));
+    assertReachabilityIsUpdated(__LINE__);
+    this->DestroyFlag(flagPos);
+    assertReachabilityIsUpdated(__LINE__);
+
+    // Failed nodes stay unreachable for some checks
+    const MapPoint failedPt = world.MakeMapPoint(hqPos + Position(3, 3));
+    BOOST_TEST_REQUIRE(aiMap[failedPt].reachable);
+    reachability.SetFailed(failedPt, 3);
+    BOOST_TEST(!aiMap[failedPt].reachable);
+    // SetFailed was the first check. Each further one counts only once although the node is reached from many sides
+    for(unsigned i = 0; i < 2; i++)
+    {
+        reachability.Update(std::vector<MapPoint>(1, failedPt));
+        BOOST_TEST(!aiMap[failedPt].reachable);
+    }
+    reachability.Update(std::vector<MapPoint>(1, failedPt));
+    BOOST_TEST(aiMap[failedPt].reachable);
+}
+
+BOOST_FIXTURE_TEST_CASE(AIsInitializedInParallel, WorldWithGCExecution<2>)
+{
+    for(unsigned id = 0; id < world.GetNumPlayers(); id++)
+        world.GetPlayer(id).aiInfo = AI::Info(AI::DEFAULT, AI::HARD);
+    const std::vector<std::unique_ptr<AIPlayer>> ais = AIFactory::Create(std::vector<unsigned>{0, 1}, world);
+    BOOST_TEST_REQUIRE(ais.size() == 2u);
+    for(unsigned id = 0; id < ais.size(); id++)
+    {
+        BOOST_TEST_REQUIRE(ais[id]->GetPlayerId() == id);
+        // Same as an AI initialized on its own
+        const auto expectedAI = AIFactory::Create(AI::Info(AI::DEFAULT, AI::HARD), id, world);
+        const auto& aijh = static_cast<const AIJH::AIPlayerJH&>(*ais[id]);
+        const auto& expectedAIJH = static_cast<const AIJH::AIPlayerJH&>(*expectedAI);
+        RTTR_FOREACH_PT(MapPoint, world.GetSize())
+        {
+            BOOST_TEST_INFO("Player " << id << " at " << pt);
+            BOOST_TEST_REQUIRE(aijh.GetAINode(pt).bq == expectedAIJH.GetAINode(pt).bq);
+            BOOST_TEST_REQUIRE(aijh.GetAINode(pt).owned == expectedAIJH.GetAINode(pt).owned);
+            BOOST_TEST_REQUIRE(aijh.GetAINode(pt).reachable == expectedAIJH.GetAINode(pt).reachable);
+            for(unsigned res = 0; res < NUM_AIRESOURCES; res++)
+            {
+                BOOST_TEST_REQUIRE(aijh.GetResMapValue(pt, AIResource(res))
+                                   == expectedAIJH.GetResMapValue(pt, AIResource(res)));
+            }
+        }
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(AIsShareKnowledge, WorldWithGCExecution<2>)
+{
+    for(unsigned id = 0; id < world.GetNumPlayers(); id++)
+        world.GetPlayer(id).aiInfo = AI::Info(AI::DEFAULT, AI::HARD);
+    const std::vector<std::unique_ptr<AIPlayer>> ais = AIFactory::Create(std::vector<unsigned>{0, 1}, world);
+    auto& ai0 = static_cast<AIJH::AIPlayerJH&>(*ais[0]);
+    auto& ai1 = static_cast<AIJH::AIPlayerJH&>(*ais[1]);
+    BOOST_TEST(&ai0.GetKnowledge() == &ai1.GetKnowledge());
+    const auto singleAI = AIFactory::Create(AI::Info(AI::DEFAULT, AI::HARD), 0, world);
+    BOOST_TEST(&static_cast<const AIJH::AIPlayerJH&>(*singleAI).GetKnowledge() != &ai0.GetKnowledge());
+
+    // Changes of player independent resources are seen by all AIs, the border land is per player
+    const MapPoint changedPt = world.MakeMapPoint(hqPos + Position(2, 2));
+    ai0.SetResourceMap(AIResource::WOOD, changedPt, 42);
+    BOOST_TEST(ai1.GetResMapValue(changedPt, AIResource::WOOD) == 42);
+    const int borderValue = ai1.GetResMapValue(changedPt, AIResource::BORDERLAND);
+    ai0.SetResourceMap(AIResource::BORDERLAND, changedPt, borderValue + 1);
+    BOOST_TEST(ai1.GetResMapValue(changedPt, AIResource::BORDERLAND) == borderValue);
+
+    // Plant space is removed only once
+    MapPoint plantPt = MapPoint::Invalid();
+    RTTR_FOREACH_PT(MapPoint, world.GetSize())
+    {
+        if(ai0.GetKnowledge().GetResource(pt) == AIResource::PLANTSPACE)
+        {
+            plantPt = pt;
+            break;
+        }
+    }
+    BOOST_TEST_REQUIRE(plantPt.isValid());
+    const int plantValue = ai0.GetResMapValue(plantPt, AIResource::PLANTSPACE);
+    ai0.RemovePlantSpace(plantPt);
+    ai1.RemovePlantSpace(plantPt);
+    BOOST_TEST((ai0.GetKnowledge().GetResource(plantPt) == AIResource::NOTHING));
+    BOOST_TEST(ai1.GetResMapValue(plantPt, AIResource::PLANTSPACE)
+               == plantValue - static_cast<int>(RES_RADIUS[static_cast<unsigned>(AIResource::PLANTSPACE)]));
+}
+
+BOOST_FIXTURE_TEST_CASE(AIRandomIsReproducible, WorldWithGCExecution<2>)
+{
+    const auto getRandValues = [](AIPlayer& ai) {
+        std::vector<unsigned> values;
+        for(unsigned i = 0; i < 20; i++)
+            values.push_back(ai.Rand(1000));
+        return values;
+    };
+    const unsigned rngChecksum = RANDOM.GetChecksum();
+    const auto ai = AIFactory::Create(AI::Info(AI::DEFAULT, AI::HARD), 0, world);
+    const auto sameAI = AIFactory::Create(AI::Info(AI::DEFAULT, AI::HARD), 0, world);
+    const auto otherAI = AIFactory::Create(AI::Info(AI::DEFAULT, AI::HARD), 1, world);
+    const std::vector<unsigned> values = getRandValues(*ai);
+    BOOST_TEST(getRandValues(*sameAI) == values, boost::test_tools::per_element());
+    BOOST_TEST((getRandValues(*otherAI) != values));
+    // The game RNG is neither used nor changed by the AIs
+    BOOST_TEST(RANDOM.GetChecksum() == rngChecksum);
+
+    std::vector<unsigned> shuffled(10), shuffledSame(10);
+    std::iota(shuffled.begin(), shuffled.end(), 0u);
+    std::iota(shuffledSame.begin(), shuffledSame.end(), 0u);
+    ai->Shuffle(shuffled);
+    sameAI->Shuffle(shuffledSame);
+    BOOST_TEST(shuffled == shuffledSame, boost::test_tools::per_element());
+    std::sort(shuffled.begin(), shuffled.end());
+    for(unsigned i = 0; i < shuffled.size(); i++)
+        BOOST_TEST(shuffled[i] == i);
+}
+
+BOOST_AUTO_TEST_CASE(TaskSchedulerKeepsBudget)
+{
+    AIJH::TaskScheduler scheduler(10);
+    std::vector<std::string> executed;
+    // Needs 25 operations
+    unsigned numOpsLeft = 25;
+    scheduler.Add("Long", [&](unsigned& budget) {
+        const unsigned numOps = std::min(budget, numOpsLeft);
+        numOpsLeft -= numOps;
+        budget -= numOps;
+        executed.push_back("Long");
+        return numOpsLeft == 0u;
+    });
+    BOOST_TEST(scheduler.AddUnique("Short", scheduler.MakeSingleStepTask(3, [&]() { executed.push_back("Short"); })));
+    BOOST_TEST(!scheduler.AddUnique("Short", scheduler.MakeSingleStepTask(3, [&]() {})));
+    BOOST_TEST(scheduler.IsQueued("Long"));
+    BOOST_TEST(scheduler.GetNumTasks() == 2u);
+
+    // The long task is resumed before the next one starts
+    scheduler.RunGF();
+    BOOST_TEST(numOpsLeft == 15u);
+    BOOST_TEST(executed == std::vector<std::string>({"Long"}));
+    scheduler.RunGF();
+    BOOST_TEST(numOpsLeft == 5u);
+    // Remaining budget is used for the next task
+    scheduler.RunGF();
+    BOOST_TEST(numOpsLeft == 0u);
+    BOOST_TEST(executed == std::vector<std::string>({"Long", "Long", "Long", "Short"}));
+    BOOST_TEST(scheduler.GetNumTasks() == 0u);
+
+    // Tasks doing nothing still count, so they are limited per GF
+    unsigned numCalls = 0;
+    for(unsigned i = 0; i < 15; i++)
+        scheduler.Add("Empty", scheduler.MakeSingleStepTask(0, [&]() { numCalls++; }));
+    scheduler.RunGF();
+    BOOST_TEST(numCalls == 10u);
+    scheduler.RunGF();
+    BOOST_TEST(numCalls == 15u);
+
+    // Single step tasks wait for a GF with enough budget left
+    executed.clear();
+    scheduler.Add("Medium", scheduler.MakeSingleStepTask(6, [&]() { executed.push_back("Medium"); }));
+    scheduler.Add("Medium2", scheduler.MakeSingleStepTask(6, [&]() { executed.push_back("Medium2"); }));
+    scheduler.Add("Huge", scheduler.MakeSingleStepTask(20, [&]() { executed.push_back("Huge"); }));
+    scheduler.Add("Small", scheduler.MakeSingleStepTask(1, [&]() { executed.push_back("Small"); }));
+    scheduler.RunGF();
+    BOOST_TEST(executed == std::vector<std::string>({"Medium"}));
+    // Tasks costing more than a GF run when nothing else was done in the GF and use up all of it
+    scheduler.RunGF();
+    BOOST_TEST(executed == std::vector<std::string>({"Medium", "Medium2"}));
+    scheduler.RunGF();
+    BOOST_TEST(executed == std::vector<std::string>({"Medium", "Medium2", "Huge"}));
+    scheduler.RunGF();
+    BOOST_TEST(executed == std::vector<std::string>({"Medium", "Medium2", "Huge", "Small"}));
+    BOOST_TEST(scheduler.GetNumTasks() == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(RegionEventsAreCoalesced)
+{
+    AIEventManager eventMgr;
+    const MapPoint pt(8, 8);
+    eventMgr.AddBuildingEvent(AIEvent::LostLand, pt, BLD_BARRACKS);
+    // Same region
+    eventMgr.AddBuildingEvent(AIEvent::LostLand, MapPoint(9, 10), BLD_GUARDHOUSE);
+    eventMgr.AddAIEvent(std::make_unique<AIEvent::Building>(AIEvent::LostLand, MapPoint(11, 11), BLD_BARRACKS));
+    // Other type or region
+    eventMgr.AddBuildingEvent(AIEvent::BuildingLost, pt, BLD_BARRACKS);
+    eventMgr.AddBuildingEvent(AIEvent::LostLand, MapPoint(12, 8), BLD_BARRACKS);
+    // Not a region event
+    eventMgr.AddBuildingEvent(AIEvent::BuildingFinished, pt, BLD_WOODCUTTER);
+    eventMgr.AddBuildingEvent(AIEvent::BuildingFinished, pt, BLD_WOODCUTTER);
+    BOOST_TEST(eventMgr.GetEventNum() == 5u);
+    BOOST_TEST(eventMgr.GetNumCoalescedEvents() == 2u);
+
+    // Order is kept
+    std::unique_ptr<AIEvent::Base> ev = eventMgr.GetEvent();
+    BOOST_TEST_REQUIRE(ev->GetType() == AIEvent::LostLand);
+    BOOST_TEST(checkedCast<AIEvent::Building*>(ev.get())->GetPos() == pt);
+    BOOST_TEST(checkedCast<AIEvent::Building*>(ev.get())->GetBuildingType() == BLD_BARRACKS);
+    // Region is free again once the event is taken
+    eventMgr.AddBuildingEvent(AIEvent::LostLand, MapPoint(9, 10), BLD_GUARDHOUSE);
+    BOOST_TEST(eventMgr.GetEventNum() == 5u);
+    const std::array<AIEvent::EventType, 5> expectedTypes = {AIEvent::BuildingLost, AIEvent::LostLand,
+                                                             AIEvent::BuildingFinished, AIEvent::BuildingFinished,
+                                                             AIEvent::LostLand};
+    for(AIEvent::EventType type : expectedTypes)
+    {
+        ev = eventMgr.GetEvent();
+        BOOST_TEST_REQUIRE(!!ev);
+        BOOST_TEST(ev->GetType() == type);
+    }
+    BOOST_TEST(!eventMgr.EventAvailable());
+    BOOST_TEST(!eventMgr.GetEvent());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,82 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "AIGameRunner.h"
+#include "worldFixtures/MapTestFixture.h"
+#include <boost/test/unit_test.hpp>
+#include <vector>
+
+namespace {
+struct AIGameRunnerFixture : GlMapTestFixture
+{
+    const std::vector<AI::Info> players;
+    AIGameRunnerFixture() : players(2, AI::Info(AI::DEFAULT, AI::HARD)) {}
+};
+
+std::vector<AIGameRunner::Sample> RunGame(const boost::filesystem::path& mapPath, const std::vector<AI::Info>& players,
+                                          unsigned seed)
+{
+    AIGameRunner runner;
+    BOOST_TEST_REQUIRE(runner.Load(mapPath, players, seed));
+    BOOST_TEST(runner.Run(500, 100) == 500u);
+    BOOST_TEST(runner.GetCurrentGF() == 500u);
+    BOOST_TEST(runner.GetWinnerMask() != 0u);
+    return runner.GetSamples();
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(AIGameRunnerSuite, AIGameRunnerFixture)
+
+BOOST_AUTO_TEST_CASE(InvalidGamesAreRejected)
+{
+    AIGameRunner runner;
+    BOOST_TEST(!runner.Load(testMapPath, std::vector<AI::Info>(), 1));
+    BOOST_TEST(!runner.GetLastErrorMsg().empty());
+    AIGameRunner runner2;
+    BOOST_TEST(!runner2.Load(testMapPath.parent_path() / "doesNotExist.swd", players, 1));
+    BOOST_TEST(!runner2.GetLastErrorMsg().empty());
+}
+
+BOOST_AUTO_TEST_CASE(StatisticsAreSampled)
+{
+    const std::vector<AIGameRunner::Sample> samples = RunGame(testMapPath, players, 42);
+    // GF 0, 100, ..., 500 for each player
+    BOOST_TEST_REQUIRE(samples.size() == 6u * players.size());
+    for(unsigned i = 0; i < samples.size(); i++)
+    {
+        BOOST_TEST(samples[i].gf == i / players.size() * 100u);
+        BOOST_TEST(samples[i].playerId == i % players.size());
+        BOOST_TEST(!samples[i].isDefeated);
+        BOOST_TEST(samples[i].country > 0u);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(GamesAreReproducible)
+{
+    const std::vector<AIGameRunner::Sample> samples = RunGame(testMapPath, players, 42);
+    const std::vector<AIGameRunner::Sample> samples2 = RunGame(testMapPath, players, 42);
+    BOOST_TEST_REQUIRE(samples.size() == samples2.size());
+    for(unsigned i = 0; i < samples.size(); i++)
+    {
+        BOOST_TEST(samples[i].country == samples2[i].country);
+        BOOST_TEST(samples[i].military == samples2[i].military);
+        BOOST_TEST(samples[i].productivity == samples2[i].productivity);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,77 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#include "BenchmarkScenarios.h"
+#include "BuildingRegister.h"
+#include "Game.h"
+#include "GamePlayer.h"
+#include "world/GameWorld.h"
+#include "gameTypes/GO_Type.h"
+#include <boost/test/unit_test.hpp>
+#include <stdexcept>
+
+BOOST_AUTO_TEST_SUITE(BenchmarkScenarios)
+
+BOOST_AUTO_TEST_CASE(ParseNames)
+{
+    const unsigned numDrawing = benchmarks::getDrawingNames().size();
+    const unsigned numSimulation = benchmarks::getSimulationNames().size();
+    BOOST_TEST(benchmarks::parseNames("all").size() == numDrawing + numSimulation);
+    BOOST_TEST(benchmarks::parseNames("draw") == benchmarks::getDrawingNames());
+    BOOST_TEST(benchmarks::parseNames("sim") == benchmarks::getSimulationNames());
+    const std::vector<std::string> expected{"text", "simFullGame"};
+    BOOST_TEST(benchmarks::parseNames("text,simFullGame") == expected);
+    BOOST_CHECK_THROW(benchmarks::parseNames("text,foo"), std::invalid_argument);
+    BOOST_TEST(benchmarks::isSimulation("simEmptyGame"));
+    BOOST_TEST(!benchmarks::isSimulation("emptyGame"));
+}
+
+BOOST_AUTO_TEST_CASE(GamesAreCreated)
+{
+    const auto emptyGame = benchmarks::createGame(benchmarks::GameScenario::Empty, 1000);
+    BOOST_TEST_REQUIRE(emptyGame);
+    BOOST_TEST(!emptyGame->world_.GetPlayer(0).GetHQPos().isValid());
+
+    const auto basicGame = benchmarks::createGame(benchmarks::GameScenario::Basic, 1000);
+    const auto fullGame = benchmarks::createGame(benchmarks::GameScenario::Full, 1000);
+    for(const auto& game : {basicGame, fullGame})
+    {
+        for(unsigned i = 0; i < game->world_.GetNumPlayers(); i++)
+        {
+            const MapPoint hqPos = game->world_.GetPlayer(i).GetHQPos();
+            BOOST_TEST_REQUIRE(hqPos.isValid());
+            BOOST_TEST(game->world_.GetNO(hqPos)->GetGOT() == GOT_NOB_HQ);
+        }
+    }
+    BOOST_TEST(basicGame->world_.GetPlayer(0).GetBuildingRegister().GetBuildings(BLD_MILL).empty());
+    BOOST_TEST(!fullGame->world_.GetPlayer(0).GetBuildingRegister().GetBuildings(BLD_MILL).empty());
+
+    BOOST_CHECK_THROW(benchmarks::createGame(benchmarks::GameScenario::Full, -1), std::invalid_argument);
+    BOOST_CHECK_THROW(benchmarks::createGame(benchmarks::GameScenario::Full, benchmarks::MAX_INSTANCES + 1),
+                      std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(SimulationRuns)
+{
+    const benchmarks::Result result = benchmarks::runSimulation("simFullGame", 500, 10);
+    BOOST_TEST(result.name == "simFullGame");
+    BOOST_TEST(result.numIterations == 10u);
+    BOOST_TEST(result.duration.count() > 0);
+    BOOST_CHECK_THROW(benchmarks::runSimulation("fullGame", 500, 10), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -16,6 +16,8 @@
 // along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
 
 #include "RttrForeachPt.h"
+#include "pathfinding/FreePathFinderImpl.h"
+#include "pathfinding/PathConditionHuman.h"
 #include "worldFixtures/CreateEmptyWorld.h"
 #include "worldFixtures/WorldFixture.h"
 #include "nodeObjs/noGranite.h"
@@ -25,6 +27,7 @@
 #include <rttr/test/testHelpers.hpp>
 #include <boost/range/adaptor/reversed.hpp>
 #include <boost/test/unit_test.hpp>
+#include <limits>
 #include <vector>
 
 // Tests are designed to check for every possible direction and terrain distribution
@@ -303,4 +306,43 @@ BOOST_FIXTURE_TEST_CASE(BlockedPaths, WorldFixtureEmpty0P)
     BOOST_REQUIRE(world.FindHumanPath(startPt, surroundingPts2[0]));
 }
 
+BOOST_FIXTURE_TEST_CASE(PathLengthsToMultipleTargets, WorldFixtureEmpty0P)
+{
+    const MapPoint startPt(3, 6);
+    const MapPoint enclosedPt(7, 7);
+    // Enclose one point completely and block all but one exit of the start
+    for(const MapPoint& pt : world.GetPointsInRadius(enclosedPt, 1))
+        world.SetNO(pt, new noGranite(GT_1, 1));
+    std::vector<MapPoint> surroundingPts = world.GetPointsInRadius(startPt, 1);
+    for(const MapPoint& pt : surroundingPts)
+        world.SetNO(pt, new noGranite(GT_1, 1));
+    world.DestroyNO(surroundingPts[0]);
+
+    std::vector<MapPoint> targets;
+    for(unsigned i = 0; i < 12; i++)
+        targets.push_back(world.GetNeighbour2(startPt, i));
+    targets.push_back(MapPoint(7, 2));
+    targets.push_back(targets.front());
+    targets.push_back(startPt);
+    targets.push_back(enclosedPt);
+    const std::vector<unsigned> lengths =
+      world.GetFreePathFinder().FindPathLengths(startPt, targets, 99, PathConditionHuman(world));
+    BOOST_TEST_REQUIRE(lengths.size() == targets.size());
+    // Same lengths as with a search per target
+    for(unsigned i = 0; i + 3 < targets.size(); i++)
+    {
+        unsigned length;
+        BOOST_TEST_REQUIRE(!!world.FindHumanPath(startPt, targets[i], 99, false, &length));
+        BOOST_TEST(lengths[i] == length);
+    }
+    BOOST_TEST(lengths[targets.size() - 3] == lengths.front());
+    BOOST_TEST(lengths[targets.size() - 2] == 0u);
+    BOOST_TEST(lengths.back() == std::numeric_limits<unsigned>::max());
+    // Too far away
+    const std::vector<unsigned> shortLengths =
+      world.GetFreePathFinder().FindPathLengths(startPt, targets, 2, PathConditionHuman(world));
+    BOOST_TEST(shortLengths.front() == 2u);
+    BOOST_TEST(shortLengths[6] == std::numeric_limits<unsigned>::max());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
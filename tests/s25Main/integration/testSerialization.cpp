@@ -41,6 +41,7 @@
 #include <rttr/test/testHelpers.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/test/unit_test.hpp>
+#include <cstring>
 #include <memory>
 
 // LCOV_EXCL_START
@@ -202,6 +203,47 @@ BOOST_AUTO_TEST_CASE(Serializer)
     BOOST_TEST_REQUIRE(sgd.PopVarSize() == 0xFFFFFFFFu);
 }
 
+BOOST_AUTO_TEST_CASE(CompactGameCommands)
+{
+    // Empty NWF, e.g. of an AI
+    PlayerGameCommands emptyCmds;
+    Serializer ser;
+    emptyCmds.Serialize(ser);
+    BOOST_TEST(ser.GetLength() == 1u);
+    GetTestCommands readCmds;
+    readCmds.SetFlag(MapPoint(1, 2));
+    readCmds.result.checksum.objCt = 42;
+    readCmds.result.Deserialize(ser);
+    BOOST_TEST(ser.GetBytesLeft() == 0u);
+    BOOST_TEST(readCmds.result.checksum == AsyncChecksum());
+    BOOST_TEST(readCmds.result.gcs.empty());
+
+    GetTestCommands testCmds;
+    testCmds.result.checksum = AsyncChecksum(0xDEADBEEF, 12345, 67890, 1234, 567890);
+    testCmds.SetFlag(MapPoint(40, 50));
+    testCmds.BuildRoad(MapPoint(40, 50), false, {Direction::WEST, Direction::NORTHWEST, Direction::NORTHEAST});
+    testCmds.ChangeDistribution(Distributions{});
+    // Large jump back
+    testCmds.SetBuildingSite(MapPoint(2, 1), BLD_WOODCUTTER);
+    testCmds.SetCoinsAllowed(MapPoint(1000, 1000), false);
+    testCmds.SetFlag(MapPoint(0, 0));
+    ser.Clear();
+    testCmds.result.Serialize(ser);
+    Serializer fullSer;
+    testCmds.result.SerializeFullWidth(fullSer);
+    BOOST_TEST(ser.GetLength() < fullSer.GetLength());
+
+    PlayerGameCommands readCmds2;
+    readCmds2.Deserialize(ser);
+    BOOST_TEST(ser.GetBytesLeft() == 0u);
+    BOOST_TEST(readCmds2.checksum == testCmds.result.checksum);
+    // Commands must be exactly the same
+    Serializer fullSer2;
+    readCmds2.SerializeFullWidth(fullSer2);
+    BOOST_TEST_REQUIRE(fullSer2.GetLength() == fullSer.GetLength());
+    BOOST_TEST(memcmp(fullSer2.GetData(), fullSer.GetData(), fullSer.GetLength()) == 0);
+}
+
 BOOST_FIXTURE_TEST_CASE(BaseSaveLoad, RandWorldFixture)
 {
     const MapPoint hqPos = world.GetPlayer(0).GetHQPos();
@@ -555,4 +597,159 @@ BOOST_FIXTURE_TEST_CASE(ReplayWithSavegame, RandWorldFixture)
     }
 }
 
+BOOST_AUTO_TEST_CASE(ReplayIsConsistentWhileRecording)
+{
+    MapInfo map;
+    map.type = MAPTYPE_OLDMAP;
+    map.title = "MapTitle";
+    map.filepath = "Map.swd";
+    map.mapData.data = std::vector<char>(42, 0x42);
+    map.mapData.length = 50;
+    std::vector<PlayerInfo> players(2);
+    players[0].ps = PS_OCCUPIED;
+    players[0].name = "Human";
+    players[1].ps = PS_AI;
+    players[1].name = "PlAI";
+
+    Replay replay;
+    for(const BasePlayerInfo& player : players)
+        replay.AddPlayer(player);
+
+    TmpFile tmpFile;
+    BOOST_TEST_REQUIRE(tmpFile.isValid());
+    tmpFile.close();
+    bfs::remove(tmpFile.filePath);
+    BOOST_TEST_REQUIRE(replay.StartRecording(tmpFile.filePath, map));
+
+    GlobalGameSettings ggs;
+    Game game(ggs, 0u, players);
+    PlayerGameCommands cmds = GetTestCommands().create(game).result;
+    AddReplayCmds(replay, cmds);
+    // Commands of the next (unfinished) GF must not be visible yet
+    replay.AddChatCommand(6, 1, 0, "Unfinished");
+    replay.Flush(true);
+    BOOST_TEST_REQUIRE(replay.IsRecording());
+
+    // Simulate a crash: Read the file while it is still being recorded
+    {
+        Replay loadReplay;
+        BOOST_TEST_REQUIRE(loadReplay.LoadHeader(tmpFile.filePath, true));
+        BOOST_TEST_REQUIRE(loadReplay.GetLastGF() == 5u);
+        MapInfo newMap;
+        BOOST_TEST_REQUIRE(loadReplay.LoadGameData(newMap));
+        CheckReplayCmds(loadReplay, cmds);
+    }
+
+    replay.UpdateLastGF(6);
+    replay.StopRecording();
+    Replay loadReplay;
+    BOOST_TEST_REQUIRE(loadReplay.LoadHeader(tmpFile.filePath, true));
+    BOOST_TEST_REQUIRE(loadReplay.GetLastGF() == 6u);
+}
+
+BOOST_FIXTURE_TEST_CASE(ReplayWithKeyframes, RandWorldFixture)
+{
+    MapInfo map;
+    map.type = MAPTYPE_OLDMAP;
+    map.title = "MapTitle";
+    map.filepath = "Map.swd";
+    map.mapData.data = std::vector<char>(42, 0x42);
+    map.mapData.length = 50;
+
+    Replay replay;
+    for(unsigned i = 0; i < world.GetNumPlayers(); i++)
+        replay.AddPlayer(world.GetPlayer(i));
+
+    TmpFile tmpFile;
+    BOOST_TEST_REQUIRE(tmpFile.isValid());
+    tmpFile.close();
+    bfs::remove(tmpFile.filePath);
+    BOOST_TEST_REQUIRE(replay.StartRecording(tmpFile.filePath, map));
+
+    SerializedGameData sgd;
+    sgd.MakeSnapshot(game);
+    const UsedPRNG rng1(rttr::test::randomValue<uint64_t>(1));
+    const UsedPRNG rng2(rttr::test::randomValue<uint64_t>(1));
+
+    PlayerGameCommands cmds = GetTestCommands().create(*game).result;
+    AddReplayCmds(replay, cmds);
+    replay.AddKeyframe(6, rng1, sgd);
+    replay.AddChatCommand(6, 1, 0, "AfterKeyframe");
+    replay.UpdateLastGF(6);
+    replay.AddKeyframe(8, rng2, sgd);
+    replay.UpdateLastGF(8);
+    replay.Flush(true);
+
+    const auto checkReplay = [&]() {
+        Replay loadReplay;
+        BOOST_TEST_REQUIRE(loadReplay.LoadHeader(tmpFile.filePath, true));
+        MapInfo newMap;
+        BOOST_TEST_REQUIRE(loadReplay.LoadGameData(newMap));
+        BOOST_TEST_REQUIRE(loadReplay.GetKeyframes().size() == 2u);
+        BOOST_TEST(!loadReplay.FindKeyframe(5));
+        BOOST_TEST_REQUIRE(loadReplay.FindKeyframe(6));
+        BOOST_TEST(loadReplay.FindKeyframe(6)->gf == 6u);
+        BOOST_TEST(loadReplay.FindKeyframe(7)->gf == 6u);
+        BOOST_TEST(loadReplay.FindKeyframe(100)->gf == 8u);
+
+        // All commands are indexed, including the keyframes
+        const std::vector<ReplayCommandInfo>& commands = loadReplay.GetCommands();
+        BOOST_TEST_REQUIRE(commands.size() == 8u);
+        BOOST_TEST(commands.front().gf == 1u);
+        BOOST_TEST(commands[3].type == ReplayCommand::Game);
+        BOOST_TEST(commands[5].type == ReplayCommand::Keyframe);
+        BOOST_TEST(commands[5].filePos == loadReplay.GetKeyframes().front().filePos);
+        BOOST_TEST(commands[6].type == ReplayCommand::Chat);
+        BOOST_TEST(commands.back().gf == 8u);
+        BOOST_TEST(commands.back().filePos == loadReplay.GetKeyframes().back().filePos);
+
+        // Loading a keyframe continues with the commands after it
+        UsedPRNG rng;
+        SerializedGameData loadSgd;
+        BOOST_TEST_REQUIRE(loadReplay.ReadKeyframe(*loadReplay.FindKeyframe(6), rng, loadSgd));
+        BOOST_TEST(rng == rng1);
+        BOOST_REQUIRE_EQUAL_COLLECTIONS(loadSgd.GetData(), loadSgd.GetData() + loadSgd.GetLength(), sgd.GetData(),
+                                        sgd.GetData() + sgd.GetLength());
+        unsigned gf;
+        BOOST_TEST_REQUIRE(loadReplay.ReadGF(&gf));
+        BOOST_TEST(gf == 6u);
+        BOOST_TEST_REQUIRE(loadReplay.ReadRCType() == ReplayCommand::Chat);
+        uint8_t player, dst;
+        std::string txt;
+        loadReplay.ReadChatCommand(player, dst, txt);
+        BOOST_TEST(txt == "AfterKeyframe");
+
+        BOOST_TEST_REQUIRE(loadReplay.ReadKeyframe(loadReplay.GetKeyframes().back(), rng, loadSgd));
+        BOOST_TEST(rng == rng2);
+        BOOST_TEST(!loadReplay.ReadGF(&gf));
+
+        // Keyframes are skipped when just reading the commands
+        Replay readReplay;
+        BOOST_TEST_REQUIRE(readReplay.LoadHeader(tmpFile.filePath, true));
+        BOOST_TEST_REQUIRE(readReplay.LoadGameData(newMap));
+        unsigned numKeyframes = 0;
+        while(readReplay.ReadGF(&gf))
+        {
+            const ReplayCommand rc = readReplay.ReadRCType();
+            if(rc == ReplayCommand::Chat)
+                readReplay.ReadChatCommand(player, dst, txt);
+            else if(rc == ReplayCommand::Game)
+            {
+                PlayerGameCommands readCmds;
+                readReplay.ReadGameCommand(player, readCmds);
+            } else
+            {
+                BOOST_TEST_REQUIRE(rc == ReplayCommand::Keyframe);
+                readReplay.SkipKeyframe();
+                numKeyframes++;
+            }
+        }
+        BOOST_TEST(numKeyframes == 2u);
+    };
+    // Without index (e.g. after a crash) the keyframes are found by scanning the commands
+    checkReplay();
+    replay.StopRecording();
+    checkReplay();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -19,12 +19,11 @@
 #include "FileChecksum.h"
 #include "GamePlayer.h"
 #include "PointOutput.h"
-#include "RttrConfig.h"
 #include "RttrForeachPt.h"
-#include "files.h"
 #include "lua/GameDataLoader.h"
 #include "ogl/glArchivItem_Map.h"
 #include "worldFixtures/CreateEmptyWorld.h"
+#include "worldFixtures/MapTestFixture.h"
 #include "worldFixtures/WorldFixture.h"
 #include "world/MapLoader.h"
 #include "nodeObjs/noBase.h"
@@ -34,12 +33,6 @@
 #include <boost/test/unit_test.hpp>
 #include <vector>
 
-struct MapTestFixture
-{
-    const boost::filesystem::path testMapPath;
-    MapTestFixture() : testMapPath(RTTRCONFIG.ExpandPath(s25::folders::mapsRttr) / "Bergruft.swd") {}
-};
-
 BOOST_FIXTURE_TEST_SUITE(MapTestSuite, MapTestFixture)
 
 BOOST_AUTO_TEST_CASE(LoadSaveMap)
@@ -0,0 +1,122 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#include "RTTR_Version.h"
+#include "Replay.h"
+#include "network/CreateServerInfo.h"
+#include "network/GameMessage_GameCommand.h"
+#include "network/GameMessages.h"
+#include "network/GameServer.h"
+#include "worldFixtures/MapTestFixture.h"
+#include "gameTypes/CompressedData.h"
+#include "s25util/MessageHandler.h"
+#include "s25util/Socket.h"
+#include "s25util/SocketSet.h"
+#include <boost/filesystem/operations.hpp>
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace {
+/// Run the server till the condition is true or a timeout occurs. Everything sent to the spectator is appended
+template<class T_Cond>
+bool RunServer(GameServer& server, Socket& spectator, std::vector<uint8_t>& spectatorData, T_Cond&& condition)
+{
+    for(unsigned i = 0; i < 500; i++)
+    {
+        server.Run();
+        SocketSet set;
+        set.Add(spectator);
+        if(spectator.isValid() && set.Select(0, 0) > 0)
+        {
+            char buffer[4096];
+            const int numReceived = spectator.Recv(buffer, sizeof(buffer), false);
+            if(numReceived > 0)
+                spectatorData.insert(spectatorData.end(), buffer, buffer + numReceived);
+            else
+                spectator.Close();
+        }
+        if(condition())
+            return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+uint32_t GetUnsignedInt(const std::vector<uint8_t>& data, size_t pos)
+{
+    return static_cast<uint32_t>(data[pos]) | (static_cast<uint32_t>(data[pos + 1]) << 8)
+           | (static_cast<uint32_t>(data[pos + 2]) << 16) | (static_cast<uint32_t>(data[pos + 3]) << 24);
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(GameServerSuite, GlMapTestFixture)
+
+BOOST_AUTO_TEST_CASE(SpectatorsGetTheEndOfTheGame)
+{
+    GameServer server;
+    BOOST_TEST_REQUIRE(server.Start(CreateServerInfo(ServerType::DIRECT, 1341, "TestGame"), testMapPath,
+                                    MAPTYPE_OLDMAP, "hostPw"));
+    BOOST_TEST_REQUIRE(server.StartSpectatorRelay(1342, std::chrono::milliseconds::zero()));
+    unsigned mapChecksum;
+    CompressedData mapData;
+    BOOST_TEST_REQUIRE(mapData.CompressFromFile(testMapPath, &mapChecksum));
+    unsigned luaChecksum = 0;
+    const boost::filesystem::path luaPath = boost::filesystem::path(testMapPath).replace_extension("lua");
+    CompressedData luaData;
+    if(boost::filesystem::is_regular_file(luaPath))
+        BOOST_TEST_REQUIRE(luaData.CompressFromFile(luaPath, &luaChecksum));
+
+    std::vector<uint8_t> spectatorData;
+    Socket spectator;
+    BOOST_TEST_REQUIRE(spectator.Connect("localhost", 1342, false));
+
+    // Join as the host in the first slot and start the game alone
+    Socket host;
+    BOOST_TEST_REQUIRE(host.Connect("localhost", 1341, false));
+    constexpr uint8_t playerId = 0;
+    MessageHandler::send(host, GameMessage_Server_Type(ServerType::DIRECT, RTTR_Version::GetRevision()));
+    MessageHandler::send(host, GameMessage_Server_Password("hostPw"));
+    MessageHandler::send(host, GameMessage_Map_Checksum(mapChecksum, luaChecksum));
+    for(uint8_t i = 1; i < 8; i++)
+        MessageHandler::send(host, GameMessage_Player_State(i, PS_LOCKED, AI::Info()));
+    MessageHandler::send(host, GameMessage_Player_Ready(playerId, true));
+    MessageHandler::send(host, GameMessage_Countdown(0));
+    // Header is sent as soon as the game starts
+    BOOST_TEST_REQUIRE(RunServer(server, spectator, spectatorData, [&]() { return !spectatorData.empty(); }));
+    // Commands for the first NWF finish the loading
+    MessageHandler::send(host, GameMessage_GameCommand(playerId, AsyncChecksum(), {}));
+    for(unsigned i = 0; i < 10; i++)
+        server.Run();
+    BOOST_TEST_REQUIRE(server.IsRunning());
+
+    // Last player leaves -> Game is over but the spectator gets everything before the relay is closed
+    host.Close();
+    BOOST_TEST_REQUIRE(RunServer(server, spectator, spectatorData, [&]() { return !server.IsRunning(); }));
+    BOOST_TEST_REQUIRE(RunServer(server, spectator, spectatorData, [&]() { return !spectator.isValid(); }));
+    BOOST_TEST(!server.IsFlushingSpectatorStream());
+
+    BOOST_TEST_REQUIRE(spectatorData.size() >= 8u);
+    const unsigned headerSize = GetUnsignedInt(spectatorData, 0);
+    BOOST_TEST_REQUIRE(spectatorData.size() >= 8u + headerSize + 5u);
+    BOOST_TEST(GetUnsignedInt(spectatorData, spectatorData.size() - 5) == Replay::END_GF);
+    BOOST_TEST(spectatorData.back() == static_cast<uint8_t>(ReplayCommand::End));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,117 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#include "network/SocketPoller.h"
+#include "s25util/Socket.h"
+#include "s25util/SocketSet.h"
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+
+BOOST_AUTO_TEST_CASE(SocketPollerReportsOnlyReadySockets)
+{
+    using std::chrono::milliseconds;
+    Socket serverSocket;
+    BOOST_TEST_REQUIRE(serverSocket.Listen(1339, false, false));
+    Socket clientSocket1, clientSocket2;
+    BOOST_TEST_REQUIRE(clientSocket1.Connect("localhost", 1339, false));
+    BOOST_TEST_REQUIRE(clientSocket2.Connect("localhost", 1339, false));
+    Socket acceptedSockets[2];
+    for(Socket& acceptedSocket : acceptedSockets)
+    {
+        SocketSet set;
+        set.Add(serverSocket);
+        BOOST_TEST_REQUIRE(set.Select(10 * 1000, 0) > 0);
+        acceptedSocket = serverSocket.Accept();
+        BOOST_TEST_REQUIRE(acceptedSocket.isValid());
+    }
+
+    SocketPoller poller;
+    poller.Add(acceptedSockets[0], 3);
+    poller.Add(acceptedSockets[1], 5);
+    // Nothing to read and no write interest
+    BOOST_TEST(poller.Wait(milliseconds::zero()).empty());
+
+    const char data[] = "Hello";
+    BOOST_TEST_REQUIRE(clientSocket2.Send(data, sizeof(data)) == static_cast<int>(sizeof(data)));
+    const auto& events = poller.Wait(milliseconds(10 * 1000));
+    BOOST_TEST_REQUIRE(events.size() == 1u);
+    BOOST_TEST(events[0].id == 5u);
+    BOOST_TEST(events[0].readable);
+    BOOST_TEST(!events[0].writable);
+    BOOST_TEST(!events[0].error);
+
+    // Data is reported till it is read. Ids are reported after a swap
+    poller.SwapIds(3, 5);
+    poller.SetWriteInterest(5, true);
+    BOOST_TEST(poller.HasWriteInterest(5));
+    BOOST_TEST(!poller.HasWriteInterest(3));
+    const auto& events2 = poller.Wait(milliseconds::zero());
+    BOOST_TEST_REQUIRE(events2.size() == 2u);
+    for(const SocketPoller::Event& event : events2)
+    {
+        // Socket 5 was socket 3 and is writable, socket 3 was socket 5 and has data
+        BOOST_TEST(event.readable == (event.id == 3u));
+        BOOST_TEST(event.writable == (event.id == 5u));
+    }
+
+    poller.Remove(3);
+    poller.SetWriteInterest(5, false);
+    BOOST_TEST(poller.Wait(milliseconds::zero()).empty());
+    poller.Clear();
+    BOOST_TEST(!poller.HasWriteInterest(5));
+}
+
+BOOST_AUTO_TEST_CASE(SocketPollerWatchesOtherPollers)
+{
+    using std::chrono::milliseconds;
+    Socket serverSocket;
+    BOOST_TEST_REQUIRE(serverSocket.Listen(1341, false, false));
+    Socket clientSocket;
+    BOOST_TEST_REQUIRE(clientSocket.Connect("localhost", 1341, false));
+    SocketSet set;
+    set.Add(serverSocket);
+    BOOST_TEST_REQUIRE(set.Select(10 * 1000, 0) > 0);
+    Socket acceptedSocket = serverSocket.Accept();
+    BOOST_TEST_REQUIRE(acceptedSocket.isValid());
+
+    SocketPoller innerPoller, outerPoller;
+    innerPoller.Add(acceptedSocket, 1);
+    outerPoller.AddPoller(innerPoller, 7);
+    BOOST_TEST(outerPoller.Wait(milliseconds::zero()).empty());
+
+    // Waiting for write space wakes the outer poller too
+    innerPoller.SetWriteInterest(1, true);
+    const auto& events = outerPoller.Wait(milliseconds(10 * 1000));
+    BOOST_TEST_REQUIRE(events.size() == 1u);
+    BOOST_TEST(events[0].id == 7u);
+    BOOST_TEST(events[0].readable);
+    innerPoller.SetWriteInterest(1, false);
+    BOOST_TEST(outerPoller.Wait(milliseconds::zero()).empty());
+
+    const char data[] = "Hello";
+    BOOST_TEST_REQUIRE(clientSocket.Send(data, sizeof(data)) == static_cast<int>(sizeof(data)));
+    const auto& events2 = outerPoller.Wait(milliseconds(10 * 1000));
+    BOOST_TEST_REQUIRE(events2.size() == 1u);
+    BOOST_TEST(events2[0].id == 7u);
+    // The inner poller still reports the socket itself
+    const auto& innerEvents = innerPoller.Wait(milliseconds::zero());
+    BOOST_TEST_REQUIRE(innerEvents.size() == 1u);
+    BOOST_TEST(innerEvents[0].id == 1u);
+
+    outerPoller.Remove(7);
+    BOOST_TEST(outerPoller.Wait(milliseconds::zero()).empty());
+}
@@ -0,0 +1,117 @@
+// Copyright (c) 2005 - 2020 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#include "Replay.h"
+#include "network/PlayerGameCommands.h"
+#include "network/SpectatorRelay.h"
+#include "gameTypes/MapInfo.h"
+#include "s25util/Socket.h"
+#include "s25util/SocketSet.h"
+#include <rttr/test/MockClock.hpp>
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace {
+uint32_t GetUnsignedInt(const std::vector<uint8_t>& data, size_t pos)
+{
+    return static_cast<uint32_t>(data[pos]) | (static_cast<uint32_t>(data[pos + 1]) << 8)
+           | (static_cast<uint32_t>(data[pos + 2]) << 16) | (static_cast<uint32_t>(data[pos + 3]) << 24);
+}
+
+/// Run the relay and return everything the spectator receives
+std::vector<uint8_t> Receive(SpectatorRelay& relay, Socket& socket)
+{
+    std::vector<uint8_t> data;
+    for(unsigned i = 0; i < 20; i++)
+    {
+        relay.Run();
+        SocketSet set;
+        set.Add(socket);
+        if(set.Select(10, 0) <= 0)
+            continue;
+        char buffer[4096];
+        const int numReceived = socket.Recv(buffer, sizeof(buffer), false);
+        if(numReceived <= 0)
+            break;
+        data.insert(data.end(), buffer, buffer + numReceived);
+    }
+    return data;
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_CASE(SpectatorsGetDelayedCommands, rttr::test::MockClockFixture)
+{
+    using std::chrono::milliseconds;
+    SpectatorRelay relay;
+    BOOST_TEST_REQUIRE(relay.Start(1340, false));
+    Replay replay;
+    MapInfo mapInfo;
+    mapInfo.type = MAPTYPE_OLDMAP;
+    mapInfo.title = "TestMap";
+    mapInfo.mapData.data.resize(10, 42);
+    mapInfo.mapData.length = 20;
+    BOOST_TEST_REQUIRE(relay.StartStream(replay, mapInfo, milliseconds(1000)));
+    BOOST_TEST_REQUIRE(relay.IsStreaming());
+    // Commands added before a spectator connects are sent too
+    relay.AddGameCommand(5, 1, PlayerGameCommands());
+
+    Socket spectator;
+    BOOST_TEST_REQUIRE(spectator.Connect("localhost", 1340, false));
+    // Only the header is sent before the delay has passed
+    currentTime += milliseconds(999);
+    const std::vector<uint8_t> header = Receive(relay, spectator);
+    BOOST_TEST_REQUIRE(relay.GetNumSpectators() == 1u);
+    BOOST_TEST_REQUIRE(header.size() >= 8u);
+    const unsigned headerSize = GetUnsignedInt(header, 0);
+    BOOST_TEST(header.size() == 8u + headerSize);
+    const unsigned lastGFFilePos = GetUnsignedInt(header, 4);
+    BOOST_TEST_REQUIRE(lastGFFilePos + 4u <= headerSize);
+    // Last GF is not yet known
+    BOOST_TEST(GetUnsignedInt(header, 8 + lastGFFilePos) == 0u);
+
+    // GF, type, size and data of the command
+    currentTime += milliseconds(1);
+    const std::vector<uint8_t> cmd = Receive(relay, spectator);
+    BOOST_TEST_REQUIRE(cmd.size() >= 9u);
+    BOOST_TEST(GetUnsignedInt(cmd, 0) == 5u);
+    BOOST_TEST(cmd[4] == static_cast<uint8_t>(ReplayCommand::Game));
+    BOOST_TEST(cmd.size() == 9u + GetUnsignedInt(cmd, 5));
+    BOOST_TEST(cmd[9] == 1u);
+
+    // The end is sent regardless of the delay
+    relay.AddGameCommand(20, 0, PlayerGameCommands());
+    relay.EndStream();
+    // No new spectators after the end
+    BOOST_TEST(!relay.IsRunning());
+    const std::vector<uint8_t> end = Receive(relay, spectator);
+    BOOST_TEST_REQUIRE(end.size() > 5u);
+    BOOST_TEST(GetUnsignedInt(end, 0) == 20u);
+    BOOST_TEST(GetUnsignedInt(end, end.size() - 5) == Replay::END_GF);
+    BOOST_TEST(end.back() == static_cast<uint8_t>(ReplayCommand::End));
+    BOOST_TEST(relay.IsFlushed());
+
+    spectator.Close();
+    for(unsigned i = 0; i < 100 && relay.GetNumSpectators() > 0u; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        relay.Run();
+    }
+    BOOST_TEST(relay.GetNumSpectators() == 0u);
+}
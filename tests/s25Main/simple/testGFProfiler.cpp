@@ -0,0 +1,99 @@
+// Copyright (c) 2016 - 2017 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#include "GFProfiler.h"
+#include <rttr/test/TmpFolder.hpp>
+#include <boost/nowide/fstream.hpp>
+#include <boost/test/unit_test.hpp>
+#include <helpers/chronoIO.h>
+#include <string>
+#include <thread>
+
+namespace {
+struct ProfilerFixture
+{
+    ProfilerFixture() { GFPROFILER.SetEnabled(true); }
+    ~ProfilerFixture() { GFPROFILER.SetEnabled(false); }
+};
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(GFProfilerSuite)
+
+BOOST_AUTO_TEST_CASE(DisabledRecordsNothing)
+{
+    BOOST_TEST_REQUIRE(!GFPROFILER.IsEnabled());
+    GFPROFILER.StartGF(1);
+    BOOST_TEST(!GFPROFILER.IsRecording());
+    {
+        GFProfiler::ScopedTimer timer(GFProfiler::GetSlot(GFProfiler::Section::Lua));
+    }
+    GFPROFILER.EndGF();
+    BOOST_TEST(GFPROFILER.GetNumMeasuredGFs() == 0u);
+}
+
+BOOST_FIXTURE_TEST_CASE(NestedTimersGetSelfTime, ProfilerFixture)
+{
+    using std::chrono::milliseconds;
+    const unsigned outerSlot = GFProfiler::GetAISlot(1);
+    const unsigned innerSlot = GFProfiler::GetSlot(GFProfiler::Section::Pathfinding);
+    GFPROFILER.StartGF(42);
+    BOOST_TEST(GFPROFILER.IsRecording());
+    {
+        GFProfiler::ScopedTimer outer(outerSlot);
+        GFProfiler::ScopedTimer inner(innerSlot);
+        std::this_thread::sleep_for(milliseconds(5));
+    }
+    GFPROFILER.EndGF();
+    BOOST_TEST(!GFPROFILER.IsRecording());
+
+    BOOST_TEST_REQUIRE(GFPROFILER.GetRecordedGFs().size() == 1u);
+    const GFProfiler::GFTimes& times = GFPROFILER.GetRecordedGFs().front();
+    BOOST_TEST(times.gf == 42u);
+    BOOST_TEST(times.slots[innerSlot] >= milliseconds(5));
+    BOOST_TEST(times.slots[outerSlot] < times.slots[innerSlot]);
+    BOOST_TEST(times.slots[outerSlot] + times.slots[innerSlot] <= times.total);
+    BOOST_TEST(GFPROFILER.GetSlowestGF().gf == 42u);
+    BOOST_TEST(GFPROFILER.GetAverage(10).gf == 1u);
+}
+
+BOOST_FIXTURE_TEST_CASE(SlotNamesAndCSV, ProfilerFixture)
+{
+    BOOST_TEST(GFProfiler::GetSlotName(GFProfiler::GetSlot(GFProfiler::Section::Events)) == "Events");
+    BOOST_TEST(GFProfiler::GetSlotName(GFProfiler::GetSlot(GOT_TREE)) == "Events/Tree");
+    BOOST_TEST(GFProfiler::GetSlotName(GFProfiler::GetSlot(GOT_ECONOMYMODEHANDLER)) == "Events/EconomyModeHandler");
+    BOOST_TEST(GFProfiler::GetSlotName(GFProfiler::GetAISlot(3)) == "AI/3");
+
+    for(unsigned gf = 1; gf <= 3; gf++)
+    {
+        GFPROFILER.StartGF(gf);
+        GFPROFILER.EndGF();
+    }
+    rttr::test::TmpFolder tmp;
+    const boost::filesystem::path csvPath = tmp.get() / "profile.csv";
+    BOOST_TEST_REQUIRE(GFPROFILER.WriteCSV(csvPath));
+    boost::nowide::ifstream file(csvPath);
+    std::string line;
+    BOOST_TEST_REQUIRE(!!std::getline(file, line));
+    BOOST_TEST(line.substr(0, 16) == "gf,total,Events,");
+    unsigned numLines = 0;
+    while(std::getline(file, line))
+        numLines++;
+    BOOST_TEST(numLines == 3u);
+    BOOST_TEST_REQUIRE(GFPROFILER.WriteJSON(tmp.get() / "profile.json"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,72 @@
+// Copyright (c) 2016 - 2017 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#include "TraceRecorder.h"
+#include <rttr/test/TmpFolder.hpp>
+#include <boost/nowide/fstream.hpp>
+#include <boost/test/unit_test.hpp>
+#include <sstream>
+#include <string>
+#include <thread>
+
+BOOST_AUTO_TEST_SUITE(TraceRecorderSuite)
+
+BOOST_AUTO_TEST_CASE(RecordsScopesOfAllThreads)
+{
+    {
+        // Nothing recorded while not running
+        TraceRecorder::Scope scope("NotRecorded");
+    }
+    TRACERECORDER.Start();
+    BOOST_TEST(TRACERECORDER.IsRecording());
+    {
+        TraceRecorder::Scope outer("Outer");
+        TraceRecorder::Scope inner("Inner");
+    }
+    std::thread thread([]() {
+        TRACERECORDER.SetThreadName("Worker");
+        TraceRecorder::Scope scope("InThread");
+    });
+    thread.join();
+    TRACERECORDER.Stop();
+    {
+        TraceRecorder::Scope scope("AfterStop");
+    }
+    BOOST_TEST(TRACERECORDER.GetNumEvents() == 3u);
+    BOOST_TEST(TRACERECORDER.GetNumDroppedEvents() == 0u);
+
+    rttr::test::TmpFolder tmp;
+    const boost::filesystem::path tracePath = tmp.get() / "trace.json";
+    BOOST_TEST_REQUIRE(TRACERECORDER.Write(tracePath));
+    boost::nowide::ifstream file(tracePath);
+    std::stringstream content;
+    content << file.rdbuf();
+    const std::string trace = content.str();
+    BOOST_TEST(trace.find("\"traceEvents\"") != std::string::npos);
+    BOOST_TEST(trace.find("\"Outer\"") != std::string::npos);
+    BOOST_TEST(trace.find("\"Inner\"") != std::string::npos);
+    BOOST_TEST(trace.find("\"InThread\"") != std::string::npos);
+    BOOST_TEST(trace.find("\"Main\"") != std::string::npos);
+    BOOST_TEST(trace.find("\"Worker\"") != std::string::npos);
+    BOOST_TEST(trace.find("NotRecorded") == std::string::npos);
+    BOOST_TEST(trace.find("AfterStop") == std::string::npos);
+    // Main thread and worker thread
+    BOOST_TEST(trace.find("\"tid\": 0") != std::string::npos);
+    BOOST_TEST(trace.find("\"tid\": 1") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
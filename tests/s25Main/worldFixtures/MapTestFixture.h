@@ -0,0 +1,38 @@
+// Copyright (c) 2016 - 2017 Settlers Freaks (sf-team at siedler25.org)
+//
+// This file is part of Return To The Roots.
+//
+// Return To The Roots is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Return To The Roots is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Return To The Roots. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "RttrConfig.h"
+#include "files.h"
+#include "ogl/glAllocator.h"
+#include "libsiedler2/libsiedler2.h"
+#include <boost/filesystem/path.hpp>
+
+/// Provides the path to a map usable in tests
+struct MapTestFixture
+{
+    const boost::filesystem::path testMapPath;
+    MapTestFixture() : testMapPath(RTTRCONFIG.ExpandPath(s25::folders::mapsRttr) / "Bergruft.swd") {}
+};
+
+/// Additionally loads maps as glArchivItem_Map (as the game does) while it exists
+struct GlMapTestFixture : MapTestFixture
+{
+    GlMapTestFixture() { libsiedler2::setAllocator(new GlAllocator); }
+    ~GlMapTestFixture() { libsiedler2::setAllocator(nullptr); }
+};